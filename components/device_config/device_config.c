@@ -0,0 +1,214 @@
+#include <string.h>
+#include <strings.h>
+#include "device_config.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "nvs.h"
+#include "cJSON.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "DEVICE_CONFIG";
+
+#define CONFIG_NAMESPACE    "devcfg"
+#define CONFIG_BLOB_KEY     "blob"
+#define CONFIG_BLOB_MAGIC   0x43464731      // "CFG1"
+#define CONFIG_BLOB_LAYOUT  1               // Incrementar al cambiar device_config_t
+#define CONFIG_BODY_MAX_LEN 512
+
+// Blob en NVS: encabezado + estructura, se lee directamente sobre `config_blob`
+typedef struct {
+    uint32_t magic;
+    uint16_t layout;
+    uint16_t size;
+    device_config_t config;
+} config_blob_t;
+
+static config_blob_t config_blob = {
+    .magic = CONFIG_BLOB_MAGIC,
+    .layout = CONFIG_BLOB_LAYOUT,
+    .size = sizeof(device_config_t),
+    .config = {
+        .version = 0,
+        .device_id = CONFIG_DEVICE_CONFIG_DEVICE_ID,
+        .medicion_intervalo_ms = 60000,     // 1 minuto
+        .retry_delay_ms = 1000,
+        .wifi_max_retries = 10,
+        .dht_gpio = CONFIG_DEVICE_CONFIG_DHT_GPIO,
+        .dht_type = 1,                      // DHT_TYPE_AM2301
+        .http_timeout_ms = CONFIG_HTTP_POST_TIMEOUT,
+        .http_retries = CONFIG_HTTP_POST_RETRIES,
+        .http_retry_delay_ms = CONFIG_HTTP_POST_RETRY_DELAY,
+        .etag = "",
+    },
+};
+
+static char etag_recibido[DEVICE_CONFIG_ETAG_LEN];
+static char body[CONFIG_BODY_MAX_LEN + 1];
+
+
+const device_config_t *device_config_get(void) {
+    return &config_blob.config;
+}
+
+esp_err_t device_config_load(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CONFIG_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "Sin configuración cacheada, usando valores por defecto.");
+        return err;
+    }
+
+    static config_blob_t cached;
+    size_t len = sizeof(cached);
+    err = nvs_get_blob(handle, CONFIG_BLOB_KEY, &cached, &len);
+    nvs_close(handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "Sin configuración cacheada, usando valores por defecto.");
+        return err;
+    }
+
+    if (len != sizeof(cached) || cached.magic != CONFIG_BLOB_MAGIC ||
+        cached.layout != CONFIG_BLOB_LAYOUT || cached.size != sizeof(device_config_t)) {
+        ESP_LOGW(TAG, "Configuración cacheada con formato distinto, se ignora.");
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    cached.config.device_id[DEVICE_CONFIG_ID_LEN - 1] = '\0';
+    cached.config.etag[DEVICE_CONFIG_ETAG_LEN - 1] = '\0';
+    config_blob = cached;
+    ESP_LOGI(TAG, "Configuración v%lu cargada desde NVS.", config_blob.config.version);
+    return ESP_OK;
+}
+
+static esp_err_t guardar_blob(void) {
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(CONFIG_NAMESPACE, NVS_READWRITE, &handle);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(handle, CONFIG_BLOB_KEY, &config_blob, sizeof(config_blob));
+        if (err == ESP_OK) {
+            err = nvs_commit(handle);
+        }
+        nvs_close(handle);
+    }
+    return err;
+}
+
+// Copia un entero del JSON si existe y está dentro del rango permitido
+static void leer_entero(const cJSON *root, const char *key, int32_t min, int32_t max, void *dest, size_t size) {
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(root, key);
+    if (!cJSON_IsNumber(item)) {
+        return;
+    }
+    if (item->valuedouble < min || item->valuedouble > max) {
+        ESP_LOGW(TAG, "Valor fuera de rango para %s: %d", key, item->valueint);
+        return;
+    }
+
+    switch (size) {
+        case sizeof(uint8_t):  *(uint8_t *)dest = item->valueint; break;
+        case sizeof(uint16_t): *(uint16_t *)dest = item->valueint; break;
+        default:               *(uint32_t *)dest = item->valueint; break;
+    }
+}
+
+#define LEER_ENTERO(root, key, min, max, field) \
+    leer_entero(root, key, min, max, &(field), sizeof(field))
+
+static bool aplicar_json(const char *json, device_config_t *cfg) {
+    cJSON *root = cJSON_Parse(json);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "Configuración remota inválida.");
+        return false;
+    }
+
+    const cJSON *id = cJSON_GetObjectItemCaseSensitive(root, "device_id");
+    if (cJSON_IsString(id) && strlen(id->valuestring) < DEVICE_CONFIG_ID_LEN) {
+        strcpy(cfg->device_id, id->valuestring);
+    }
+
+    LEER_ENTERO(root, "version", 0, INT32_MAX, cfg->version);
+    LEER_ENTERO(root, "medicion_intervalo_ms", 5000, 24 * 3600 * 1000, cfg->medicion_intervalo_ms);
+    LEER_ENTERO(root, "retry_delay_ms", 100, 10000, cfg->retry_delay_ms);
+    LEER_ENTERO(root, "wifi_max_retries", 1, 100, cfg->wifi_max_retries);
+    LEER_ENTERO(root, "dht_gpio", 0, 39, cfg->dht_gpio);
+    LEER_ENTERO(root, "dht_type", 0, 2, cfg->dht_type);
+    LEER_ENTERO(root, "http_timeout_ms", 1000, 30000, cfg->http_timeout_ms);
+    LEER_ENTERO(root, "http_retries", 1, 10, cfg->http_retries);
+    LEER_ENTERO(root, "http_retry_delay_ms", 100, 10000, cfg->http_retry_delay_ms);
+
+    cJSON_Delete(root);
+    return true;
+}
+
+static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && strcasecmp(evt->header_key, "ETag") == 0) {
+        strncpy(etag_recibido, evt->header_value, sizeof(etag_recibido) - 1);
+        etag_recibido[sizeof(etag_recibido) - 1] = '\0';
+    }
+    return ESP_OK;
+}
+
+esp_err_t device_config_sync(void) {
+    if (strlen(CONFIG_DEVICE_CONFIG_URL) == 0) {
+        return ESP_OK;
+    }
+
+    esp_http_client_config_t http_cfg = {
+        .url = CONFIG_DEVICE_CONFIG_URL,
+        .timeout_ms = config_blob.config.http_timeout_ms,
+        .method = HTTP_METHOD_GET,
+        .event_handler = http_event_handler,
+        .crt_bundle_attach = esp_crt_bundle_attach
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&http_cfg);
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    if (config_blob.config.etag[0] != '\0') {
+        esp_http_client_set_header(client, "If-None-Match", config_blob.config.etag);
+    }
+
+    etag_recibido[0] = '\0';
+    esp_err_t err = esp_http_client_open(client, 0);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error consultando configuración: %s", esp_err_to_name(err));
+        esp_http_client_cleanup(client);
+        return err;
+    }
+
+    esp_http_client_fetch_headers(client);
+    int status_code = esp_http_client_get_status_code(client);
+
+    if (status_code == 304) {
+        ESP_LOGI(TAG, "Configuración v%lu vigente (304).", config_blob.config.version);
+    } else if (status_code == 200) {
+        int len = esp_http_client_read_response(client, body, CONFIG_BODY_MAX_LEN);
+        if (len > 0 && esp_http_client_is_complete_data_received(client)) {
+            body[len] = '\0';
+            device_config_t nueva = config_blob.config;
+            if (aplicar_json(body, &nueva)) {
+                strcpy(nueva.etag, etag_recibido);
+                config_blob.config = nueva;
+                err = guardar_blob();
+                ESP_LOGI(TAG, "Configuración v%lu aplicada y guardada: %s",
+                         nueva.version, esp_err_to_name(err));
+            } else {
+                err = ESP_ERR_INVALID_RESPONSE;
+            }
+        } else {
+            ESP_LOGE(TAG, "Configuración remota incompleta o mayor a %d bytes.", CONFIG_BODY_MAX_LEN);
+            err = ESP_ERR_INVALID_SIZE;
+        }
+    } else {
+        ESP_LOGW(TAG, "Respuesta inesperada al consultar configuración: %d", status_code);
+        err = ESP_ERR_INVALID_RESPONSE;
+    }
+
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return err;
+}
@@ -0,0 +1,36 @@
+#ifndef DEVICE_CONFIG_H
+#define DEVICE_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#define DEVICE_CONFIG_ID_LEN    24
+#define DEVICE_CONFIG_ETAG_LEN  48
+
+// Parámetros de ejecución ajustables desde el servidor sin reflashear.
+// Se guarda tal cual como un único blob en NVS.
+typedef struct {
+    uint32_t version;                   // Versión asignada por el servidor
+    char device_id[DEVICE_CONFIG_ID_LEN];
+    uint32_t medicion_intervalo_ms;
+    uint32_t retry_delay_ms;
+    uint16_t wifi_max_retries;
+    int8_t dht_gpio;
+    uint8_t dht_type;                   // dht_sensor_type_t
+    uint32_t http_timeout_ms;
+    uint16_t http_retries;
+    uint32_t http_retry_delay_ms;
+    char etag[DEVICE_CONFIG_ETAG_LEN];  // ETag de la última descarga
+} device_config_t;
+
+// Carga el blob cacheado en NVS (o los valores por defecto). No reserva memoria.
+esp_err_t device_config_load(void);
+
+// Consulta el servidor con If-None-Match y guarda la nueva versión si cambió
+esp_err_t device_config_sync(void);
+
+// Configuración vigente (siempre válida, aun antes de device_config_load)
+const device_config_t *device_config_get(void);
+
+#endif // DEVICE_CONFIG_H
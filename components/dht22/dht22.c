@@ -1,22 +1,160 @@
+#include <math.h>
 #include <stdbool.h>
+#include <string.h>
+#include <sys/time.h>
 #include "dht22.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "driver/gpio.h"
 #include "dht.h"
+#include "device_config.h"
+#include "dht22_filter.h"
 
 static const char *TAG = "DHT22";
 
+#define DHT22_CACHE_MAGIC 0x44485432    // "DHT2"
+
+// Última lectura válida. RTC_NOINIT sobrevive al deep sleep y a resets que no
+// cortan la alimentación (brownout, watchdog, software).
+typedef struct {
+    uint32_t magic;
+    float temperature;
+    float humidity;
+    uint8_t confidence;
+    int64_t read_time_us;   // Hora del sistema (el RTC sigue contando en deep sleep)
+    uint32_t check;
+} dht22_cache_t;
+
+static RTC_NOINIT_ATTR dht22_cache_t dht22_cache;
+
+
+static int64_t dht22_now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static uint32_t dht22_cache_checksum(const dht22_cache_t *cache) {
+    uint32_t t, h;
+    memcpy(&t, &cache->temperature, sizeof(t));
+    memcpy(&h, &cache->humidity, sizeof(h));
+    return cache->magic ^ t ^ (h << 1) ^ cache->confidence ^
+           (uint32_t)cache->read_time_us ^ (uint32_t)(cache->read_time_us >> 32);
+}
+
+static bool dht22_cache_valid(void) {
+    return dht22_cache.magic == DHT22_CACHE_MAGIC && dht22_cache.check == dht22_cache_checksum(&dht22_cache);
+}
+
+static void dht22_cache_store(float temperature, float humidity, uint8_t confidence) {
+    dht22_cache.magic = DHT22_CACHE_MAGIC;
+    dht22_cache.temperature = temperature;
+    dht22_cache.humidity = humidity;
+    dht22_cache.confidence = confidence;
+    dht22_cache.read_time_us = dht22_now_us();
+    dht22_cache.check = dht22_cache_checksum(&dht22_cache);
+}
+
+// Lectura cacheada aún dentro del intervalo mínimo del sensor
+static bool dht22_cache_fresh(void) {
+    if (!dht22_cache_valid()) {
+        return false;
+    }
+    int64_t age = dht22_now_us() - dht22_cache.read_time_us;
+    return age >= 0 && age < DHT22_MIN_INTERVAL_MS * 1000LL;
+}
 
 void dht22_init() {
     ESP_LOGI(TAG, "Inicializando DHT22...");
-    gpio_set_pull_mode(DHT_GPIO, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode(device_config_get()->dht_gpio, GPIO_PULLUP_ONLY);
 }
 
-bool dht22_read(float *temperature, float *humidity) {
-    if (dht_read_float_data(SENSOR_TYPE, DHT_GPIO, humidity, temperature) == ESP_OK) {
+bool dht22_settle_required(void) {
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT) {
+        return !dht22_cache_fresh();
+    }
+    // Sin corte de alimentación el sensor ya está estabilizado
+    return !dht22_cache_valid();
+}
+
+static bool dht22_cache_serve(float *temperature, float *humidity, uint8_t *confidence) {
+    if (!dht22_cache_fresh()) {
+        return false;
+    }
+    *temperature = dht22_cache.temperature;
+    *humidity = dht22_cache.humidity;
+    if (confidence) *confidence = dht22_cache.confidence;
+    ESP_LOGI(TAG, "Usando lectura cacheada de hace %lld ms",
+             (dht22_now_us() - dht22_cache.read_time_us) / 1000);
+    return true;
+}
+
+static bool dht22_read_raw(float *temperature, float *humidity) {
+    const device_config_t *cfg = device_config_get();
+    if (dht_read_float_data(cfg->dht_type, cfg->dht_gpio, humidity, temperature) == ESP_OK) {
         return true;
     } else {
         ESP_LOGW(TAG, "Error al leer el sensor DHT22");
         return false;
     }
-}
\ No newline at end of file
+}
+
+bool dht22_read(float *temperature, float *humidity) {
+    if (dht22_cache_serve(temperature, humidity, NULL)) {
+        return true;
+    }
+
+    if (dht22_read_raw(temperature, humidity)) {
+        dht22_cache_store(*temperature, *humidity, 100);
+        return true;
+    }
+    return false;
+}
+
+bool dht22_read_burst(size_t samples, float *temperature, float *humidity, uint8_t *confidence) {
+    if (dht22_cache_serve(temperature, humidity, confidence)) {
+        return true;
+    }
+
+    if (samples <= 1) {
+        *confidence = 0;
+        if (!dht22_read_raw(temperature, humidity)) {
+            return false;
+        }
+        *confidence = 100;
+        dht22_cache_store(*temperature, *humidity, *confidence);
+        return true;
+    }
+    if (samples > DHT22_FILTER_MAX_SAMPLES) {
+        samples = DHT22_FILTER_MAX_SAMPLES;
+    }
+
+    float temps[DHT22_FILTER_MAX_SAMPLES];
+    float hums[DHT22_FILTER_MAX_SAMPLES];
+    for (size_t i = 0; i < samples; i++) {
+        if (i > 0) {
+            vTaskDelay(pdMS_TO_TICKS(DHT22_MIN_INTERVAL_MS));
+        }
+        if (!dht22_read_raw(&temps[i], &hums[i])) {
+            temps[i] = NAN;
+            hums[i] = NAN;
+        }
+    }
+
+    uint8_t conf_t, conf_h;
+    if (!dht22_filter_hampel(temps, samples, temperature, &conf_t) ||
+        !dht22_filter_hampel(hums, samples, humidity, &conf_h)) {
+        *confidence = 0;
+        return false;
+    }
+
+    *confidence = conf_t < conf_h ? conf_t : conf_h;
+    ESP_LOGI(TAG, "Ráfaga de %u lecturas: Temp = %.2f°C, Humedad = %.2f%%, confianza %u%%",
+             (unsigned int)samples, *temperature, *humidity, *confidence);
+    dht22_cache_store(*temperature, *humidity, *confidence);
+    return true;
+}
@@ -1,12 +1,27 @@
 #ifndef DHT22_H
 #define DHT22_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-#define SENSOR_TYPE DHT_TYPE_AM2301
-#define DHT_GPIO GPIO_NUM_21
+// GPIO y tipo de sensor: device_config_get()->dht_gpio / dht_type
+
+// Intervalo mínimo entre lecturas del DHT22
+#define DHT22_MIN_INTERVAL_MS 2000
 
 void dht22_init(void);
+
+// Indica si hace falta esperar a que el sensor se estabilice tras alimentarlo.
+// Falso si la alimentación se mantuvo desde la última lectura.
+bool dht22_settle_required(void);
+
+// Lee el sensor, o devuelve la última lectura si fue hace menos de DHT22_MIN_INTERVAL_MS
 bool dht22_read(float *temperature, float *humidity);
 
-#endif // DHT22_H
\ No newline at end of file
+// Lee `samples` veces separadas por DHT22_MIN_INTERVAL_MS y filtra los valores
+// atípicos (ver dht22_filter.h). `confidence` es el % de lecturas aceptadas.
+// Con samples <= 1 equivale a dht22_read().
+bool dht22_read_burst(size_t samples, float *temperature, float *humidity, uint8_t *confidence);
+
+#endif // DHT22_H
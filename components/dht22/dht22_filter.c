@@ -0,0 +1,74 @@
+#include <math.h>
+#include "dht22_filter.h"
+
+// Copia las muestras válidas ordenadas (inserción: K es pequeño)
+static size_t sorted_valid(const float *samples, size_t count, float *out) {
+    size_t n = 0;
+    for (size_t i = 0; i < count && n < DHT22_FILTER_MAX_SAMPLES; i++) {
+        float v = samples[i];
+        if (isnan(v)) continue;
+
+        size_t j = n++;
+        while (j > 0 && out[j - 1] > v) {
+            out[j] = out[j - 1];
+            j--;
+        }
+        out[j] = v;
+    }
+    return n;
+}
+
+static float median_sorted(const float *sorted, size_t n) {
+    return (n & 1) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) * 0.5f;
+}
+
+bool dht22_filter_median(const float *samples, size_t count, float *result) {
+    float sorted[DHT22_FILTER_MAX_SAMPLES];
+    size_t n = sorted_valid(samples, count, sorted);
+    if (n == 0) {
+        return false;
+    }
+    *result = median_sorted(sorted, n);
+    return true;
+}
+
+bool dht22_filter_hampel(const float *samples, size_t count, float *result, uint8_t *confidence) {
+    float sorted[DHT22_FILTER_MAX_SAMPLES];
+    size_t n = sorted_valid(samples, count, sorted);
+    if (n == 0) {
+        if (confidence) *confidence = 0;
+        return false;
+    }
+
+    float median = median_sorted(sorted, n);
+
+    // MAD: mediana de las desviaciones absolutas
+    float deviations[DHT22_FILTER_MAX_SAMPLES];
+    for (size_t i = 0; i < n; i++) {
+        deviations[i] = fabsf(sorted[i] - median);
+    }
+    float sorted_dev[DHT22_FILTER_MAX_SAMPLES];
+    sorted_valid(deviations, n, sorted_dev);
+    float mad = median_sorted(sorted_dev, n);
+
+    float threshold = DHT22_FILTER_HAMPEL_K * 1.4826f * mad;
+    if (threshold < DHT22_FILTER_MIN_SPREAD) {
+        threshold = DHT22_FILTER_MIN_SPREAD;
+    }
+
+    float sum = 0.0f;
+    size_t accepted = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (deviations[i] <= threshold) {
+            sum += sorted[i];
+            accepted++;
+        }
+    }
+
+    // La mediana siempre cae dentro del umbral, así que accepted >= 1
+    *result = sum / accepted;
+    if (confidence) {
+        *confidence = (uint8_t)((accepted * 100) / (count > n ? count : n));
+    }
+    return true;
+}
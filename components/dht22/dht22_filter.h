@@ -0,0 +1,33 @@
+#ifndef DHT22_FILTER_H
+#define DHT22_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Sin dependencias de ESP-IDF: se puede compilar y probar en el host.
+
+#define DHT22_FILTER_MAX_SAMPLES 9
+
+// Umbral de Hampel en desviaciones estándar estimadas (k * 1.4826 * MAD)
+#define DHT22_FILTER_HAMPEL_K 3.0f
+
+// Desviación mínima tolerada: resolución del DHT22 (0.1) con margen
+#define DHT22_FILTER_MIN_SPREAD 0.2f
+
+/**
+ * Filtro de Hampel sobre una ráfaga de muestras.
+ *
+ * Las muestras NAN representan lecturas fallidas. Se descartan las que se alejan
+ * de la mediana más de DHT22_FILTER_HAMPEL_K * 1.4826 * MAD y se promedian las
+ * restantes.
+ *
+ * `confidence` (0-100) es el porcentaje de muestras de la ráfaga que se aceptaron.
+ * Devuelve false si no hay ninguna muestra válida.
+ */
+bool dht22_filter_hampel(const float *samples, size_t count, float *result, uint8_t *confidence);
+
+// Mediana de las muestras válidas (ignora NAN). Devuelve false si no hay ninguna.
+bool dht22_filter_median(const float *samples, size_t count, float *result);
+
+#endif // DHT22_FILTER_H
@@ -242,14 +242,19 @@ typedef struct
                                               ((bit << bitname##_SHIFT) & bitname##_BITS) )
 #define bme_get_reg_bit(byte, bitname)      ( (byte & bitname##_BITS) >> bitname##_SHIFT )
 
+// Control registers changed only by host, except mode bits of CTRL_MEAS
+static const uint8_t shadow_regs[] = {
+    BME680_REG_CTRL_GAS_1, BME680_REG_CTRL_HUM, BME680_REG_CTRL_MEAS, BME680_REG_CONFIG
+};
+
 static inline esp_err_t read_reg_8_nolock(bme680_t *dev, uint8_t reg, uint8_t *data)
 {
-    return i2c_dev_read_reg(&dev->i2c_dev, reg, data, 1);
+    return i2c_dev_read_reg_cached(&dev->i2c_dev, reg, data, 1);
 }
 
 static inline esp_err_t write_reg_8_nolock(bme680_t *dev, uint8_t reg, uint8_t data)
 {
-    return i2c_dev_write_reg(&dev->i2c_dev, reg, &data, 1);
+    return i2c_dev_write_reg_cached(&dev->i2c_dev, reg, &data, 1);
 }
 
 static esp_err_t read_reg_8(bme680_t *dev, uint8_t reg, uint8_t *data)
@@ -269,6 +274,8 @@ static esp_err_t bme680_set_mode(bme680_t *dev, uint8_t mode)
     I2C_DEV_CHECK(&dev->i2c_dev, read_reg_8_nolock(dev, BME680_REG_CTRL_MEAS, &reg));
     reg = bme_set_reg_bit(reg, BME680_MODE, mode);
     I2C_DEV_CHECK(&dev->i2c_dev, write_reg_8_nolock(dev, BME680_REG_CTRL_MEAS, reg));
+    // sensor returns to sleep mode by itself after the forced measurement
+    i2c_dev_shadow_set(&dev->i2c_dev, BME680_REG_CTRL_MEAS, bme_set_reg_bit(reg, BME680_MODE, BME680_SLEEP_MODE));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
@@ -571,7 +578,9 @@ esp_err_t bme680_init_desc(bme680_t *dev, uint8_t addr, i2c_port_t port, gpio_nu
     dev->i2c_dev.cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
-    return i2c_dev_create_mutex(&dev->i2c_dev);
+    CHECK(i2c_dev_create_mutex(&dev->i2c_dev));
+
+    return i2c_dev_shadow_init(&dev->i2c_dev, shadow_regs, sizeof(shadow_regs));
 }
 
 esp_err_t bme680_free_desc(bme680_t *dev)
@@ -601,6 +610,7 @@ esp_err_t bme680_init_sensor(bme680_t *dev)
     // reset the sensor
     I2C_DEV_CHECK(&dev->i2c_dev, write_reg_8_nolock(dev, BME680_REG_RESET, BME680_RESET_CMD));
     vTaskDelay(pdMS_TO_TICKS(BME680_RESET_PERIOD));
+    i2c_dev_shadow_invalidate(&dev->i2c_dev);
 
     uint8_t chip_id = 0;
     I2C_DEV_CHECK(&dev->i2c_dev, read_reg_8_nolock(dev, BME680_REG_ID, &chip_id));
@@ -613,9 +623,14 @@ esp_err_t bme680_init_sensor(bme680_t *dev)
 
     uint8_t buf[BME680_CDM_SIZE];
 
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD1_ADDR, buf + BME680_CDM_OFF1, BME680_REG_CD1_LEN));
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD2_ADDR, buf + BME680_CDM_OFF2, BME680_REG_CD2_LEN));
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, BME680_REG_CD3_ADDR, buf + BME680_CDM_OFF3, BME680_REG_CD3_LEN));
+    // read all three calibration blocks in one transaction
+    uint8_t cd_regs[] = { BME680_REG_CD1_ADDR, BME680_REG_CD2_ADDR, BME680_REG_CD3_ADDR };
+    i2c_dev_segment_t cd_segs[] = {
+        I2C_DEV_SEG_WRITE(&cd_regs[0], 1), I2C_DEV_SEG_READ(buf + BME680_CDM_OFF1, BME680_REG_CD1_LEN),
+        I2C_DEV_SEG_WRITE(&cd_regs[1], 1), I2C_DEV_SEG_READ(buf + BME680_CDM_OFF2, BME680_REG_CD2_LEN),
+        I2C_DEV_SEG_WRITE(&cd_regs[2], 1), I2C_DEV_SEG_READ(buf + BME680_CDM_OFF3, BME680_REG_CD3_LEN),
+    };
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_transfer(&dev->i2c_dev, cd_segs, sizeof(cd_segs) / sizeof(cd_segs[0])));
 
     dev->calib_data.par_t1 = lsb_msb_to_type(uint16_t, buf, BME680_CDM_T1);
     dev->calib_data.par_t2 = lsb_msb_to_type(int16_t, buf, BME680_CDM_T2);
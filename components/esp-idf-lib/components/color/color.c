@@ -23,8 +23,21 @@
 
 #include "color.h"
 #include <math.h>
+#include <string.h>
 #include <lib8tion.h>
 
+////////////////////////////////////////////////////////////////////////////////
+// Word-wise kernels: four 8-bit channels are processed in one 32-bit word.
+// Results are bit-exact with scale8().
+
+// scale8() of four channels
+static inline uint32_t scale8_x4(uint32_t w, uint8_t scale)
+{
+    uint32_t k = (uint32_t)scale + 1;
+    return ((((w & 0x00ff00ff) * k) >> 8) & 0x00ff00ff)
+           | ((((w >> 8) & 0x00ff00ff) * k) & 0xff00ff00);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define APPLY_DIMMING(X) (X)
@@ -351,6 +364,105 @@ rgb_t hsv2rgb_rainbow(hsv_t hsv)
 
 #define FIXFRAC8(N,D) (((N) * 256) / (D))
 
+// Hue of color with at least one zero channel, scaled up to full brightness
+static inline uint8_t approximate_hue(uint8_t r, uint8_t g, uint8_t b)
+{
+    uint8_t h;
+
+    // since this wasn't a pure shade of gray,
+    // the interesting question is what hue is it
+
+    // start with which channel is highest
+    // (ties don't matter)
+    uint8_t highest = r;
+    if (g > highest) highest = g;
+    if (b > highest) highest = b;
+
+    if (highest == r)
+    {
+        // Red is highest.
+        // Hue could be Purple/Pink-Red,Red-Orange,Orange-Yellow
+        if (g == 0)
+        {
+            // if green is zero, we're in Purple/Pink-Red
+            h = (HUE_PURPLE + HUE_PINK) / 2;
+            h += scale8(qsub8(r, 128), FIXFRAC8(48, 128));
+        }
+        else if ((r - g) > g)
+        {
+            // if R-G > G then we're in Red-Orange
+            h = HUE_RED;
+            h += scale8(g, FIXFRAC8(32, 85));
+        }
+        else
+        {
+            // R-G < G, we're in Orange-Yellow
+            h = HUE_ORANGE;
+            h += scale8(qsub8((g - 85) + (171 - r), 4), FIXFRAC8(32, 85)); //221
+        }
+
+    }
+    else if (highest == g)
+    {
+        // Green is highest
+        // Hue could be Yellow-Green, Green-Aqua
+        if (b == 0)
+        {
+            // if Blue is zero, we're in Yellow-Green
+            //   G = 171..255
+            //   R = 171..  0
+            h = HUE_YELLOW;
+            uint8_t radj = scale8(qsub8(171, r), 47); //171..0 -> 0..171 -> 0..31
+            uint8_t gadj = scale8(qsub8(g, 171), 96); //171..255 -> 0..84 -> 0..31;
+            uint8_t rgadj = radj + gadj;
+            uint8_t hueadv = rgadj / 2;
+            h += hueadv;
+            //h += scale8( qadd8( 4, qadd8((g - 128), (128 - r))),
+            //             FIXFRAC8(32,255)); //
+        }
+        else
+        {
+            // if Blue is nonzero we're in Green-Aqua
+            if ((g - b) > b)
+            {
+                h = HUE_GREEN;
+                h += scale8(b, FIXFRAC8(32, 85));
+            }
+            else
+            {
+                h = HUE_AQUA;
+                h += scale8(qsub8(b, 85), FIXFRAC8(8, 42));
+            }
+        }
+
+    }
+    else /* highest == b */
+    {
+        // Blue is highest
+        // Hue could be Aqua/Blue-Blue, Blue-Purple, Purple-Pink
+        if (r == 0)
+        {
+            // if red is zero, we're in Aqua/Blue-Blue
+            h = HUE_AQUA + ((HUE_BLUE - HUE_AQUA) / 4);
+            h += scale8(qsub8(b, 128), FIXFRAC8(24, 128));
+        }
+        else if ((b - r) > r)
+        {
+            // B-R > R, we're in Blue-Purple
+            h = HUE_BLUE;
+            h += scale8(r, FIXFRAC8(32, 85));
+        }
+        else
+        {
+            // B-R < R, we're in Purple-Pink
+            h = HUE_PURPLE;
+            h += scale8(qsub8(r, 85), FIXFRAC8(32, 85));
+        }
+    }
+
+    return h + 1;
+}
+
 // This function is only an approximation, and it is not
 // nearly as fast as the normal HSV-to-RGB conversion.
 // See extended notes in the .h file.
@@ -359,7 +471,7 @@ hsv_t rgb2hsv_approximate(rgb_t rgb)
     uint8_t r = rgb.r;
     uint8_t g = rgb.g;
     uint8_t b = rgb.b;
-    uint8_t h, s, v;
+    uint8_t s, v;
 
     // find desaturation
     uint8_t desat = 255;
@@ -431,100 +543,105 @@ hsv_t rgb2hsv_approximate(rgb_t rgb)
         // if( v != 255) v = (256.0 * sqrt( (float)(v) / 256.0));
     }
 
-    // since this wasn't a pure shade of gray,
-    // the interesting question is what hue is it
+    return hsv_from_values(approximate_hue(r, g, b), s, v);
+}
 
-    // start with which channel is highest
-    // (ties don't matter)
-    uint8_t highest = r;
-    if (g > highest) highest = g;
-    if (b > highest) highest = b;
+////////////////////////////////////////////////////////////////////////////////
+// Batch conversions, bit-exact with hsv2rgb_rainbow() and rgb2hsv_approximate()
+
+static uint32_t rainbow_lut[256]; // Fully saturated bright rainbow colors, 0x00bbggrr
+static uint8_t desat_lut[256];    // Brightness floor for saturation
+static uint8_t dim_lut[256];      // Dimmed value
+static uint8_t sqrt_lut[256];     // sqrt16(x * 256)
+static uint16_t recip_lut[256];   // 65535 / x
+static volatile bool luts_ready = false;
+
+// Tables are filled with the same values by any caller, so concurrent
+// initialization is harmless
+static void init_luts()
+{
+    if (luts_ready)
+        return;
 
-    if (highest == r)
+    for (int i = 0; i < 256; i++)
     {
-        // Red is highest.
-        // Hue could be Purple/Pink-Red,Red-Orange,Orange-Yellow
-        if (g == 0)
-        {
-            // if green is zero, we're in Purple/Pink-Red
-            h = (HUE_PURPLE + HUE_PINK) / 2;
-            h += scale8(qsub8(r, 128), FIXFRAC8(48, 128));
-        }
-        else if ((r - g) > g)
-        {
-            // if R-G > G then we're in Red-Orange
-            h = HUE_RED;
-            h += scale8(g, FIXFRAC8(32, 85));
-        }
-        else
-        {
-            // R-G < G, we're in Orange-Yellow
-            h = HUE_ORANGE;
-            h += scale8(qsub8((g - 85) + (171 - r), 4), FIXFRAC8(32, 85)); //221
-        }
+        rgb_t c = hsv2rgb_rainbow(hsv_from_values(i, 255, 255));
+        rainbow_lut[i] = c.r | (c.g << 8) | ((uint32_t)c.b << 16);
+        desat_lut[i] = scale8_video(255 - i, 255 - i);
+        dim_lut[i] = scale8_video(i, i);
+        sqrt_lut[i] = sqrt16(i * 256);
+        recip_lut[i] = 65535 / (i ? i : 1);
+    }
+    luts_ready = true;
+}
+
+void hsv2rgb_rainbow_n(const hsv_t *hsv, rgb_t *rgb, size_t num)
+{
+    init_luts();
 
+    for (size_t i = 0; i < num; i++)
+    {
+        // with sat = 255 and val = 255 scaling is identity, so no branches needed
+        uint8_t desat = desat_lut[hsv[i].sat];
+        uint32_t c = scale8_x4(rainbow_lut[hsv[i].hue], 255 - desat) + desat * 0x010101;
+        c = scale8_x4(c, dim_lut[hsv[i].val]);
+        rgb[i].r = c;
+        rgb[i].g = c >> 8;
+        rgb[i].b = c >> 16;
     }
-    else if (highest == g)
+}
+
+void rgb2hsv_approximate_n(const rgb_t *rgb, hsv_t *hsv, size_t num)
+{
+    init_luts();
+
+    for (size_t i = 0; i < num; i++)
     {
-        // Green is highest
-        // Hue could be Yellow-Green, Green-Aqua
-        if (b == 0)
-        {
-            // if Blue is zero, we're in Yellow-Green
-            //   G = 171..255
-            //   R = 171..  0
-            h = HUE_YELLOW;
-            uint8_t radj = scale8(qsub8(171, r), 47); //171..0 -> 0..171 -> 0..31
-            uint8_t gadj = scale8(qsub8(g, 171), 96); //171..255 -> 0..84 -> 0..31;
-            uint8_t rgadj = radj + gadj;
-            uint8_t hueadv = rgadj / 2;
-            h += hueadv;
-            //h += scale8( qadd8( 4, qadd8((g - 128), (128 - r))),
-            //             FIXFRAC8(32,255)); //
-        }
-        else
+        uint8_t r = rgb[i].r;
+        uint8_t g = rgb[i].g;
+        uint8_t b = rgb[i].b;
+
+        uint8_t desat = r < g ? r : g;
+        desat = b < desat ? b : desat;
+        r -= desat;
+        g -= desat;
+        b -= desat;
+
+        uint8_t s = desat ? 255 - sqrt_lut[desat] : 255;
+        if (!(r | g | b))
         {
-            // if Blue is nonzero we're in Green-Aqua
-            if ((g - b) > b)
-            {
-                h = HUE_GREEN;
-                h += scale8(b, FIXFRAC8(32, 85));
-            }
-            else
-            {
-                h = HUE_AQUA;
-                h += scale8(qsub8(b, 85), FIXFRAC8(8, 42));
-            }
+            hsv[i] = hsv_from_values(0, 0, 255 - s);
+            continue;
         }
 
-    }
-    else /* highest == b */
-    {
-        // Blue is highest
-        // Hue could be Aqua/Blue-Blue, Blue-Purple, Purple-Pink
-        if (r == 0)
+        if (s < 255)
         {
-            // if red is zero, we're in Aqua/Blue-Blue
-            h = HUE_AQUA + ((HUE_BLUE - HUE_AQUA) / 4);
-            h += scale8(qsub8(b, 128), FIXFRAC8(24, 128));
+            uint32_t scaleup = recip_lut[s];
+            r = (r * scaleup) >> 8;
+            g = (g * scaleup) >> 8;
+            b = (b * scaleup) >> 8;
         }
-        else if ((b - r) > r)
+
+        uint16_t total = r + g + b;
+        uint8_t v = 255;
+        if (total < 255)
         {
-            // B-R > R, we're in Blue-Purple
-            h = HUE_BLUE;
-            h += scale8(r, FIXFRAC8(32, 85));
+            if (!total)
+                total = 1;
+            uint32_t scaleup = recip_lut[total];
+            r = (r * scaleup) >> 8;
+            g = (g * scaleup) >> 8;
+            b = (b * scaleup) >> 8;
         }
-        else
+        if (total <= 255)
         {
-            // B-R < R, we're in Purple-Pink
-            h = HUE_PURPLE;
-            h += scale8(qsub8(r, 85), FIXFRAC8(32, 85));
+            v = qadd8(desat, total);
+            if (v != 255)
+                v = sqrt_lut[v];
         }
-    }
-
-    h += 1;
 
-    return hsv_from_values(h, s, v);
+        hsv[i] = hsv_from_values(approximate_hue(r, g, b), s, v);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -993,29 +1110,104 @@ hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_directi
     return existing;
 }
 
-void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
+////////////////////////////////////////////////////////////////////////////////
+
+// Load up to 4 bytes, missing ones are zero. Little-endian targets only.
+// Constant size copy of whole words is inlined, only the tail is not
+static inline uint32_t load_x4(const uint8_t *p, size_t n)
 {
-    uint8_t keep = 255 - blur_amount;
-    uint8_t seep = blur_amount >> 1;
-    rgb_t carryover = rgb_from_code(0);
-    for (size_t i = 0; i < num_leds; ++i)
+    uint32_t w = 0;
+    if (n >= 4)
+        memcpy(&w, p, 4);
+    else
+        memcpy(&w, p, n);
+    return w;
+}
+
+static inline void store_x4(uint8_t *p, uint32_t w, size_t n)
+{
+    if (n >= 4)
+        memcpy(p, &w, 4);
+    else
+        memcpy(p, &w, n);
+}
+
+// Seeped parts of neighbors are scaled once per word and shifted into
+// place: scale8() is per channel, so it commutes with byte shifts.
+// out = qadd8(qadd8(scale8(x, keep), scale8(prev, seep)), scale8(next, seep))
+// keep + 2 * seep <= 255, so the sum never saturates and channels are
+// added without carries between them
+
+// Blur of contiguous line of pixels: neighbors of each channel are 3 bytes away
+static void blur_line(uint8_t *p, size_t size, uint8_t keep, uint8_t seep)
+{
+    uint32_t prev_part = 0;
+    uint32_t cur = load_x4(p, size);
+    uint32_t cur_part = scale8_x4(cur, seep);
+    for (size_t offs = 0; offs < size; offs += 4)
     {
-        rgb_t cur = leds[i];
-        rgb_t part = cur;
-        part = rgb_scale(part, seep);
-        cur = rgb_add_rgb(rgb_scale(cur, keep), carryover);
-        if (i)
-            leds[i - 1] = rgb_add_rgb(leds[i - 1], part);
-        leds[i] = cur;
-        carryover = part;
+        uint32_t next = offs + 4 < size ? load_x4(p + offs + 4, size - offs - 4) : 0;
+        uint32_t next_part = scale8_x4(next, seep);
+        uint32_t left = (prev_part >> 8) | (cur_part << 24);
+        uint32_t right = (cur_part >> 24) | (next_part << 8);
+        store_x4(p + offs, scale8_x4(cur, keep) + left + right, size - offs);
+        prev_part = cur_part;
+        cur = next;
+        cur_part = next_part;
+    }
+}
+
+// Blur of columns of row-major matrix, walks down 4 byte wide stripes
+static void blur_stripes(uint8_t *p, size_t stride, size_t height, uint8_t keep, uint8_t seep)
+{
+    for (size_t offs = 0; offs < stride; offs += 4)
+    {
+        size_t n = stride - offs;
+        uint8_t *col = p + offs;
+        uint32_t prev_part = 0;
+        uint32_t cur = load_x4(col, n);
+        uint32_t cur_part = scale8_x4(cur, seep);
+        for (size_t row = 0; row < height; row++, col += stride)
+        {
+            uint32_t next = row + 1 < height ? load_x4(col + stride, n) : 0;
+            uint32_t next_part = scale8_x4(next, seep);
+            store_x4(col, scale8_x4(cur, keep) + prev_part + next_part, n);
+            prev_part = cur_part;
+            cur = next;
+            cur_part = next_part;
+        }
     }
 }
 
+void rgb_scale_n(rgb_t *leds, size_t num, uint8_t scaledown)
+{
+    typedef uint32_t __attribute__((may_alias)) word_t;
+
+    uint8_t *p = (uint8_t *)leds;
+    uint8_t *end = p + num * sizeof(rgb_t);
+    for (; p < end && ((uintptr_t)p & 3); p++)
+        *p = scale8(*p, scaledown);
+    for (; p + 4 <= end; p += 4)
+        *(word_t *)p = scale8_x4(*(word_t *)p, scaledown);
+    for (; p < end; p++)
+        *p = scale8(*p, scaledown);
+}
+
+void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
+{
+    blur_line((uint8_t *)leds, num_leds * sizeof(rgb_t), 255 - blur_amount, blur_amount >> 1);
+}
+
 void blur_columns(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_offs_cb xy, void *ctx)
 {
     // blur columns
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        blur_stripes((uint8_t *)leds, width * sizeof(rgb_t), height, keep, seep);
+        return;
+    }
     for (size_t col = 0; col < width; ++col)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1042,6 +1234,12 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
     // blur rows same as columns, for irregular matrix
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        for (size_t row = 0; row < height; row++)
+            blur_line((uint8_t *)(leds + row * width), width * sizeof(rgb_t), keep, seep);
+        return;
+    }
     for (size_t row = 0; row < height; row++)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1100,3 +1298,39 @@ rgb_t apply_gamma2rgb_channels(rgb_t c, float gamma_r, float gamma_g, float gamm
     };
     return res;
 }
+
+static void fill_lut(uint8_t *table, const uint8_t *gamma, uint8_t brightness, uint8_t correction)
+{
+    uint8_t scale = ((uint16_t)brightness * (correction + 1)) >> 8;
+    for (size_t i = 0; i < 256; i++)
+        table[i] = scale8_video(gamma[i], scale);
+}
+
+bool rgb_lut_set(rgb_lut_t *lut, float gamma, uint8_t brightness, rgb_t correction)
+{
+    if (lut->valid && lut->gamma == gamma && lut->brightness == brightness
+            && lut->correction.r == correction.r && lut->correction.g == correction.g
+            && lut->correction.b == correction.b)
+        return false;
+
+    // powf() only here, once per entry
+    uint8_t curve[256];
+    for (size_t i = 0; i < 256; i++)
+        curve[i] = gamma == 1.0f ? i : apply_gamma2brightness(i, gamma);
+
+    fill_lut(lut->r, curve, brightness, correction.r);
+    fill_lut(lut->g, curve, brightness, correction.g);
+    fill_lut(lut->b, curve, brightness, correction.b);
+    lut->gamma = gamma;
+    lut->brightness = brightness;
+    lut->correction = correction;
+    lut->valid = true;
+
+    return true;
+}
+
+void rgb_lut_apply_n(const rgb_lut_t *lut, rgb_t *c, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        c[i] = rgb_lut_apply(lut, c[i]);
+}
@@ -127,6 +127,30 @@ rgb_t hsv2rgb_raw(hsv_t hsv);
  */
 hsv_t rgb2hsv_approximate(rgb_t rgb);
 
+/**
+ * @brief Convert array of HSV colors to RGB using balanced rainbow
+ *
+ * Same as hsv2rgb_rainbow() for every color, but uses lookup tables
+ * (about 2.3 KB of RAM, filled on first call) and no branches.
+ *
+ * @param hsv   Source HSV colors
+ * @param rgb   Destination RGB colors
+ * @param num   Number of colors
+ */
+void hsv2rgb_rainbow_n(const hsv_t *hsv, rgb_t *rgb, size_t num);
+
+/**
+ * @brief Approximately convert array of RGB colors to HSV
+ *
+ * Same as rgb2hsv_approximate() for every color, but square roots and
+ * divisions are taken from lookup tables shared with hsv2rgb_rainbow_n().
+ *
+ * @param rgb   Source RGB colors
+ * @param hsv   Destination HSV colors
+ * @param num   Number of colors
+ */
+void rgb2hsv_approximate_n(const rgb_t *rgb, hsv_t *hsv, size_t num);
+
 /**
  * @brief Approximates a 'black body radiation' spectrum for a given 'heat' level.
  *
@@ -284,9 +308,21 @@ rgb_t color_from_palette_rgb(const rgb_t *palette, uint8_t pal_size, uint8_t ind
 ////////////////////////////////////////////////////////////////////////////////
 // Filter functions
 
+/**
+ * @brief Scale down colors to N 256ths of their current brightness
+ *
+ * Same as rgb_scale() for every color, but processes four channels at once.
+ *
+ * @param leds      Array of colors
+ * @param num       Number of colors
+ * @param scaledown Scale
+ */
+void rgb_scale_n(rgb_t *leds, size_t num, uint8_t scaledown);
+
 /**
  * Function which must be provided by the application for use in two-dimensional
- * filter functions.
+ * filter functions. Pass NULL instead of function for row-major matrices
+ * (offset = y * width + x), then faster word-wise kernels are used.
  */
 typedef size_t (*xy_to_offs_cb)(void *ctx, size_t x, size_t y);
 
@@ -357,6 +393,58 @@ rgb_t apply_gamma2rgb(rgb_t c, float gamma);
  */
 rgb_t apply_gamma2rgb_channels(rgb_t c, float gamma_r, float gamma_g, float gamma_b);
 
+/**
+ * Gamma, brightness and color correction lookup tables.
+ *
+ * Tables are computed once by ::rgb_lut_set() and applied with integer
+ * lookups only, so no float math is needed when packing pixels.
+ */
+typedef struct
+{
+    uint8_t r[256];    ///< Red channel table
+    uint8_t g[256];    ///< Green channel table
+    uint8_t b[256];    ///< Blue channel table
+    float gamma;       ///< Gamma of tables
+    uint8_t brightness; ///< Brightness of tables
+    rgb_t correction;  ///< Color correction of tables, 255 means no correction
+    bool valid;        ///< Tables are computed, internal
+} rgb_lut_t;
+
+/**
+ * @brief Set parameters of lookup tables
+ *
+ * Each table entry is apply_gamma2brightness() of the index scaled with
+ * scale8_video() by brightness and channel correction. Tables are
+ * recomputed only if parameters differ from the current ones.
+ * Zero-initialized descriptor is valid input.
+ *
+ * @param lut        Lookup tables
+ * @param gamma      Gamma, 1.0 for linear output
+ * @param brightness Brightness, 255 for full
+ * @param correction Per-channel scale, e.g. `{ .r = 255, .g = 176, .b = 240 }`
+ *                   for typical 5050 LEDs, `{ .r = 255, .g = 255, .b = 255 }` for none
+ * @return true if tables were recomputed
+ */
+bool rgb_lut_set(rgb_lut_t *lut, float gamma, uint8_t brightness, rgb_t correction);
+
+/**
+ * @brief Apply lookup tables to color
+ */
+static inline rgb_t rgb_lut_apply(const rgb_lut_t *lut, rgb_t c)
+{
+    rgb_t res = {
+        .r = lut->r[c.r],
+        .g = lut->g[c.g],
+        .b = lut->b[c.b],
+    };
+    return res;
+}
+
+/**
+ * @brief Apply lookup tables to array of colors in place
+ */
+void rgb_lut_apply_n(const rgb_lut_t *lut, rgb_t *c, size_t num);
+
 #ifdef __cplusplus
 }
 #endif
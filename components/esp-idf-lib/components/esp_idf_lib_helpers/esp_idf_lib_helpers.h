@@ -56,10 +56,22 @@
 #elif defined(CONFIG_IDF_TARGET_ESP8266)
 #define HELPER_TARGET_IS_ESP32     (0)
 #define HELPER_TARGET_IS_ESP8266   (1)
+
+/* HELPER_TARGET_IS_LINUX
+ * 1 when the target is linux (host build, no hardware peripherals)
+ */
+#elif defined(CONFIG_IDF_TARGET_LINUX)
+#define HELPER_TARGET_IS_ESP32     (0)
+#define HELPER_TARGET_IS_ESP8266   (0)
+#define HELPER_TARGET_IS_LINUX     (1)
 #else
 #error BUG: cannot determine the target
 #endif
 
+#ifndef HELPER_TARGET_IS_LINUX
+#define HELPER_TARGET_IS_LINUX     (0)
+#endif
+
 #if HELPER_TARGET_IS_ESP32 && ESP_IDF_VERSION < HELPER_ESP32_MIN_VER
 #error Unsupported ESP-IDF version. Please update!
 #endif
@@ -31,18 +31,31 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include <stdlib.h>
+#include <string.h>
 #include "framebuffer.h"
 
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 #define CHECK(x) do { esp_err_t __; if ((__ = (x)) != ESP_OK) return __; } while (0)
 
-static size_t xy(void *ctx, size_t x, size_t y)
+#define DIRTY_WORDS(fb) (((fb)->height + 31) / 32)
+
+#define ROW_DIRTY(fb, y) ((fb)->dirty[(y) >> 5] & (1UL << ((y) & 31)))
+#define MARK_ROW(fb, y) do { (fb)->dirty[(y) >> 5] |= 1UL << ((y) & 31); } while (0)
+
+static void mark_all(framebuffer_t *fb)
 {
-    framebuffer_t *fb = (framebuffer_t *)ctx;
-    return y * fb->width + x;
+    fb_mark_dirty(fb, 0, fb->height);
 }
 
-esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
+static bool is_dirty(const framebuffer_t *fb)
+{
+    for (size_t i = 0; i < DIRTY_WORDS(fb); i++)
+        if (fb->dirty[i])
+            return true;
+    return false;
+}
+
+static esp_err_t init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb, bool indexed)
 {
     CHECK_ARG(fb && width && height && render_cb);
 
@@ -52,12 +65,53 @@ esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t
     fb->last_frame_us = 0;
     fb->render = render_cb;
     fb->internal = NULL;
+    fb->data = NULL;
+    fb->index = NULL;
+    fb->colors = NULL;
+    fb->dirty = NULL;
+    fb->track_dirty = false;
+
     fb->mutex = xSemaphoreCreateMutex();
     if (!fb->mutex)
-        return ESP_ERR_NO_MEM;
-    fb->data = calloc(1, FB_SIZE(fb));
-    if (!fb->data)
-        return ESP_ERR_NO_MEM;
+        goto fail;
+    if (indexed)
+    {
+        fb->index = calloc(width, height);
+        fb->colors = calloc(256, sizeof(rgb_t));
+        if (!fb->index || !fb->colors)
+            goto fail;
+    }
+    else if (!(fb->data = calloc(1, FB_SIZE(fb))))
+        goto fail;
+    fb->dirty = calloc(DIRTY_WORDS(fb), sizeof(uint32_t));
+    if (!fb->dirty)
+        goto fail;
+    mark_all(fb);
+
+    return ESP_OK;
+
+fail:
+    fb_free(fb);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
+{
+    return init(fb, width, height, render_cb, false);
+}
+
+esp_err_t fb_init_palette(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb)
+{
+    return init(fb, width, height, render_cb, true);
+}
+
+esp_err_t fb_set_palette(framebuffer_t *fb, const rgb_t *palette, uint8_t pal_size, uint8_t brightness, bool blend)
+{
+    CHECK_ARG(fb && fb->colors && palette && pal_size);
+
+    for (size_t i = 0; i < 256; i++)
+        fb->colors[i] = color_from_palette_rgb(palette, pal_size, i, brightness, blend);
+    mark_all(fb);
 
     return ESP_OK;
 }
@@ -68,21 +122,99 @@ esp_err_t fb_free(framebuffer_t *fb)
 
     if (fb->data)
         free(fb->data);
+    if (fb->dirty)
+        free(fb->dirty);
+    if (fb->index)
+        free(fb->index);
+    if (fb->colors)
+        free(fb->colors);
     if (fb->mutex)
         vSemaphoreDelete(fb->mutex);
+    fb->data = NULL;
+    fb->dirty = NULL;
+    fb->index = NULL;
+    fb->colors = NULL;
+    fb->mutex = NULL;
 
     return ESP_OK;
 }
 
 esp_err_t fb_render(framebuffer_t *fb, void *render_ctx)
 {
-    CHECK_ARG(fb && fb->data && fb->render);
+    CHECK_ARG(fb && (fb->data || fb->index) && fb->render);
 
     if (xSemaphoreTake(fb->mutex, 0) != pdTRUE)
         return ESP_ERR_INVALID_STATE;
-    CHECK(fb->render(fb, render_ctx));
+
+    if (!fb->track_dirty)
+        mark_all(fb);
+    else if (!is_dirty(fb))
+    {
+        // nothing changed since last frame
+        xSemaphoreGive(fb->mutex);
+        return ESP_OK;
+    }
+
+    esp_err_t res = fb->render(fb, render_ctx);
+    if (res == ESP_OK)
+        memset(fb->dirty, 0, DIRTY_WORDS(fb) * sizeof(uint32_t));
     xSemaphoreGive(fb->mutex);
 
+    return res;
+}
+
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t y, size_t count)
+{
+    CHECK_ARG(fb && fb->dirty && y < fb->height);
+
+    if (count > fb->height - y)
+        count = fb->height - y;
+    for (size_t end = y + count; y < end; y++)
+        MARK_ROW(fb, y);
+
+    return ESP_OK;
+}
+
+size_t fb_dirty_span(const framebuffer_t *fb, size_t *y)
+{
+    if (!fb || !fb->dirty || !y)
+        return 0;
+
+    size_t row = *y;
+    while (row < fb->height && !ROW_DIRTY(fb, row))
+    {
+        // skip clean words at once
+        if (!(row & 31) && !fb->dirty[row >> 5])
+            row += 32;
+        else
+            row++;
+    }
+    if (row >= fb->height)
+        return 0;
+
+    *y = row;
+    while (row < fb->height && ROW_DIRTY(fb, row))
+        row++;
+
+    return row - *y;
+}
+
+esp_err_t fb_set_pixel_index(framebuffer_t *fb, size_t x, size_t y, uint8_t index)
+{
+    CHECK_ARG(fb && fb->index && x < fb->width && y < fb->height);
+
+    fb->index[FB_OFFSET(fb, x, y)] = index;
+    MARK_ROW(fb, y);
+
+    return ESP_OK;
+}
+
+esp_err_t fb_get_pixel_index(framebuffer_t *fb, size_t x, size_t y, uint8_t *index)
+{
+    CHECK_ARG(index && fb && fb->index && x < fb->width && y < fb->height);
+
+    *index = fb->index[FB_OFFSET(fb, x, y)];
+
     return ESP_OK;
 }
 
@@ -91,6 +223,7 @@ esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color)
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
     fb->data[FB_OFFSET(fb, x, y)] = color;
+    MARK_ROW(fb, y);
 
     return ESP_OK;
 }
@@ -100,24 +233,28 @@ esp_err_t fb_set_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t color)
     CHECK_ARG(fb && fb->data && x < fb->width && y < fb->height);
 
     fb->data[FB_OFFSET(fb, x, y)] = hsv2rgb_rainbow(color);
+    MARK_ROW(fb, y);
 
     return ESP_OK;
 }
 
 esp_err_t fb_get_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t *color)
 {
-    CHECK_ARG(color && fb && fb->data && x < fb->width && y < fb->height);
+    CHECK_ARG(color && fb && (fb->data || fb->index) && x < fb->width && y < fb->height);
 
-    *color = fb->data[FB_OFFSET(fb, x, y)];
+    *color = fb->index
+        ? fb->colors[fb->index[FB_OFFSET(fb, x, y)]]
+        : fb->data[FB_OFFSET(fb, x, y)];
 
     return ESP_OK;
 }
 
 esp_err_t fb_get_pixel_hsv(framebuffer_t *fb, size_t x, size_t y, hsv_t *color)
 {
-    CHECK_ARG(color && fb && fb->data && x < fb->width && y < fb->height);
+    rgb_t rgb;
+    CHECK(fb_get_pixel_rgb(fb, x, y, &rgb));
 
-    *color = rgb2hsv_approximate(fb->data[FB_OFFSET(fb, x, y)]);
+    *color = rgb2hsv_approximate(rgb);
 
     return ESP_OK;
 }
@@ -162,48 +299,59 @@ esp_err_t fb_set_pixelf_hsv(framebuffer_t *fb, float x, float y, hsv_t color)
     return fb_set_pixelf_rgb(fb, x, y, hsv2rgb_rainbow(color));
 }
 
+static uint8_t *pixels(framebuffer_t *fb)
+{
+    return fb->index ? fb->index : (uint8_t *)fb->data;
+}
+
 esp_err_t fb_clear(framebuffer_t *fb)
 {
-    CHECK_ARG(fb && fb->data);
+    CHECK_ARG(fb && (fb->data || fb->index));
 
-    memset(fb->data, 0, FB_SIZE(fb));
+    memset(pixels(fb), 0, FB_SIZE(fb));
+    mark_all(fb);
 
     return ESP_OK;
 }
 
 esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir)
 {
-    CHECK_ARG(fb && fb->data && offs);
+    CHECK_ARG(fb && (fb->data || fb->index) && offs);
 
     if (((dir == FB_SHIFT_LEFT || dir == FB_SHIFT_RIGHT) && offs >= fb->width)
             || ((dir == FB_SHIFT_UP || dir == FB_SHIFT_DOWN) && offs >= fb->height))
         return ESP_OK;
 
+    uint8_t *data = pixels(fb);
+    size_t pixel = FB_PIXEL_SIZE(fb);
+    size_t stride = fb->width * pixel;
+
     switch (dir)
     {
         case FB_SHIFT_LEFT:
             for (size_t row = 0; row < fb->height; row++)
-                memmove(fb->data + row * fb->width,
-                        fb->data + row * fb->width + offs,
-                        sizeof(rgb_t) * (fb->width - offs));
+                memmove(data + row * stride,
+                        data + row * stride + offs * pixel,
+                        pixel * (fb->width - offs));
             break;
         case FB_SHIFT_RIGHT:
             for (size_t row = 0; row < fb->height; row++)
-                memmove(fb->data + row * fb->width + offs,
-                        fb->data + row * fb->width,
-                        sizeof(rgb_t) * (fb->width - offs));
+                memmove(data + row * stride + offs * pixel,
+                        data + row * stride,
+                        pixel * (fb->width - offs));
             break;
         case FB_SHIFT_UP:
-            memmove(fb->data + offs * fb->width,
-                    fb->data,
-                    FB_SIZE(fb) - offs * fb->width * sizeof(rgb_t));
+            memmove(data + offs * stride,
+                    data,
+                    FB_SIZE(fb) - offs * stride);
             break;
         case FB_SHIFT_DOWN:
-            memmove(fb->data,
-                    fb->data + offs * fb->width,
-                    FB_SIZE(fb) - offs * fb->width * sizeof(rgb_t));
+            memmove(data,
+                    data + offs * stride,
+                    FB_SIZE(fb) - offs * stride);
             break;
     }
+    mark_all(fb);
 
     return ESP_OK;
 }
@@ -212,8 +360,12 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale)
 {
     CHECK_ARG(fb && fb->data);
 
-    for (size_t i = 0; i < fb->width * fb->height; i++)
-        fb->data[i] = rgb_fade(fb->data[i], scale);
+    if (!scale)
+        return ESP_OK;
+
+    // same as rgb_fade() for every pixel
+    rgb_scale_n(fb->data, fb->width * fb->height, ~scale);
+    mark_all(fb);
 
     return ESP_OK;
 }
@@ -222,7 +374,12 @@ esp_err_t fb_blur2d(framebuffer_t *fb, fract8 amount)
 {
     CHECK_ARG(fb && fb->data);
 
-    blur2d(fb->data, fb->width, fb->height, amount, xy, fb);
+    if (!amount)
+        return ESP_OK;
+
+    // framebuffer is row-major, use callback-free kernels
+    blur2d(fb->data, fb->width, fb->height, amount, NULL, NULL);
+    mark_all(fb);
 
     return ESP_OK;
 }
@@ -28,6 +28,19 @@
  *
  * Simple abstraction of RGB framebuffer for ESP-IDF
  *
+ * Framebuffer stores either RGB colors or, in palette mode, 8-bit palette
+ * indices (one byte per pixel instead of three). In palette mode colors
+ * are resolved only at render time through a 256-color table built by
+ * ::fb_set_palette(), e.g. straight into the LED strip buffer:
+ *
+ *     static esp_err_t render(framebuffer_t *fb, void *arg)
+ *     {
+ *         for (size_t y = 0, n; (n = fb_dirty_span(fb, &y)) > 0; y += n)
+ *             led_strip_set_pixels_indexed(arg, y * fb->width, n * fb->width,
+ *                     fb->index + FB_OFFSET(fb, 0, y), fb->colors);
+ *         return led_strip_flush(arg);
+ *     }
+ *
  * Copyright (c) 2021 Ruslan V. Uss <unclerus@gmail.com>
  *
  * MIT Licensed as described in the file LICENSE
@@ -46,7 +59,9 @@ extern "C" {
 
 #define FB_OFFSET(fb, x, y) ((fb)->width * (y) + (x))
 
-#define FB_SIZE(fb) ((fb)->width * (fb)->height * sizeof(rgb_t))
+#define FB_PIXEL_SIZE(fb) ((fb)->index ? 1 : sizeof(rgb_t))
+
+#define FB_SIZE(fb) ((fb)->width * (fb)->height * FB_PIXEL_SIZE(fb))
 
 typedef enum {
     FB_SHIFT_LEFT  = 0,
@@ -67,7 +82,7 @@ typedef esp_err_t (*fb_render_cb_t)(framebuffer_t *fb, void *arg);
  */
 struct framebuffer_s
 {
-    rgb_t *data;                   ///< RGB framebuffer
+    rgb_t *data;                   ///< RGB framebuffer, NULL in palette mode
     size_t width;                  ///< Framebuffer width
     size_t height;                 ///< Framebuffer height
     size_t frame_num;              ///< Number of rendered frames
@@ -75,6 +90,10 @@ struct framebuffer_s
     fb_render_cb_t render;         ///< See ::fb_render()
     uint8_t *internal;             ///< Buffer for effect settings, internal vars, palettes and so on
     SemaphoreHandle_t mutex;
+    uint32_t *dirty;               ///< Bitmask of rows changed since last render, see ::fb_dirty_span()
+    bool track_dirty;              ///< If true, ::fb_render() skips frames without changes
+    uint8_t *index;                ///< Palette indices in palette mode, NULL in RGB mode
+    rgb_t *colors;                 ///< Palette resolved to 256 colors, see ::fb_set_palette()
 };
 
 /**
@@ -89,6 +108,37 @@ struct framebuffer_s
  */
 esp_err_t fb_init(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb);
 
+/**
+ * @brief Initialize palette-indexed framebuffer
+ *
+ * Framebuffer stores one palette index per pixel. All pixels are black
+ * until ::fb_set_palette() is called.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param width     Frame width in pixels
+ * @param height    Frame height in pixels
+ * @param render_cb Renderer callback function
+ *
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_init_palette(framebuffer_t *fb, size_t width, size_t height, fb_render_cb_t render_cb);
+
+/**
+ * @brief Set palette of palette-indexed framebuffer
+ *
+ * Resolves all 256 indices with color_from_palette_rgb() into `fb->colors`.
+ * Palette is not referenced after the call, so call this function again
+ * after changing palette colors.
+ *
+ * @param fb         Framebuffer descriptor
+ * @param palette    RGB palette
+ * @param pal_size   Number of palette entries, 256 must be divisible by it
+ * @param brightness Brightness of resolved colors
+ * @param blend      Interpolate between adjacent palette entries
+ * @return           ESP_OK on success
+ */
+esp_err_t fb_set_palette(framebuffer_t *fb, const rgb_t *palette, uint8_t pal_size, uint8_t brightness, bool blend);
+
 /**
  * @brief Free Framebuffer descriptor buffers
  *
@@ -103,15 +153,75 @@ esp_err_t fb_free(framebuffer_t *fb);
  * Rendering is performed by calling the callback function with passing
  * it as arguments \p fb and \p ctx
  *
+ * If `fb->track_dirty` is true and no rows were changed since the last
+ * render, callback is not called. Otherwise callback may use
+ * ::fb_dirty_span() to update only changed rows. Dirty rows are cleared
+ * after successful rendering.
+ *
  * @param fb   Framebuffer descriptor
  * @param ctx  Argument to pass to callback
  * @return     ESP_OK on success
  */
 esp_err_t fb_render(framebuffer_t *fb, void *ctx);
 
+/**
+ * @brief Mark framebuffer rows as changed
+ *
+ * Framebuffer functions mark rows themselves. Call this function
+ * after writing to `fb->data` directly.
+ *
+ * @param fb     Framebuffer descriptor
+ * @param y      First row
+ * @param count  Number of rows
+ * @return       ESP_OK on success
+ */
+esp_err_t fb_mark_dirty(framebuffer_t *fb, size_t y, size_t count);
+
+/**
+ * @brief Find next span of changed rows
+ *
+ * Intended for render callbacks:
+ *
+ *     for (size_t y = 0, n; (n = fb_dirty_span(fb, &y)) > 0; y += n)
+ *         send_rows(fb, y, n);
+ *
+ * @param fb         Framebuffer descriptor
+ * @param[in,out] y  Row to start search from, first row of found span
+ * @return           Number of changed rows in span, 0 if none found
+ */
+size_t fb_dirty_span(const framebuffer_t *fb, size_t *y);
+
+/**
+ * @brief Set palette index of framebuffer pixel
+ *
+ * Palette mode only.
+ *
+ * @param fb        Framebuffer descriptor
+ * @param x         X coordinate
+ * @param y         Y coordinate
+ * @param index     Palette index
+ * @return          ESP_OK on success
+ */
+esp_err_t fb_set_pixel_index(framebuffer_t *fb, size_t x, size_t y, uint8_t index);
+
+/**
+ * @brief Get palette index of framebuffer pixel
+ *
+ * Palette mode only.
+ *
+ * @param fb          Framebuffer descriptor
+ * @param x           X coordinate
+ * @param y           Y coordinate
+ * @param[out] index  Palette index
+ * @return            ESP_OK on success
+ */
+esp_err_t fb_get_pixel_index(framebuffer_t *fb, size_t x, size_t y, uint8_t *index);
+
 /**
  * @brief Set RGB color of framebuffer pixel
  *
+ * RGB mode only.
+ *
  * @param fb        Framebuffer descriptor
  * @param x         X coordinate
  * @param y         Y coordinate
@@ -123,6 +233,8 @@ esp_err_t fb_set_pixel_rgb(framebuffer_t *fb, size_t x, size_t y, rgb_t color);
 /**
  * @brief Set HSV color of framebuffer pixel
  *
+ * RGB mode only.
+ *
  * @param fb        Framebuffer descriptor
  * @param x         X coordinate
  * @param y         Y coordinate
@@ -156,6 +268,8 @@ esp_err_t fb_set_pixelf_hsv(framebuffer_t *fb, float x, float y, hsv_t color);
 /**
  * @brief Get RGB color of framebuffer pixel
  *
+ * In palette mode returns resolved palette color.
+ *
  * @param fb          Framebuffer descriptor
  * @param x           X coordinate
  * @param y           Y coordinate
@@ -196,7 +310,7 @@ esp_err_t fb_shift(framebuffer_t *fb, size_t offs, fb_shift_direction_t dir);
 /**
  * @brief Fade pixels to black
  *
- * rgb_fade(pixel, scale) for all pixels in framebuffer
+ * rgb_fade(pixel, scale) for all pixels in framebuffer. RGB mode only.
  *
  * @param fb        Framebuffer descriptor
  * @param scale     Amount of scaling
@@ -207,7 +321,7 @@ esp_err_t fb_fade(framebuffer_t *fb, uint8_t scale);
 /**
  * @brief Aplly two-dimensional blur filter on framebuffer
  *
- * Spreads light to 8 XY neighbors.
+ * Spreads light to 8 XY neighbors. RGB mode only.
  *
  *   0 = no spread at all
  *  64 = moderate spreading
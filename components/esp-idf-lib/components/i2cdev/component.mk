@@ -5,3 +5,6 @@ COMPONENT_DEPENDS = esp8266 freertos esp_idf_lib_helpers
 else
 COMPONENT_DEPENDS = driver freertos esp_idf_lib_helpers
 endif
+
+# Simulator is built for linux target only
+COMPONENT_OBJEXCLUDE := i2cdev_sim.o i2cdev_sim_models.o
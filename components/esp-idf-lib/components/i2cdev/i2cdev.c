@@ -37,25 +37,155 @@
 #include <esp_log.h>
 #include "i2cdev.h"
 
+#if CONFIG_I2CDEV_PORT_OWNER
+#include <assert.h>
+#endif
+
+#if CONFIG_I2CDEV_SCHEDULER
+#include <freertos/queue.h>
+#endif
+
+#if CONFIG_I2CDEV_STATS
+#include <stdio.h>
+#include <esp_timer.h>
+#endif
+
+#if CONFIG_I2CDEV_BUS_RECOVERY && HELPER_TARGET_IS_ESP32
+#include <driver/gpio.h>
+#include <ets_sys.h>
+
+// Half period of recovery clock, 100 kHz
+#define I2CDEV_RECOVERY_DELAY_US 5
+#endif
+
+#if HELPER_TARGET_IS_LINUX
+#include "i2cdev_sim.h"
+#endif
+
+#if I2CDEV_USE_MASTER_BUS
+#include <stdlib.h>
+#include <esp_attr.h>
+#include <driver/i2c_master.h>
+
+// Multi-segment runs up to this size are merged on stack
+#define I2CDEV_MASTER_WRITE_BUF_SIZE 32
+#endif
+
+#define I2CDEV_ASYNC (I2CDEV_USE_MASTER_BUS && CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0)
+
+#if I2CDEV_ASYNC
+// Code shared with completion ISR of async transactions
+#define I2CDEV_ISR_ATTR IRAM_ATTR
+#else
+#define I2CDEV_ISR_ATTR
+#endif
+
 static const char *TAG = "i2cdev";
 
+#if CONFIG_I2CDEV_MUX
+typedef struct {
+    uint8_t addr;            // Mux address, 0 if entry is free
+    uint8_t channels;        // Currently selected channels
+    bool known;              // Selected channels are known
+} i2c_mux_state_t;
+#endif
+
+#if I2CDEV_USE_MASTER_BUS
+typedef struct {
+    uint8_t addr;
+    uint32_t clk_speed;
+    i2c_master_dev_handle_t handle;
+    i2c_dev_callback_t cb;   // Pending async transaction callback
+    void *cb_arg;
+    const i2c_dev_t *cb_dev;
+#if CONFIG_I2CDEV_STATS
+    int64_t queued_us;       // Pending async transaction statistics
+    uint32_t lock_us;
+    size_t bytes;
+#endif
+} i2c_dev_slot_t;
+#endif
+
 typedef struct {
     SemaphoreHandle_t lock;
     i2c_config_t config;
     bool installed;
+#if I2CDEV_USE_MASTER_BUS
+    i2c_master_bus_handle_t bus;
+    i2c_dev_slot_t devs[CONFIG_I2CDEV_MAX_DEVICES_PER_PORT];
+    size_t last;             // Index of the last used device slot
+    size_t evict;            // Next slot to reuse when all slots are taken
+#elif HELPER_TARGET_IS_ESP32
+    uint32_t timeout_ticks;  // Currently configured HW timeout
+#endif
+#if CONFIG_I2CDEV_SCHEDULER
+    QueueHandle_t sched_queue;
+    TaskHandle_t sched_task;
+#endif
+#if CONFIG_I2CDEV_STATS
+    i2c_dev_stats_t stats;
+#endif
+#if CONFIG_I2CDEV_MUX
+    i2c_mux_state_t muxes[CONFIG_I2CDEV_MUX_MAX_PER_PORT];
+#endif
+#if CONFIG_I2CDEV_PORT_OWNER
+    TaskHandle_t owner;      // Task the port is bound to, locks are skipped
+#endif
 } i2c_port_state_t;
 
 static i2c_port_state_t states[I2C_NUM_MAX];
 
+#if I2CDEV_ASYNC && CONFIG_I2CDEV_STATS
+// Statistics are also updated from completion ISR of async transactions
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+#define STATS_ENTER() portENTER_CRITICAL_SAFE(&stats_lock)
+#define STATS_EXIT() portEXIT_CRITICAL_SAFE(&stats_lock)
+#else
+#define STATS_ENTER()
+#define STATS_EXIT()
+#endif
+
+#if CONFIG_I2CDEV_PORT_OWNER
+// Bound port is used by its owner only, no locking needed
+inline static bool port_owned(i2c_port_t port)
+{
+    TaskHandle_t owner = states[port].owner;
+    if (!owner) return false;
+
+    assert(owner == xTaskGetCurrentTaskHandle() && "I2C port is bound to another task");
+    return true;
+}
+
+// Port can be bound while the caller waits for the mutex
+inline static bool port_bound_elsewhere(i2c_port_t port)
+{
+    TaskHandle_t owner = states[port].owner;
+    return owner && owner != xTaskGetCurrentTaskHandle();
+}
+#else
+#define port_owned(port) false
+#define port_bound_elsewhere(port) false
+#endif
+
+// Ownership is checked again after the mutex is taken: caller queued before
+// the port was bound must not touch it
 #if CONFIG_I2CDEV_NOLOCK
 #define SEMAPHORE_TAKE(port)
 #else
-#define SEMAPHORE_TAKE(port) do { \
-        if (!xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT))) \
+#define SEMAPHORE_TAKE(port) \
+        const bool port_locked = !port_owned(port); \
+        do { \
+        if (port_locked && !xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT))) \
         { \
             ESP_LOGE(TAG, "Could not take port mutex %d", port); \
             return ESP_ERR_TIMEOUT; \
         } \
+        if (port_locked && port_bound_elsewhere(port)) \
+        { \
+            xSemaphoreGive(states[port].lock); \
+            ESP_LOGE(TAG, "Port %d is bound to another task", port); \
+            return ESP_ERR_INVALID_STATE; \
+        } \
         } while (0)
 #endif
 
@@ -63,7 +193,7 @@ static i2c_port_state_t states[I2C_NUM_MAX];
 #define SEMAPHORE_GIVE(port)
 #else
 #define SEMAPHORE_GIVE(port) do { \
-        if (!xSemaphoreGive(states[port].lock)) \
+        if (port_locked && !xSemaphoreGive(states[port].lock)) \
         { \
             ESP_LOGE(TAG, "Could not give port mutex %d", port); \
             return ESP_FAIL; \
@@ -90,6 +220,24 @@ esp_err_t i2cdev_init()
     return ESP_OK;
 }
 
+#if I2CDEV_USE_MASTER_BUS
+static void i2c_release_bus(i2c_port_t port)
+{
+    for (size_t i = 0; i < CONFIG_I2CDEV_MAX_DEVICES_PER_PORT; i++)
+    {
+        i2c_dev_slot_t *slot = &states[port].devs[i];
+        if (slot->handle)
+            i2c_master_bus_rm_device(slot->handle);
+        memset(slot, 0, sizeof(i2c_dev_slot_t));
+    }
+    if (states[port].bus)
+        i2c_del_master_bus(states[port].bus);
+    states[port].bus = NULL;
+    states[port].last = 0;
+    states[port].evict = 0;
+}
+#endif
+
 esp_err_t i2cdev_done()
 {
     for (int i = 0; i < I2C_NUM_MAX; i++)
@@ -99,7 +247,11 @@ esp_err_t i2cdev_done()
         if (states[i].installed)
         {
             SEMAPHORE_TAKE(i);
+#if I2CDEV_USE_MASTER_BUS
+            i2c_release_bus(i);
+#elif !HELPER_TARGET_IS_LINUX
             i2c_driver_delete(i);
+#endif
             states[i].installed = false;
             SEMAPHORE_GIVE(i);
         }
@@ -111,8 +263,79 @@ esp_err_t i2cdev_done()
     return ESP_OK;
 }
 
+#if CONFIG_I2CDEV_PORT_OWNER
+
+esp_err_t i2cdev_port_bind(i2c_port_t port, TaskHandle_t task)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+#if CONFIG_I2CDEV_SCHEDULER
+    if (states[port].sched_task) return ESP_ERR_INVALID_STATE;
+#endif
+    if (states[port].owner) return ESP_ERR_INVALID_STATE;
+
+    // Wait for transaction in progress
+    if (!xSemaphoreTake(states[port].lock, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT)))
+    {
+        ESP_LOGE(TAG, "Could not take port mutex %d", port);
+        return ESP_ERR_TIMEOUT;
+    }
+    // Another task could bind the port while we were waiting
+    if (states[port].owner)
+    {
+        xSemaphoreGive(states[port].lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    states[port].owner = task ? task : xTaskGetCurrentTaskHandle();
+    xSemaphoreGive(states[port].lock);
+
+    ESP_LOGD(TAG, "Port %d is bound to task %p", port, states[port].owner);
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_port_unbind(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    if (!states[port].owner || states[port].owner != xTaskGetCurrentTaskHandle()) return ESP_ERR_INVALID_STATE;
+
+    states[port].owner = NULL;
+    return ESP_OK;
+}
+
+#endif /* CONFIG_I2CDEV_PORT_OWNER */
+
+#if CONFIG_I2CDEV_PORT_OWNER && !CONFIG_I2CDEV_NOLOCK
+// Device mutex is skipped on bound ports. Give checks the holder instead of
+// the owner: a task that took the mutex before the port was bound gives it
+inline static bool dev_mutex_held(const i2c_dev_t *dev)
+{
+    return xSemaphoreGetMutexHolder(dev->mutex) == xTaskGetCurrentTaskHandle();
+}
+#else
+#define dev_mutex_held(dev) false
+#endif
+
 esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev)
 {
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    // Descriptors are not required to be zeroed, cache stays disabled until i2c_dev_shadow_init()
+    if (dev)
+        dev->shadow.count = dev->shadow.valid = 0;
+#endif
+#if CONFIG_I2CDEV_STATS
+    if (dev)
+        memset(&dev->stats, 0, sizeof(dev->stats));
+#endif
+#if CONFIG_I2CDEV_MUX
+    if (dev)
+    {
+        dev->mux = NULL;
+        dev->mux_channels = 0;
+    }
+#endif
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+    if (dev)
+        memset(&dev->breaker, 0, sizeof(dev->breaker));
+#endif
 #if !CONFIG_I2CDEV_NOLOCK
     if (!dev) return ESP_ERR_INVALID_ARG;
 
@@ -145,6 +368,7 @@ esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev)
 {
 #if !CONFIG_I2CDEV_NOLOCK
     if (!dev) return ESP_ERR_INVALID_ARG;
+    if (dev->port < I2C_NUM_MAX && port_owned(dev->port)) return ESP_OK;
 
     ESP_LOGV(TAG, "[0x%02x at %d] taking mutex", dev->addr, dev->port);
 
@@ -161,6 +385,7 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
 {
 #if !CONFIG_I2CDEV_NOLOCK
     if (!dev) return ESP_ERR_INVALID_ARG;
+    if (!dev_mutex_held(dev) && dev->port < I2C_NUM_MAX && port_owned(dev->port)) return ESP_OK;
 
     ESP_LOGV(TAG, "[0x%02x at %d] giving mutex", dev->addr, dev->port);
 
@@ -173,6 +398,278 @@ esp_err_t i2c_dev_give_mutex(i2c_dev_t *dev)
     return ESP_OK;
 }
 
+#if I2CDEV_USE_MASTER_BUS
+
+// Only pins and pull-ups belong to the bus, SCL speed is per device
+inline static bool bus_cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
+{
+    return a->scl_io_num == b->scl_io_num
+        && a->sda_io_num == b->sda_io_num
+        && a->scl_pullup_en == b->scl_pullup_en
+        && a->sda_pullup_en == b->sda_pullup_en;
+}
+
+#if I2CDEV_ASYNC
+static void i2c_async_account(i2c_dev_slot_t *slot, esp_err_t res);
+
+static bool IRAM_ATTR i2c_trans_done(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *evt, void *arg)
+{
+    (void)handle;
+    i2c_dev_slot_t *slot = (i2c_dev_slot_t *)arg;
+    i2c_dev_callback_t cb = slot->cb;
+    if (!cb) return false;
+
+    esp_err_t res = evt->event == I2C_EVENT_DONE ? ESP_OK : ESP_FAIL;
+    i2c_async_account(slot, res);
+    slot->cb = NULL;
+    cb(slot->cb_dev, res, slot->cb_arg);
+    return false;
+}
+#endif
+
+static esp_err_t i2c_setup_port(const i2c_dev_t *dev, i2c_dev_slot_t **out)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    i2c_port_state_t *st = &states[dev->port];
+    esp_err_t res;
+
+    if (!st->installed || !bus_cfg_equal(&dev->cfg, &st->config))
+    {
+        ESP_LOGD(TAG, "Reconfiguring I2C bus on port %d", dev->port);
+        if (st->installed)
+        {
+            i2c_release_bus(dev->port);
+            st->installed = false;
+        }
+
+        i2c_master_bus_config_t bus_cfg = {
+            .i2c_port = dev->port,
+            .sda_io_num = dev->cfg.sda_io_num,
+            .scl_io_num = dev->cfg.scl_io_num,
+            .clk_source = I2C_CLK_SRC_DEFAULT,
+            .glitch_ignore_cnt = 7,
+            .trans_queue_depth = CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH,
+            .flags.enable_internal_pullup = dev->cfg.sda_pullup_en || dev->cfg.scl_pullup_en,
+        };
+        if ((res = i2c_new_master_bus(&bus_cfg, &st->bus)) != ESP_OK)
+            return res;
+
+        st->installed = true;
+        memcpy(&st->config, &dev->cfg, sizeof(i2c_config_t));
+        ESP_LOGD(TAG, "I2C bus successfully reconfigured on port %d", dev->port);
+    }
+
+    // Fast path: same device as the previous transaction
+    i2c_dev_slot_t *slot = &st->devs[st->last];
+    if (slot->handle && slot->addr == dev->addr && slot->clk_speed == dev->cfg.master.clk_speed)
+    {
+        *out = slot;
+        return ESP_OK;
+    }
+
+    i2c_dev_slot_t *free_slot = NULL;
+    for (size_t i = 0; i < CONFIG_I2CDEV_MAX_DEVICES_PER_PORT; i++)
+    {
+        slot = &st->devs[i];
+        if (!slot->handle)
+        {
+            if (!free_slot) free_slot = slot;
+            continue;
+        }
+        if (slot->addr == dev->addr && slot->clk_speed == dev->cfg.master.clk_speed)
+        {
+            st->last = i;
+            *out = slot;
+            return ESP_OK;
+        }
+    }
+
+    if (!free_slot)
+    {
+        // All slots are taken, drop the oldest one
+        free_slot = &st->devs[st->evict];
+        st->evict = (st->evict + 1) % CONFIG_I2CDEV_MAX_DEVICES_PER_PORT;
+        if (free_slot->cb)
+            return ESP_ERR_INVALID_STATE;
+        ESP_LOGD(TAG, "[0x%02x at %d] Releasing cached device handle", free_slot->addr, dev->port);
+        i2c_master_bus_rm_device(free_slot->handle);
+        memset(free_slot, 0, sizeof(i2c_dev_slot_t));
+    }
+
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = dev->addr,
+        .scl_speed_hz = dev->cfg.master.clk_speed,
+    };
+    if ((res = i2c_master_bus_add_device(st->bus, &dev_cfg, &free_slot->handle)) != ESP_OK)
+        return res;
+    free_slot->addr = dev->addr;
+    free_slot->clk_speed = dev->cfg.master.clk_speed;
+
+#if CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0
+    i2c_master_event_callbacks_t cbs = { .on_trans_done = i2c_trans_done };
+    if ((res = i2c_master_register_event_callbacks(free_slot->handle, &cbs, free_slot)) != ESP_OK)
+        return res;
+#endif
+
+    st->last = free_slot - st->devs;
+    *out = free_slot;
+    ESP_LOGD(TAG, "[0x%02x at %d] Added device handle", dev->addr, dev->port);
+    return ESP_OK;
+}
+
+// In async mode the driver queues every transaction, blocking calls wait for completion
+// Driver reports NACK as invalid state before v5.3
+inline static bool I2CDEV_ISR_ATTR i2c_err_is_nack(esp_err_t res)
+{
+    return res == ESP_ERR_INVALID_STATE || res == ESP_ERR_INVALID_RESPONSE || res == ESP_FAIL;
+}
+
+static esp_err_t i2c_wait_done(const i2c_dev_t *dev, esp_err_t res)
+{
+#if CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0
+    if (res == ESP_OK)
+        res = i2c_master_bus_wait_all_done(states[dev->port].bus, CONFIG_I2CDEV_TIMEOUT);
+#else
+    (void)dev;
+#endif
+    return res;
+}
+
+static esp_err_t i2c_do_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    // i2c_master_probe() always issues a write-address probe
+    (void)operation_type;
+    return i2c_master_probe(states[dev->port].bus, dev->addr, CONFIG_I2CDEV_TIMEOUT);
+}
+
+// Run of consecutive segments of the same direction without STOP between them
+typedef struct {
+    const i2c_dev_segment_t *first;
+    size_t count;
+    size_t size;
+    uint8_t *buf;
+    uint8_t stack_buf[I2CDEV_MASTER_WRITE_BUF_SIZE];
+} i2c_run_t;
+
+static size_t i2c_collect_run(const i2c_dev_segment_t *segs, size_t count, size_t i, i2c_run_t *run)
+{
+    i2c_dev_type_t type = segs[i].type;
+    run->first = &segs[i];
+    while (i < count && segs[i].type == type)
+    {
+        run->size += segs[i].size;
+        run->count++;
+        if (segs[i++].stop) break;
+    }
+    return i;
+}
+
+// Single segment runs are used in place, others need a contiguous buffer
+static esp_err_t i2c_run_buffer(i2c_run_t *run, bool gather)
+{
+    if (run->count == 1)
+    {
+        run->buf = run->first->data;
+        return ESP_OK;
+    }
+    run->buf = run->size <= sizeof(run->stack_buf) ? run->stack_buf : malloc(run->size);
+    if (!run->buf) return ESP_ERR_NO_MEM;
+
+    if (gather)
+        for (size_t i = 0, offs = 0; i < run->count; offs += run->first[i].size, i++)
+            memcpy(run->buf + offs, run->first[i].data, run->first[i].size);
+    return ESP_OK;
+}
+
+static void i2c_run_release(i2c_run_t *run, bool scatter)
+{
+    if (run->count <= 1 || !run->buf) return;
+
+    if (scatter)
+        for (size_t i = 0, offs = 0; i < run->count; offs += run->first[i].size, i++)
+            memcpy(run->first[i].data, run->buf + offs, run->first[i].size);
+    if (run->buf != run->stack_buf)
+        free(run->buf);
+}
+
+static esp_err_t i2c_do_transfer(const i2c_dev_t *dev, i2c_dev_slot_t *slot, const i2c_dev_segment_t *segs, size_t count)
+{
+    esp_err_t res = ESP_OK;
+    size_t i = 0;
+
+    while (i < count && res == ESP_OK)
+    {
+        i2c_run_t wr = { 0 }, rd = { 0 };
+
+        // Write followed by read is a single transaction with repeated START
+        if (segs[i].type == I2C_DEV_WRITE)
+        {
+            i = i2c_collect_run(segs, count, i, &wr);
+            if (i < count && !segs[i - 1].stop && segs[i].type == I2C_DEV_READ)
+                i = i2c_collect_run(segs, count, i, &rd);
+        }
+        else
+            i = i2c_collect_run(segs, count, i, &rd);
+
+        if ((wr.count && (res = i2c_run_buffer(&wr, true)) != ESP_OK)
+            || (rd.count && (res = i2c_run_buffer(&rd, false)) != ESP_OK))
+        {
+            i2c_run_release(&wr, false);
+            i2c_run_release(&rd, false);
+            break;
+        }
+
+        if (wr.count && rd.count)
+            res = i2c_master_transmit_receive(slot->handle, wr.buf, wr.size, rd.buf, rd.size, CONFIG_I2CDEV_TIMEOUT);
+        else if (wr.count)
+            res = i2c_master_transmit(slot->handle, wr.buf, wr.size, CONFIG_I2CDEV_TIMEOUT);
+        else
+            res = i2c_master_receive(slot->handle, rd.buf, rd.size, CONFIG_I2CDEV_TIMEOUT);
+
+        // Wait before releasing the buffers, the driver may still be using them
+        res = i2c_wait_done(dev, res);
+
+        i2c_run_release(&wr, false);
+        i2c_run_release(&rd, res == ESP_OK);
+    }
+
+    return res;
+}
+
+#elif HELPER_TARGET_IS_LINUX
+
+static esp_err_t i2c_setup_port(const i2c_dev_t *dev, void **out)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    // Nothing to configure, simulator uses the descriptor directly
+    memcpy(&states[dev->port].config, &dev->cfg, sizeof(i2c_config_t));
+    states[dev->port].installed = true;
+    *out = NULL;
+
+    return ESP_OK;
+}
+
+inline static bool i2c_err_is_nack(esp_err_t res)
+{
+    return res == ESP_FAIL;
+}
+
+static esp_err_t i2c_do_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    return i2cdev_sim_probe(dev, operation_type);
+}
+
+static esp_err_t i2c_do_transfer(const i2c_dev_t *dev, void *slot, const i2c_dev_segment_t *segs, size_t count)
+{
+    (void)slot;
+    return i2cdev_sim_transfer(dev, segs, count);
+}
+
+#else /* I2CDEV_USE_MASTER_BUS */
+
 inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
 {
     return a->scl_io_num == b->scl_io_num
@@ -188,7 +685,7 @@ inline static bool cfg_equal(const i2c_config_t *a, const i2c_config_t *b)
         && a->sda_pullup_en == b->sda_pullup_en;
 }
 
-static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
+static esp_err_t i2c_setup_port(const i2c_dev_t *dev, void **out)
 {
     if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
 
@@ -219,6 +716,8 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
         if ((res = i2c_driver_install(dev->port, temp.mode, 0, 0, 0)) != ESP_OK)
             return res;
 #endif
+        // Force timeout update below
+        states[dev->port].timeout_ticks = 0;
 #endif
 #if HELPER_TARGET_IS_ESP8266
         // Clock Stretch time, depending on CPU frequency
@@ -234,107 +733,1042 @@ static esp_err_t i2c_setup_port(const i2c_dev_t *dev)
         ESP_LOGD(TAG, "I2C driver successfully reconfigured on port %d", dev->port);
     }
 #if HELPER_TARGET_IS_ESP32
-    int t;
-    if ((res = i2c_get_timeout(dev->port, &t)) != ESP_OK)
-        return res;
     // Timeout cannot be 0
     uint32_t ticks = dev->timeout_ticks ? dev->timeout_ticks : I2CDEV_MAX_STRETCH_TIME;
-    if ((ticks != t) && (res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
-        return res;
-    ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", dev->timeout_ticks, dev->timeout_ticks / 80, dev->port);
+    if (ticks != states[dev->port].timeout_ticks)
+    {
+        if ((res = i2c_set_timeout(dev->port, ticks)) != ESP_OK)
+            return res;
+        states[dev->port].timeout_ticks = ticks;
+        ESP_LOGD(TAG, "Timeout: ticks = %" PRIu32 " (%" PRIu32 " usec) on port %d", dev->timeout_ticks, dev->timeout_ticks / 80, dev->port);
+    }
 #endif
 
     return ESP_OK;
 }
 
-esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+inline static bool i2c_err_is_nack(esp_err_t res)
 {
-    if (!dev) return ESP_ERR_INVALID_ARG;
-
-    SEMAPHORE_TAKE(dev->port);
-
-    esp_err_t res = i2c_setup_port(dev);
-    if (res == ESP_OK)
-    {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, dev->addr << 1 | (operation_type == I2C_DEV_READ ? 1 : 0), true);
-        i2c_master_stop(cmd);
-
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+    return res == ESP_FAIL;
+}
 
-        i2c_cmd_link_delete(cmd);
-    }
+static esp_err_t i2c_do_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, dev->addr << 1 | (operation_type == I2C_DEV_READ ? 1 : 0), true);
+    i2c_master_stop(cmd);
 
-    SEMAPHORE_GIVE(dev->port);
+    esp_err_t res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
 
+    i2c_cmd_link_delete(cmd);
     return res;
 }
 
-esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+static esp_err_t i2c_do_transfer(const i2c_dev_t *dev, void *slot, const i2c_dev_segment_t *segs, size_t count)
 {
-    if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
-
-    SEMAPHORE_TAKE(dev->port);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
 
-    esp_err_t res = i2c_setup_port(dev);
-    if (res == ESP_OK)
+    bool start = true;
+    for (size_t i = 0; i < count; i++)
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        if (out_data && out_size)
+        const i2c_dev_segment_t *seg = &segs[i];
+        if (start || seg->type != segs[i - 1].type)
         {
             i2c_master_start(cmd);
-            i2c_master_write_byte(cmd, dev->addr << 1, true);
-            i2c_master_write(cmd, (void *)out_data, out_size, true);
+            i2c_master_write_byte(cmd, (dev->addr << 1) | (seg->type == I2C_DEV_READ ? 1 : 0), true);
         }
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (dev->addr << 1) | 1, true);
-        i2c_master_read(cmd, in_data, in_size, I2C_MASTER_LAST_NACK);
-        i2c_master_stop(cmd);
 
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
-        if (res != ESP_OK)
-            ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
+        bool last = i == count - 1;
+        if (seg->type == I2C_DEV_WRITE)
+            i2c_master_write(cmd, seg->data, seg->size, true);
+        else
+        {
+            // NACK the last byte before STOP or repeated START
+            bool nack = last || seg->stop || segs[i + 1].type != I2C_DEV_READ;
+            i2c_master_read(cmd, seg->data, seg->size, nack ? I2C_MASTER_LAST_NACK : I2C_MASTER_ACK);
+        }
 
-        i2c_cmd_link_delete(cmd);
+        start = seg->stop;
+        if (seg->stop && !last)
+            i2c_master_stop(cmd);
     }
+    i2c_master_stop(cmd);
 
-    SEMAPHORE_GIVE(dev->port);
+    esp_err_t res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
+
+    i2c_cmd_link_delete(cmd);
     return res;
 }
 
-esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
+#endif /* I2CDEV_USE_MASTER_BUS */
+
+#if I2CDEV_USE_MASTER_BUS
+typedef i2c_dev_slot_t *i2c_dev_slot_ptr_t;
+#else
+typedef void *i2c_dev_slot_ptr_t;
+#endif
+
+#if CONFIG_I2CDEV_MUX
+
+static i2c_mux_state_t *i2c_mux_state(const i2c_dev_t *mux)
 {
-    if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
+    i2c_mux_state_t *free_entry = NULL;
+    for (size_t i = 0; i < CONFIG_I2CDEV_MUX_MAX_PER_PORT; i++)
+    {
+        i2c_mux_state_t *st = &states[mux->port].muxes[i];
+        if (st->addr == mux->addr)
+            return st;
+        if (!st->addr && !free_entry)
+            free_entry = st;
+    }
+    if (free_entry)
+    {
+        free_entry->addr = mux->addr;
+        free_entry->known = false;
+    }
+    else
+        ESP_LOGD(TAG, "[0x%02x at %d] Too many muxes, channel selection is not tracked", mux->addr, mux->port);
+    return free_entry;
+}
 
-    SEMAPHORE_TAKE(dev->port);
+// Must be called with port locked
+static esp_err_t i2c_mux_write(const i2c_dev_t *mux, uint8_t channels)
+{
+    esp_err_t res = ESP_OK;
+    // Cascaded muxes: select path to this one first
+    if (mux->mux)
+        res = mux->mux->port == mux->port ? i2c_mux_write(mux->mux, mux->mux_channels) : ESP_ERR_INVALID_ARG;
+    if (res != ESP_OK)
+        return res;
+
+    i2c_mux_state_t *st = i2c_mux_state(mux);
+    if (st && st->known && st->channels == channels)
+        return ESP_OK;
 
-    esp_err_t res = i2c_setup_port(dev);
+    i2c_dev_slot_ptr_t slot;
+    i2c_dev_segment_t seg = I2C_DEV_SEG_WRITE(&channels, 1);
+    res = i2c_setup_port(mux, &slot);
     if (res == ESP_OK)
+        res = i2c_do_transfer(mux, slot, &seg, 1);
+    if (res != ESP_OK)
+        ESP_LOGE(TAG, "Could not select channels 0x%02x on mux [0x%02x at %d]: %d (%s)",
+                channels, mux->addr, mux->port, res, esp_err_to_name(res));
+
+    if (st)
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, dev->addr << 1, true);
-        if (out_reg && out_reg_size)
-            i2c_master_write(cmd, (void *)out_reg, out_reg_size, true);
-        i2c_master_write(cmd, (void *)out_data, out_size, true);
-        i2c_master_stop(cmd);
-        res = i2c_master_cmd_begin(dev->port, cmd, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT));
-        if (res != ESP_OK)
-            ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d (%s)", dev->addr, dev->port, res, esp_err_to_name(res));
-        i2c_cmd_link_delete(cmd);
+        st->channels = channels;
+        st->known = res == ESP_OK;
     }
-
-    SEMAPHORE_GIVE(dev->port);
     return res;
 }
 
-esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+// Must be called with port locked. Switches could have been reset or
+// glitched together with the failed device
+static void i2c_mux_forget(i2c_port_t port)
 {
-    return i2c_dev_read(dev, &reg, 1, in_data, in_size);
+    for (size_t i = 0; i < CONFIG_I2CDEV_MUX_MAX_PER_PORT; i++)
+        states[port].muxes[i].known = false;
 }
 
-esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
+inline static esp_err_t i2c_mux_select(const i2c_dev_t *dev)
 {
-    return i2c_dev_write(dev, &reg, 1, out_data, out_size);
+    if (!dev->mux)
+        return ESP_OK;
+    if (dev->mux->port != dev->port)
+        return ESP_ERR_INVALID_ARG;
+    return i2c_mux_write(dev->mux, dev->mux_channels);
+}
+
+#if CONFIG_I2CDEV_SCHEDULER
+// Unlocked peek, used only as an ordering hint
+static bool i2c_mux_selected(const i2c_dev_t *dev)
+{
+    if (!dev->mux)
+        return true;
+    for (size_t i = 0; i < CONFIG_I2CDEV_MUX_MAX_PER_PORT; i++)
+    {
+        const i2c_mux_state_t *st = &states[dev->port].muxes[i];
+        if (st->addr == dev->mux->addr)
+            return st->known && st->channels == dev->mux_channels;
+    }
+    return false;
 }
+#endif
+
+esp_err_t i2c_dev_set_mux(i2c_dev_t *dev, const i2c_dev_t *mux, uint8_t channels)
+{
+    if (!dev || mux == dev || (mux && mux->port != dev->port)) return ESP_ERR_INVALID_ARG;
+
+    dev->mux = mux;
+    dev->mux_channels = channels;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_mux_select(const i2c_dev_t *mux, uint8_t channels)
+{
+    if (!mux) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(mux->port);
+    esp_err_t res = i2c_mux_write(mux, channels);
+    SEMAPHORE_GIVE(mux->port);
+
+    return res;
+}
+
+#else
+#define i2c_mux_select(dev) ESP_OK
+#define i2c_mux_forget(port)
+#endif /* CONFIG_I2CDEV_MUX */
+
+esp_err_t i2c_dev_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+
+    i2c_dev_slot_ptr_t slot;
+    esp_err_t res = i2c_mux_select(dev);
+    if (res == ESP_OK)
+        res = i2c_setup_port(dev, &slot);
+    if (res == ESP_OK)
+        res = i2c_do_probe(dev, operation_type);
+
+    SEMAPHORE_GIVE(dev->port);
+
+    return res;
+}
+
+#if CONFIG_I2CDEV_BUS_RECOVERY && HELPER_TARGET_IS_ESP32
+
+// Must be called with port locked. Driver is reinstalled by the next i2c_setup_port()
+static void i2c_bus_recover(i2c_port_t port)
+{
+    i2c_port_state_t *st = &states[port];
+    if (!st->installed)
+        return;
+
+    gpio_num_t sda = st->config.sda_io_num;
+    gpio_num_t scl = st->config.scl_io_num;
+    ESP_LOGW(TAG, "Recovering I2C bus on port %d (SDA=%d, SCL=%d)", port, sda, scl);
+
+#if I2CDEV_USE_MASTER_BUS
+    i2c_release_bus(port);
+#else
+    i2c_driver_delete(port);
+#endif
+    st->installed = false;
+    i2c_mux_forget(port);
+
+    gpio_set_level(sda, 1);
+    gpio_set_level(scl, 1);
+    gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+    ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+
+    // Up to 9 clocks let a slave finish the byte it is stuck in
+    for (int i = 0; i < 9 && !gpio_get_level(sda); i++)
+    {
+        gpio_set_level(scl, 0);
+        ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+        gpio_set_level(scl, 1);
+        ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+    }
+
+    // STOP condition
+    gpio_set_level(scl, 0);
+    ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+    gpio_set_level(sda, 0);
+    ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+    gpio_set_level(scl, 1);
+    ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+    gpio_set_level(sda, 1);
+    ets_delay_us(I2CDEV_RECOVERY_DELAY_US);
+
+    if (!gpio_get_level(sda) || !gpio_get_level(scl))
+        ESP_LOGE(TAG, "I2C bus on port %d is still held low", port);
+}
+
+#endif /* CONFIG_I2CDEV_BUS_RECOVERY */
+
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+
+inline static bool breaker_open(const i2c_dev_t *dev)
+{
+    return dev->breaker.timeouts >= CONFIG_I2CDEV_BREAKER_THRESHOLD
+        && (int32_t)(xTaskGetTickCount() - dev->breaker.retry_at) < 0;
+}
+
+// Only timeouts are counted: NACKs are fast and expected from busy devices
+static void breaker_update(const i2c_dev_t *dev, esp_err_t res)
+{
+    i2c_dev_breaker_t *b = &((i2c_dev_t *)dev)->breaker;
+    if (res != ESP_ERR_TIMEOUT)
+    {
+        b->timeouts = 0;
+        b->trips = 0;
+        return;
+    }
+
+    if (b->timeouts < CONFIG_I2CDEV_BREAKER_THRESHOLD)
+        b->timeouts++;
+    if (b->timeouts < CONFIG_I2CDEV_BREAKER_THRESHOLD)
+        return;
+
+    // Back-off doubles with every failed trial, up to 32 times
+    uint32_t backoff_ms = (uint32_t)CONFIG_I2CDEV_BREAKER_BACKOFF << (b->trips < 5 ? b->trips : 5);
+    b->retry_at = xTaskGetTickCount() + pdMS_TO_TICKS(backoff_ms);
+    if (b->trips < UINT8_MAX)
+        b->trips++;
+    ESP_LOGW(TAG, "[0x%02x at %d] Device does not respond, failing fast for %" PRIu32 " ms",
+            dev->addr, dev->port, backoff_ms);
+}
+
+#endif /* CONFIG_I2CDEV_BREAKER_THRESHOLD > 0 */
+
+#if CONFIG_I2CDEV_STATS
+
+// Must be called between STATS_ENTER() and STATS_EXIT()
+static void I2CDEV_ISR_ATTR stats_update(i2c_dev_stats_t *stats, esp_err_t res, size_t bytes, uint32_t lock_us, uint32_t bus_us)
+{
+    stats->transactions++;
+    if (res == ESP_ERR_TIMEOUT)
+        stats->timeouts++;
+    else if (res != ESP_OK && i2c_err_is_nack(res))
+        stats->nacks++;
+    else if (res != ESP_OK)
+        stats->errors++;
+    stats->bytes += bytes;
+    stats->lock_wait_us += lock_us;
+    stats->bus_time_us += bus_us;
+
+    uint32_t latency = lock_us + bus_us;
+    if (latency > stats->max_latency_us)
+        stats->max_latency_us = latency;
+    // bucket 0 is < 128 us, then powers of two up to >= 8 ms
+    int bucket = 0;
+    for (uint32_t v = latency >> 7; v; v >>= 1)
+        bucket++;
+    stats->latency_hist[bucket < I2CDEV_STATS_HIST_SIZE ? bucket : I2CDEV_STATS_HIST_SIZE - 1]++;
+}
+
+#endif /* CONFIG_I2CDEV_STATS */
+
+static esp_err_t i2c_dev_exec(const i2c_dev_t *dev, const i2c_dev_segment_t *segs, size_t count, const char *what)
+{
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+    if (breaker_open(dev))
+    {
+        ESP_LOGD(TAG, "[0x%02x at %d] Circuit breaker is open", dev->addr, dev->port);
+        return ESP_ERR_INVALID_STATE;
+    }
+#endif
+#if CONFIG_I2CDEV_STATS
+    int64_t started = esp_timer_get_time();
+#endif
+    SEMAPHORE_TAKE(dev->port);
+#if CONFIG_I2CDEV_STATS
+    int64_t locked = esp_timer_get_time();
+#endif
+
+    i2c_dev_slot_ptr_t slot;
+    esp_err_t res = i2c_mux_select(dev);
+    if (res == ESP_OK)
+        res = i2c_setup_port(dev, &slot);
+    if (res == ESP_OK)
+    {
+        res = i2c_do_transfer(dev, slot, segs, count);
+        if (res != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Could not %s device [0x%02x at %d]: %d (%s)", what, dev->addr, dev->port, res, esp_err_to_name(res));
+            i2c_mux_forget(dev->port);
+        }
+#if CONFIG_I2CDEV_BUS_RECOVERY && HELPER_TARGET_IS_ESP32
+        if (res == ESP_ERR_TIMEOUT)
+            i2c_bus_recover(dev->port);
+#endif
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+        breaker_update(dev, res);
+#endif
+    }
+#if CONFIG_I2CDEV_STATS
+    uint32_t lock_us = locked - started;
+    uint32_t bus_us = esp_timer_get_time() - locked;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++)
+        bytes += segs[i].size;
+    STATS_ENTER();
+    stats_update(&((i2c_dev_t *)dev)->stats, res, bytes, lock_us, bus_us);
+    stats_update(&states[dev->port].stats, res, bytes, lock_us, bus_us);
+    STATS_EXIT();
+#endif
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    // Device could have been reset or left in unknown state
+    if (res != ESP_OK)
+        ((i2c_dev_t *)dev)->shadow.valid = 0;
+#endif
+
+    SEMAPHORE_GIVE(dev->port);
+    return res;
+}
+
+esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size)
+{
+    if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_segment_t segs[2] = {
+        I2C_DEV_SEG_WRITE(out_data, out_size),
+        I2C_DEV_SEG_READ(in_data, in_size),
+    };
+    bool has_out = out_data && out_size;
+
+    return i2c_dev_exec(dev, has_out ? segs : segs + 1, has_out ? 2 : 1, "read from");
+}
+
+esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size)
+{
+    if (!dev || !out_data || !out_size) return ESP_ERR_INVALID_ARG;
+
+    i2c_dev_segment_t segs[2] = {
+        I2C_DEV_SEG_WRITE(out_reg, out_reg_size),
+        I2C_DEV_SEG_WRITE(out_data, out_size),
+    };
+    bool has_reg = out_reg && out_reg_size;
+
+    return i2c_dev_exec(dev, has_reg ? segs : segs + 1, has_reg ? 2 : 1, "write to");
+}
+
+esp_err_t i2c_dev_transfer(const i2c_dev_t *dev, const i2c_dev_segment_t *segs, size_t count)
+{
+    if (!dev || !segs || !count) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < count; i++)
+        if (!segs[i].data || !segs[i].size) return ESP_ERR_INVALID_ARG;
+
+    return i2c_dev_exec(dev, segs, count, "execute transaction on");
+}
+
+esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+    return i2c_dev_read(dev, &reg, 1, in_data, in_size);
+}
+
+esp_err_t i2c_dev_read_bulk(const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+    if (!dev || !in_data || !in_size || in_size > I2CDEV_BULK_MAX_SIZE) return ESP_ERR_INVALID_ARG;
+
+    // Single segment runs are passed to the driver in place
+    i2c_dev_segment_t segs[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1),
+        I2C_DEV_SEG_READ(in_data, in_size),
+    };
+    return i2c_dev_exec(dev, segs, 2, "read from");
+}
+
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+
+static int shadow_index(const i2c_dev_t *dev, uint8_t reg)
+{
+    for (int i = 0; i < dev->shadow.count; i++)
+        if (dev->shadow.regs[i] == reg)
+            return i;
+    return -1;
+}
+
+static void shadow_drop(i2c_dev_t *dev, uint8_t reg, size_t size)
+{
+    for (size_t i = 0; i < size && dev->shadow.valid; i++)
+    {
+        int idx = shadow_index(dev, reg + i);
+        if (idx >= 0)
+            dev->shadow.valid &= ~(1UL << idx);
+    }
+}
+
+static void shadow_put(i2c_dev_t *dev, uint8_t reg, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        int idx = shadow_index(dev, reg + i);
+        if (idx < 0) continue;
+        dev->shadow.values[idx] = data[i];
+        dev->shadow.valid |= 1UL << idx;
+    }
+}
+
+// Returns true if all registers are cacheable, *hit is true if all of them are cached
+static bool shadow_get(const i2c_dev_t *dev, uint8_t reg, uint8_t *data, size_t size, bool *hit)
+{
+    *hit = true;
+    for (size_t i = 0; i < size; i++)
+    {
+        int idx = shadow_index(dev, reg + i);
+        if (idx < 0)
+            return false;
+        if (dev->shadow.valid & (1UL << idx))
+            data[i] = dev->shadow.values[idx];
+        else
+            *hit = false;
+    }
+    return true;
+}
+
+#endif /* CONFIG_I2CDEV_SHADOW_SIZE > 0 */
+
+esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
+{
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    // Plain writes are not trusted to leave registers in known state
+    if (dev && dev->shadow.count)
+        shadow_drop((i2c_dev_t *)dev, reg, out_size);
+#endif
+    return i2c_dev_write(dev, &reg, 1, out_data, out_size);
+}
+
+esp_err_t i2c_dev_shadow_init(i2c_dev_t *dev, const uint8_t *regs, size_t count)
+{
+    if (!dev || (count && !regs)) return ESP_ERR_INVALID_ARG;
+
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (count > CONFIG_I2CDEV_SHADOW_SIZE)
+    {
+        ESP_LOGW(TAG, "[0x%02x at %d] Only first %d of %d registers will be cached",
+                dev->addr, dev->port, CONFIG_I2CDEV_SHADOW_SIZE, (int)count);
+        count = CONFIG_I2CDEV_SHADOW_SIZE;
+    }
+    dev->shadow.regs = regs;
+    dev->shadow.count = count;
+    dev->shadow.valid = 0;
+#endif
+
+    return ESP_OK;
+}
+
+void i2c_dev_shadow_invalidate(i2c_dev_t *dev)
+{
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (dev)
+        dev->shadow.valid = 0;
+#else
+    (void)dev;
+#endif
+}
+
+void i2c_dev_shadow_set(i2c_dev_t *dev, uint8_t reg, uint8_t value)
+{
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (dev)
+        shadow_put(dev, reg, &value, 1);
+#else
+    (void)dev;
+    (void)reg;
+    (void)value;
+#endif
+}
+
+esp_err_t i2c_dev_read_reg_cached(i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size)
+{
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (!dev || !in_data || !in_size) return ESP_ERR_INVALID_ARG;
+
+    bool hit;
+    if (!dev->shadow.count || !shadow_get(dev, reg, in_data, in_size, &hit))
+        return i2c_dev_read_reg(dev, reg, in_data, in_size);
+    if (hit)
+        return ESP_OK;
+
+    esp_err_t res = i2c_dev_read_reg(dev, reg, in_data, in_size);
+    if (res == ESP_OK)
+        shadow_put(dev, reg, in_data, in_size);
+    return res;
+#else
+    return i2c_dev_read_reg(dev, reg, in_data, in_size);
+#endif
+}
+
+esp_err_t i2c_dev_write_reg_cached(i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size)
+{
+    esp_err_t res = i2c_dev_write_reg(dev, reg, out_data, out_size);
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (res == ESP_OK && dev->shadow.count)
+        shadow_put(dev, reg, out_data, out_size);
+#endif
+    return res;
+}
+
+esp_err_t i2c_dev_update_reg(i2c_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t v;
+    esp_err_t res = i2c_dev_read_reg_cached(dev, reg, &v, 1);
+    if (res != ESP_OK)
+        return res;
+
+    v = (v & ~mask) | (value & mask);
+    return i2c_dev_write_reg_cached(dev, reg, &v, 1);
+}
+
+#if I2CDEV_ASYNC
+
+// Called from completion ISR: same bookkeeping as i2c_dev_exec()
+static void IRAM_ATTR i2c_async_account(i2c_dev_slot_t *slot, esp_err_t res)
+{
+    i2c_dev_t *dev = (i2c_dev_t *)slot->cb_dev;
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+    // Completed transaction is never a timeout
+    dev->breaker.timeouts = 0;
+    dev->breaker.trips = 0;
+#endif
+#if CONFIG_I2CDEV_STATS
+    uint32_t bus_us = esp_timer_get_time() - slot->queued_us;
+    STATS_ENTER();
+    stats_update(&dev->stats, res, slot->bytes, slot->lock_us, bus_us);
+    stats_update(&states[dev->port].stats, res, slot->bytes, slot->lock_us, bus_us);
+    STATS_EXIT();
+#endif
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+    if (res != ESP_OK)
+        dev->shadow.valid = 0;
+#endif
+}
+
+// Write followed by optional read, in_data is NULL for writes
+static esp_err_t i2c_async_exec(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size,
+        i2c_dev_callback_t cb, void *arg, const char *what)
+{
+#if CONFIG_I2CDEV_MUX
+    // Channel could be switched by another task before the queued transaction runs
+    if (dev->mux)
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+    if (breaker_open(dev))
+    {
+        ESP_LOGD(TAG, "[0x%02x at %d] Circuit breaker is open", dev->addr, dev->port);
+        return ESP_ERR_INVALID_STATE;
+    }
+#endif
+#if CONFIG_I2CDEV_STATS
+    int64_t started = esp_timer_get_time();
+#endif
+    SEMAPHORE_TAKE(dev->port);
+
+    i2c_dev_slot_t *slot;
+    esp_err_t res = i2c_setup_port(dev, &slot);
+    if (res == ESP_OK && slot->cb)
+        res = ESP_ERR_INVALID_STATE;
+    if (res != ESP_OK)
+    {
+        SEMAPHORE_GIVE(dev->port);
+        return res;
+    }
+
+#if CONFIG_I2CDEV_STATS
+    slot->queued_us = esp_timer_get_time();
+    slot->lock_us = slot->queued_us - started;
+    slot->bytes = out_size + in_size;
+#endif
+    slot->cb_dev = dev;
+    slot->cb_arg = arg;
+    slot->cb = cb;
+
+    if (in_data && out_data && out_size)
+        res = i2c_master_transmit_receive(slot->handle, out_data, out_size, in_data, in_size, CONFIG_I2CDEV_TIMEOUT);
+    else if (in_data)
+        res = i2c_master_receive(slot->handle, in_data, in_size, CONFIG_I2CDEV_TIMEOUT);
+    else
+        res = i2c_master_transmit(slot->handle, out_data, out_size, CONFIG_I2CDEV_TIMEOUT);
+
+    if (res != ESP_OK)
+    {
+        // Not queued, callback will not be called
+        slot->cb = NULL;
+        ESP_LOGE(TAG, "Could not queue %s device [0x%02x at %d]: %d (%s)", what, dev->addr, dev->port, res, esp_err_to_name(res));
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0
+        breaker_update(dev, res);
+#endif
+#if CONFIG_I2CDEV_STATS
+        STATS_ENTER();
+        stats_update(&((i2c_dev_t *)dev)->stats, res, 0, slot->lock_us, 0);
+        stats_update(&states[dev->port].stats, res, 0, slot->lock_us, 0);
+        STATS_EXIT();
+#endif
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0
+        ((i2c_dev_t *)dev)->shadow.valid = 0;
+#endif
+    }
+
+    SEMAPHORE_GIVE(dev->port);
+    return res;
+}
+
+esp_err_t i2c_dev_read_async(const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size,
+        i2c_dev_callback_t cb, void *arg)
+{
+    if (!dev || !in_data || !in_size || !cb) return ESP_ERR_INVALID_ARG;
+
+    return i2c_async_exec(dev, out_data, out_size, in_data, in_size, cb, arg, "read from");
+}
+
+esp_err_t i2c_dev_write_async(const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        i2c_dev_callback_t cb, void *arg)
+{
+    if (!dev || !out_data || !out_size || !cb) return ESP_ERR_INVALID_ARG;
+
+    return i2c_async_exec(dev, out_data, out_size, NULL, 0, cb, arg, "write to");
+}
+
+#endif
+
+#if CONFIG_I2CDEV_SCHEDULER
+
+static void i2c_request_complete(const i2c_dev_request_t *req, esp_err_t res)
+{
+    if (req->result)
+        *req->result = res;
+    if (req->cb)
+        req->cb(req->dev, res, req->arg);
+    else if (req->notify)
+        xTaskNotifyGive(req->notify);
+}
+
+inline static bool deadline_before(TickType_t a, TickType_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+// Highest priority first, then earliest deadline, then submission order
+static size_t i2c_pick_request(const i2c_dev_request_t *pending, size_t count)
+{
+    size_t best = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        const i2c_dev_request_t *a = &pending[i], *b = &pending[best];
+        if (a->priority != b->priority)
+        {
+            if (a->priority > b->priority) best = i;
+            continue;
+        }
+        if (a->deadline && (!b->deadline || deadline_before(a->deadline, b->deadline)))
+            best = i;
+#if CONFIG_I2CDEV_MUX
+        // Same urgency: prefer devices on already selected mux channels
+        else if (a->deadline == b->deadline && !i2c_mux_selected(b->dev) && i2c_mux_selected(a->dev))
+            best = i;
+#endif
+    }
+    return best;
+}
+
+static void i2c_scheduler_task(void *arg)
+{
+    i2c_port_state_t *st = &states[(i2c_port_t)(intptr_t)arg];
+    i2c_dev_request_t pending[CONFIG_I2CDEV_SCHEDULER_QUEUE_LEN];
+    size_t count = 0;
+    TaskHandle_t stop_waiter = NULL;
+
+    while (true)
+    {
+        // Block only when there is nothing to do
+        i2c_dev_request_t req;
+        TickType_t wait = count || stop_waiter ? 0 : portMAX_DELAY;
+        while (count < CONFIG_I2CDEV_SCHEDULER_QUEUE_LEN && xQueueReceive(st->sched_queue, &req, wait) == pdTRUE)
+        {
+            wait = 0;
+            if (!req.dev)
+                stop_waiter = req.notify;
+            else
+                pending[count++] = req;
+        }
+
+        if (!count)
+        {
+            if (stop_waiter) break;
+            continue;
+        }
+
+        size_t i = i2c_pick_request(pending, count);
+        req = pending[i];
+        memmove(&pending[i], &pending[i + 1], (count - i - 1) * sizeof(i2c_dev_request_t));
+        count--;
+
+        if (req.deadline && deadline_before(req.deadline, xTaskGetTickCount()))
+        {
+            ESP_LOGW(TAG, "[0x%02x at %d] Request deadline missed, dropped", req.dev->addr, req.dev->port);
+            i2c_request_complete(&req, ESP_ERR_TIMEOUT);
+            continue;
+        }
+
+        i2c_request_complete(&req, i2c_dev_exec(req.dev, req.segs, req.count, "execute request on"));
+    }
+
+    xTaskNotifyGive(stop_waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t i2cdev_scheduler_start(i2c_port_t port, UBaseType_t priority)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    if (states[port].sched_task) return ESP_ERR_INVALID_STATE;
+#if CONFIG_I2CDEV_PORT_OWNER
+    if (states[port].owner) return ESP_ERR_INVALID_STATE;
+#endif
+
+    states[port].sched_queue = xQueueCreate(CONFIG_I2CDEV_SCHEDULER_QUEUE_LEN, sizeof(i2c_dev_request_t));
+    if (!states[port].sched_queue)
+    {
+        ESP_LOGE(TAG, "Could not create scheduler queue for port %d", port);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(i2c_scheduler_task, "i2cdev_sched", CONFIG_I2CDEV_SCHEDULER_STACK_SIZE,
+            (void *)(intptr_t)port, priority, &states[port].sched_task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Could not create scheduler task for port %d", port);
+        vQueueDelete(states[port].sched_queue);
+        states[port].sched_queue = NULL;
+        states[port].sched_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_scheduler_stop(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+    if (!states[port].sched_task) return ESP_ERR_INVALID_STATE;
+
+    // NULL device is the stop marker, queued requests are executed first
+    i2c_dev_request_t stop = { .dev = NULL, .notify = xTaskGetCurrentTaskHandle() };
+    xQueueSend(states[port].sched_queue, &stop, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    vQueueDelete(states[port].sched_queue);
+    states[port].sched_queue = NULL;
+    states[port].sched_task = NULL;
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_submit(const i2c_dev_request_t *req, TickType_t timeout)
+{
+    if (!req || !req->dev || !req->segs || !req->count) return ESP_ERR_INVALID_ARG;
+    if (req->dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    QueueHandle_t queue = states[req->dev->port].sched_queue;
+    if (!queue) return ESP_ERR_INVALID_STATE;
+
+    return xQueueSend(queue, req, timeout) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+#endif /* CONFIG_I2CDEV_SCHEDULER */
+
+#define I2CDEV_STREAM_BACKGROUND (I2CDEV_ASYNC || CONFIG_I2CDEV_SCHEDULER)
+
+#if I2CDEV_ASYNC
+static void IRAM_ATTR stream_async_done(const i2c_dev_t *dev, esp_err_t result, void *arg)
+{
+    (void)dev;
+    i2c_dev_stream_t *stream = (i2c_dev_stream_t *)arg;
+    BaseType_t woken = pdFALSE;
+    stream->result = result;
+    xSemaphoreGiveFromISR(stream->done, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+#endif
+
+#if CONFIG_I2CDEV_SCHEDULER
+static void stream_task_done(const i2c_dev_t *dev, esp_err_t result, void *arg)
+{
+    (void)dev;
+    i2c_dev_stream_t *stream = (i2c_dev_stream_t *)arg;
+    stream->result = result;
+    xSemaphoreGive(stream->done);
+}
+#endif
+
+// Try to run active request in background, otherwise it will be executed by the next call
+static void stream_start(i2c_dev_stream_t *stream)
+{
+    stream->background = false;
+#if I2CDEV_ASYNC
+    if (i2c_dev_read_async(stream->dev, &stream->reg, 1, stream->buf[stream->active],
+            stream->size[stream->active], stream_async_done, stream) == ESP_OK)
+    {
+        stream->background = true;
+        return;
+    }
+#endif
+#if CONFIG_I2CDEV_SCHEDULER
+    stream->segs[0] = (i2c_dev_segment_t)I2C_DEV_SEG_WRITE(&stream->reg, 1);
+    stream->segs[1] = (i2c_dev_segment_t)I2C_DEV_SEG_READ(stream->buf[stream->active], stream->size[stream->active]);
+    i2c_dev_request_t req = {
+        .dev = stream->dev,
+        .segs = stream->segs,
+        .count = 2,
+        .cb = stream_task_done,
+        .arg = stream,
+    };
+    if (i2c_dev_submit(&req, 0) == ESP_OK)
+        stream->background = true;
+#endif
+}
+
+esp_err_t i2c_dev_stream_init(i2c_dev_stream_t *stream, const i2c_dev_t *dev, uint8_t reg,
+        void *buf0, void *buf1, size_t buf_size)
+{
+    if (!stream || !dev || !buf0 || !buf1 || !buf_size || buf_size > I2CDEV_BULK_MAX_SIZE)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(stream, 0, sizeof(i2c_dev_stream_t));
+    stream->dev = dev;
+    stream->reg = reg;
+    stream->buf[0] = buf0;
+    stream->buf[1] = buf1;
+    stream->buf_size = buf_size;
+#if I2CDEV_STREAM_BACKGROUND
+    stream->done = xSemaphoreCreateBinary();
+    if (!stream->done)
+        return ESP_ERR_NO_MEM;
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_stream_next(i2c_dev_stream_t *stream, size_t next_size, uint8_t **data, size_t *size)
+{
+    if (!stream || !stream->dev || !data || !size || next_size > stream->buf_size)
+        return ESP_ERR_INVALID_ARG;
+
+    uint8_t cur = stream->active;
+    esp_err_t res = ESP_OK;
+    *data = NULL;
+    *size = 0;
+
+    if (stream->size[cur])
+    {
+        if (stream->background)
+        {
+            // Request is still pending, buffers cannot be touched
+            if (!xSemaphoreTake(stream->done, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT)))
+                return ESP_ERR_TIMEOUT;
+            stream->background = false;
+            res = stream->result;
+        }
+        else
+            res = i2c_dev_read_bulk(stream->dev, stream->reg, stream->buf[cur], stream->size[cur]);
+
+        if (res == ESP_OK)
+        {
+            *data = stream->buf[cur];
+            *size = stream->size[cur];
+        }
+        stream->size[cur] = 0;
+    }
+
+    if (next_size)
+    {
+        stream->active = cur ^ 1;
+        stream->size[stream->active] = next_size;
+        stream_start(stream);
+    }
+
+    return res;
+}
+
+esp_err_t i2c_dev_stream_free(i2c_dev_stream_t *stream)
+{
+    if (!stream) return ESP_ERR_INVALID_ARG;
+
+    if (stream->background && !xSemaphoreTake(stream->done, pdMS_TO_TICKS(CONFIG_I2CDEV_TIMEOUT)))
+        return ESP_ERR_TIMEOUT;
+    stream->background = false;
+    stream->size[0] = stream->size[1] = 0;
+    if (stream->done)
+        vSemaphoreDelete(stream->done);
+    stream->done = NULL;
+
+    return ESP_OK;
+}
+
+#if CONFIG_I2CDEV_STATS
+
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *stats)
+{
+    if (!dev || !stats) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+    STATS_ENTER();
+    *stats = dev->stats;
+    STATS_EXIT();
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_reset_stats(i2c_dev_t *dev)
+{
+    if (!dev) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(dev->port);
+    STATS_ENTER();
+    memset(&dev->stats, 0, sizeof(dev->stats));
+    STATS_EXIT();
+    SEMAPHORE_GIVE(dev->port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_get_port_stats(i2c_port_t port, i2c_dev_stats_t *stats)
+{
+    if (port >= I2C_NUM_MAX || !stats) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+    STATS_ENTER();
+    *stats = states[port].stats;
+    STATS_EXIT();
+    SEMAPHORE_GIVE(port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_reset_port_stats(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    SEMAPHORE_TAKE(port);
+    STATS_ENTER();
+    memset(&states[port].stats, 0, sizeof(i2c_dev_stats_t));
+    STATS_EXIT();
+    SEMAPHORE_GIVE(port);
+
+    return ESP_OK;
+}
+
+static void stats_dump(const char *name, int addr, i2c_port_t port, const i2c_dev_stats_t *s)
+{
+    char hist[I2CDEV_STATS_HIST_SIZE * 11 + 1];
+    size_t len = 0;
+    for (size_t i = 0; i < I2CDEV_STATS_HIST_SIZE; i++)
+        len += snprintf(hist + len, sizeof(hist) - len, "%s%" PRIu32, i ? " " : "", s->latency_hist[i]);
+
+    ESP_LOGI(TAG, "[%s 0x%02x at %d] trans=%" PRIu32 " bytes=%" PRIu64 " nack=%" PRIu32 " timeout=%" PRIu32
+            " err=%" PRIu32 " bus=%" PRIu64 "us lock=%" PRIu64 "us max=%" PRIu32 "us hist=[%s]",
+            name, addr, port, s->transactions, s->bytes, s->nacks, s->timeouts, s->errors,
+            s->bus_time_us, s->lock_wait_us, s->max_latency_us, hist);
+}
+
+void i2c_dev_dump_stats(const i2c_dev_t *dev)
+{
+    i2c_dev_stats_t stats;
+    if (i2c_dev_get_stats(dev, &stats) == ESP_OK)
+        stats_dump("dev", dev->addr, dev->port, &stats);
+}
+
+void i2cdev_dump_port_stats(i2c_port_t port)
+{
+    i2c_dev_stats_t stats;
+    if (i2cdev_get_port_stats(port, &stats) == ESP_OK)
+        stats_dump("port", 0, port, &stats);
+}
+
+#endif /* CONFIG_I2CDEV_STATS */
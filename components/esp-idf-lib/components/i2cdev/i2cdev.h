@@ -35,17 +35,49 @@
 #ifndef __I2CDEV_H__
 #define __I2CDEV_H__
 
-#include <driver/i2c.h>
+#include <stdbool.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <esp_err.h>
 #include <esp_idf_lib_helpers.h>
+#if !HELPER_TARGET_IS_LINUX
+#include <driver/i2c.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#if HELPER_TARGET_IS_ESP8266
+#if HELPER_TARGET_IS_LINUX
+
+/* There is no I2C driver on linux target, transactions are routed to
+ * the device models of the simulator, see i2cdev_sim.h */
+
+#define I2C_NUM_MAX 2 //!< Number of simulated ports
+
+typedef int i2c_port_t;
+typedef int gpio_num_t;
+
+/**
+ * Subset of ESP-IDF I2C configuration used by drivers
+ */
+typedef struct
+{
+    int mode;
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    struct
+    {
+        uint32_t clk_speed; //!< Bus clock used for latency calculation, 0 means 100 kHz
+    } master;
+} i2c_config_t;
+
+#define I2CDEV_MAX_STRETCH_TIME 0xffffffff
+
+#elif HELPER_TARGET_IS_ESP8266
 
 #define I2CDEV_MAX_STRETCH_TIME 0xffffffff
 
@@ -60,12 +92,75 @@ extern "C" {
 #define I2CDEV_MAX_STRETCH_TIME 0x00ffffff
 #endif
 
-#endif /* HELPER_TARGET_IS_ESP8266 */
+#endif /* HELPER_TARGET_IS_LINUX */
+
+#if HELPER_TARGET_IS_ESP32 && CONFIG_I2CDEV_USE_MASTER_BUS
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 2, 0)
+#error "CONFIG_I2CDEV_USE_MASTER_BUS requires ESP-IDF v5.2 or newer"
+#endif
+#define I2CDEV_USE_MASTER_BUS 1 //!< Transactions go through the i2c_master bus/device driver
+#else
+#define I2CDEV_USE_MASTER_BUS 0
+#endif
+
+#define I2CDEV_BULK_MAX_SIZE 1024 //!< Maximal size of ::i2c_dev_read_bulk() transaction
+
+#if CONFIG_I2CDEV_STATS || defined(__DOXYGEN__)
+
+#define I2CDEV_STATS_HIST_SIZE 8 //!< Number of latency histogram buckets
 
 /**
- * I2C device descriptor
+ * Transaction statistics of a device or a port
+ */
+typedef struct
+{
+    uint32_t transactions;    //!< Number of transactions
+    uint32_t nacks;           //!< Transactions failed with NACK
+    uint32_t timeouts;        //!< Transactions failed with timeout
+    uint32_t errors;          //!< Transactions failed with other errors
+    uint64_t bytes;           //!< Bytes transferred
+    uint64_t lock_wait_us;    //!< Total time spent waiting for the port lock, us
+    uint64_t bus_time_us;     //!< Total time spent in transactions, us
+    uint32_t max_latency_us;  //!< Maximal transaction latency including lock wait, us
+    uint32_t latency_hist[I2CDEV_STATS_HIST_SIZE]; /*!< Latency histogram: < 128 us, < 256 us, ...,
+                                                        < 8 ms, >= 8 ms */
+} i2c_dev_stats_t;
+
+#endif
+
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0 || defined(__DOXYGEN__)
+
+/**
+ * Register shadow cache of a device, see ::i2c_dev_shadow_init()
+ */
+typedef struct
+{
+    const uint8_t *regs;                       //!< Addresses of cacheable registers
+    uint8_t count;                             //!< Number of cacheable registers
+    uint32_t valid;                            //!< Bitmask of valid cached values
+    uint8_t values[CONFIG_I2CDEV_SHADOW_SIZE]; //!< Cached register values
+} i2c_dev_shadow_t;
+
+#endif
+
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0 || defined(__DOXYGEN__)
+
+/**
+ * Circuit breaker state of a device
  */
 typedef struct
+{
+    uint8_t timeouts;     //!< Consecutive timeouts
+    uint8_t trips;        //!< Consecutive breaker trips, back-off doubles with each one
+    TickType_t retry_at;  //!< Tick count of the next trial transaction when breaker is open
+} i2c_dev_breaker_t;
+
+#endif
+
+/**
+ * I2C device descriptor
+ */
+typedef struct i2c_dev_t
 {
     i2c_port_t port;         //!< I2C port number
     i2c_config_t cfg;        //!< I2C driver configuration
@@ -74,6 +169,21 @@ typedef struct
     uint32_t timeout_ticks;  /*!< HW I2C bus timeout (stretch time), in ticks. 80MHz APB clock
                                   ticks for ESP-IDF, CPU ticks for ESP8266.
                                   When this value is 0, I2CDEV_MAX_STRETCH_TIME will be used */
+#if CONFIG_I2CDEV_SHADOW_SIZE > 0 || defined(__DOXYGEN__)
+    i2c_dev_shadow_t shadow; //!< Register shadow cache, see ::i2c_dev_shadow_init()
+#endif
+#if CONFIG_I2CDEV_STATS || defined(__DOXYGEN__)
+    i2c_dev_stats_t stats;   //!< Transaction statistics, see ::i2c_dev_get_stats()
+#endif
+#if CONFIG_I2CDEV_MUX || defined(__DOXYGEN__)
+    const struct i2c_dev_t *mux; //!< I2C switch the device is connected to, see ::i2c_dev_set_mux()
+    uint8_t mux_channels;        //!< Channels to select on the switch
+#endif
+#if CONFIG_I2CDEV_BREAKER_THRESHOLD > 0 || defined(__DOXYGEN__)
+    i2c_dev_breaker_t breaker;   /*!< After CONFIG_I2CDEV_BREAKER_THRESHOLD timeouts in a row
+                                      transactions fail with ESP_ERR_INVALID_STATE
+                                      without touching the bus for a back-off period */
+#endif
 } i2c_dev_t;
 
 /**
@@ -84,6 +194,34 @@ typedef enum {
     I2C_DEV_READ       /**< Read operation */
 } i2c_dev_type_t;
 
+/**
+ * Segment of a batched transaction, see ::i2c_dev_transfer()
+ */
+typedef struct
+{
+    i2c_dev_type_t type; //!< Segment direction
+    void *data;          //!< Data to send or buffer for received data
+    size_t size;         //!< Number of bytes
+    bool stop;           //!< Issue STOP after this segment instead of repeated START
+} i2c_dev_segment_t;
+
+/**
+ * Initializer of a write segment
+ */
+#define I2C_DEV_SEG_WRITE(buf, len) { .type = I2C_DEV_WRITE, .data = (void *)(buf), .size = (len), .stop = false }
+
+/**
+ * Initializer of a read segment
+ */
+#define I2C_DEV_SEG_READ(buf, len) { .type = I2C_DEV_READ, .data = (buf), .size = (len), .stop = false }
+
+/**
+ * Completion callback of an asynchronous transaction.
+ *
+ * Called from ISR context, must be short and IRAM-safe.
+ */
+typedef void (*i2c_dev_callback_t)(const i2c_dev_t *dev, esp_err_t result, void *arg);
+
 /**
  * @brief Init library
  *
@@ -123,10 +261,43 @@ esp_err_t i2c_dev_create_mutex(i2c_dev_t *dev);
  */
 esp_err_t i2c_dev_delete_mutex(i2c_dev_t *dev);
 
+#if CONFIG_I2CDEV_PORT_OWNER || defined(__DOXYGEN__)
+
+/**
+ * @brief Bind I2C port to a single task
+ *
+ * While the port is bound, port and device mutexes of its devices are not
+ * taken: all transactions on the port and all driver calls for its devices
+ * must be made by the owner task. With assertions enabled this is checked
+ * on every transaction. Bound port cannot be used from ISRs.
+ *
+ * Bind the port before the owner starts using it and while no other task
+ * holds a device mutex on it. Not available while the port scheduler
+ * is running.
+ *
+ * @param port I2C port number
+ * @param task Owner task, NULL for the calling task
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_port_bind(i2c_port_t port, TaskHandle_t task);
+
+/**
+ * @brief Unbind I2C port, locking is restored
+ *
+ * Must be called by the owner task.
+ *
+ * @param port I2C port number
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if port is not bound
+ */
+esp_err_t i2cdev_port_unbind(i2c_port_t port);
+
+#endif
+
 /**
  * @brief Take device mutex
  *
- * This function does nothing if option CONFIG_I2CDEV_NOLOCK is enabled.
+ * This function does nothing if option CONFIG_I2CDEV_NOLOCK is enabled
+ * or the port of the device is bound to a task, see ::i2cdev_port_bind().
  *
  * @param dev Device descriptor
  * @return ESP_OK on success
@@ -136,7 +307,8 @@ esp_err_t i2c_dev_take_mutex(i2c_dev_t *dev);
 /**
  * @brief Give device mutex
  *
- * This function does nothing if option CONFIG_I2CDEV_NOLOCK is enabled.
+ * This function does nothing if option CONFIG_I2CDEV_NOLOCK is enabled
+ * or the port of the device is bound to a task, see ::i2cdev_port_bind().
  *
  * @param dev Device descriptor
  * @return ESP_OK on success
@@ -187,6 +359,36 @@ esp_err_t i2c_dev_read(const i2c_dev_t *dev, const void *out_data,
 esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg,
         size_t out_reg_size, const void *out_data, size_t out_size);
 
+/**
+ * @brief Execute a list of read/write segments as one transaction
+ *
+ * All segments are executed under a single port lock acquisition.
+ * Consecutive segments of the same direction are merged into one transfer,
+ * a change of direction is done with a repeated START unless the previous
+ * segment has the `stop` flag set. With the legacy driver the whole list
+ * is a single command link.
+ *
+ * With CONFIG_I2CDEV_USE_MASTER_BUS a read followed by a write always
+ * ends the transfer with STOP.
+ *
+ * Typical use is reading several register blocks at once:
+ *
+ *     uint8_t r1 = REG_A, r2 = REG_B;
+ *     i2c_dev_segment_t segs[] = {
+ *         I2C_DEV_SEG_WRITE(&r1, 1), I2C_DEV_SEG_READ(buf_a, 4),
+ *         I2C_DEV_SEG_WRITE(&r2, 1), I2C_DEV_SEG_READ(buf_b, 8),
+ *     };
+ *     i2c_dev_transfer(dev, segs, 4);
+ *
+ * Function is thread-safe.
+ *
+ * @param dev Device descriptor
+ * @param segs Array of segments
+ * @param count Number of segments
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_transfer(const i2c_dev_t *dev, const i2c_dev_segment_t *segs, size_t count);
+
 /**
  * @brief Read from register with an 8-bit address
  *
@@ -201,6 +403,89 @@ esp_err_t i2c_dev_write(const i2c_dev_t *dev, const void *out_reg,
 esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
         void *in_data, size_t in_size);
 
+/**
+ * @brief Read large block from register with an 8-bit address
+ *
+ * Reads up to ::I2CDEV_BULK_MAX_SIZE bytes, e.g. FIFO contents, in a single
+ * transaction directly into \p in_data without intermediate buffers.
+ * Register pointer is not incremented by FIFO-capable devices, so the whole
+ * burst comes from the FIFO data register.
+ *
+ * Transaction must fit in CONFIG_I2CDEV_TIMEOUT: 1 KB takes about 93 ms
+ * at 100 kHz and 24 ms at 400 kHz.
+ *
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_read_bulk(const i2c_dev_t *dev, uint8_t reg,
+        void *in_data, size_t in_size);
+
+/**
+ * Double-buffered stream of bulk reads, see ::i2c_dev_stream_next().
+ * All fields are internal.
+ */
+typedef struct
+{
+    const i2c_dev_t *dev;      //!< Device descriptor
+    uint8_t reg;               //!< Data register
+    uint8_t *buf[2];           //!< Buffers
+    size_t buf_size;           //!< Size of each buffer
+    size_t size[2];            //!< Number of bytes requested into each buffer
+    uint8_t active;            //!< Buffer of the last request
+    bool background;           //!< Last request is executed in background
+    esp_err_t result;          //!< Result of the background request
+    SemaphoreHandle_t done;    //!< Given when background request is complete
+#if CONFIG_I2CDEV_SCHEDULER
+    i2c_dev_segment_t segs[2]; //!< Segments of the scheduler request
+#endif
+} i2c_dev_stream_t;
+
+/**
+ * @brief Initialize double-buffered stream of bulk reads
+ *
+ * @param stream Stream descriptor
+ * @param dev Device descriptor
+ * @param reg Data register, usually FIFO data
+ * @param buf0 First buffer
+ * @param buf1 Second buffer
+ * @param buf_size Size of each buffer, up to ::I2CDEV_BULK_MAX_SIZE
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_stream_init(i2c_dev_stream_t *stream, const i2c_dev_t *dev, uint8_t reg,
+        void *buf0, void *buf1, size_t buf_size);
+
+/**
+ * @brief Get data of previous request and start the next one
+ *
+ * Returns the buffer filled by the request made by the previous call and
+ * requests \p next_size bytes into the other buffer. Caller processes
+ * returned data while the next burst is transferred, the buffer stays
+ * valid until the next call.
+ *
+ * Next request runs in background with CONFIG_I2CDEV_USE_MASTER_BUS and
+ * CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0 (not for devices behind I2C switch),
+ * or when port scheduler is running (CONFIG_I2CDEV_SCHEDULER). Otherwise
+ * it is executed by the next call.
+ *
+ * @param stream Stream descriptor
+ * @param next_size Number of bytes to request, 0 to request nothing
+ * @param[out] data Data of previous request, NULL if there was none
+ * @param[out] size Size of data
+ * @return ESP_OK on success, result of the previous request otherwise
+ */
+esp_err_t i2c_dev_stream_next(i2c_dev_stream_t *stream, size_t next_size, uint8_t **data, size_t *size);
+
+/**
+ * @brief Wait for pending request and release stream resources
+ *
+ * @param stream Stream descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_stream_free(i2c_dev_stream_t *stream);
+
 /**
  * @brief Write to register with an 8-bit address
  *
@@ -215,6 +500,283 @@ esp_err_t i2c_dev_read_reg(const i2c_dev_t *dev, uint8_t reg,
 esp_err_t i2c_dev_write_reg(const i2c_dev_t *dev, uint8_t reg,
         const void *out_data, size_t out_size);
 
+/**
+ * @brief Enable register shadow cache for device
+ *
+ * Listed registers must be non-volatile: their values may change only
+ * by writes from the host. Multi-byte accesses assume register address
+ * auto-increment. Registers beyond CONFIG_I2CDEV_SHADOW_SIZE are not cached.
+ *
+ * Cache is used only by ::i2c_dev_read_reg_cached(), ::i2c_dev_write_reg_cached()
+ * and ::i2c_dev_update_reg(). ::i2c_dev_write_reg() invalidates affected
+ * registers, any failed transaction invalidates the whole cache.
+ * Raw ::i2c_dev_write() and ::i2c_dev_transfer() bypass it.
+ *
+ * Must be called after ::i2c_dev_create_mutex().
+ *
+ * @param dev Device descriptor
+ * @param regs Array of cacheable register addresses, must stay valid
+ * @param count Number of registers
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_shadow_init(i2c_dev_t *dev, const uint8_t *regs, size_t count);
+
+/**
+ * @brief Invalidate register shadow cache
+ *
+ * Must be called after device reset.
+ *
+ * @param dev Device descriptor
+ */
+void i2c_dev_shadow_invalidate(i2c_dev_t *dev);
+
+/**
+ * @brief Set cached value of register without bus access
+ *
+ * Used for registers with self-clearing bits. Ignored if register
+ * is not cacheable.
+ *
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param value Value of register as it is in device
+ */
+void i2c_dev_shadow_set(i2c_dev_t *dev, uint8_t reg, uint8_t value);
+
+/**
+ * @brief Read from register using shadow cache
+ *
+ * Same as ::i2c_dev_read_reg(), but cacheable registers are read
+ * from the bus only once.
+ *
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_read_reg_cached(i2c_dev_t *dev, uint8_t reg,
+        void *in_data, size_t in_size);
+
+/**
+ * @brief Write to register and update shadow cache
+ *
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param out_data Pointer to data to send
+ * @param out_size Size of data to send
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_write_reg_cached(i2c_dev_t *dev, uint8_t reg,
+        const void *out_data, size_t out_size);
+
+/**
+ * @brief Read-modify-write bits of 8-bit register
+ *
+ * Costs one write when register value is cached.
+ *
+ * @param dev Device descriptor
+ * @param reg Register address
+ * @param mask Bits to change
+ * @param value New values of bits, in place
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_update_reg(i2c_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t value);
+
+#if I2CDEV_USE_MASTER_BUS && CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0 || defined(__DOXYGEN__)
+
+/**
+ * @brief Start an asynchronous read from slave device
+ *
+ * Same as ::i2c_dev_read() but returns as soon as the transaction is queued.
+ * \p out_data and \p in_data must stay valid until \p cb is called.
+ * Only one asynchronous transaction per device can be pending.
+ * Circuit breaker, statistics and shadow cache are updated like for
+ * blocking transactions, statistics when the transaction completes.
+ * Devices behind I2C switches are not supported: the channel could
+ * be switched before the queued transaction runs.
+ *
+ * Available only with CONFIG_I2CDEV_USE_MASTER_BUS and
+ * CONFIG_I2CDEV_ASYNC_QUEUE_DEPTH > 0.
+ *
+ * @param dev Device descriptor
+ * @param out_data Pointer to data to send if non-null
+ * @param out_size Size of data to send
+ * @param[out] in_data Pointer to input data buffer
+ * @param in_size Number of byte to read
+ * @param cb Completion callback
+ * @param arg Callback argument
+ * @return ESP_OK if transaction was queued, ESP_ERR_NOT_SUPPORTED for
+ *         devices behind I2C switch
+ */
+esp_err_t i2c_dev_read_async(const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        void *in_data, size_t in_size, i2c_dev_callback_t cb, void *arg);
+
+/**
+ * @brief Start an asynchronous write to slave device
+ *
+ * Unlike ::i2c_dev_write() register address must be the part of \p out_data .
+ * \p out_data must stay valid until \p cb is called.
+ * Same restrictions as for ::i2c_dev_read_async() apply.
+ *
+ * @param dev Device descriptor
+ * @param out_data Pointer to data to send
+ * @param out_size Size of data to send
+ * @param cb Completion callback
+ * @param arg Callback argument
+ * @return ESP_OK if transaction was queued, ESP_ERR_NOT_SUPPORTED for
+ *         devices behind I2C switch
+ */
+esp_err_t i2c_dev_write_async(const i2c_dev_t *dev, const void *out_data, size_t out_size,
+        i2c_dev_callback_t cb, void *arg);
+
+#endif
+
+#if CONFIG_I2CDEV_SCHEDULER || defined(__DOXYGEN__)
+
+/**
+ * Request for the port scheduler task, see ::i2c_dev_submit()
+ */
+typedef struct
+{
+    const i2c_dev_t *dev;          //!< Device descriptor
+    const i2c_dev_segment_t *segs; //!< Transaction segments, must stay valid until completion
+    size_t count;                  //!< Number of segments
+    uint8_t priority;              //!< Higher priority requests are executed first
+    TickType_t deadline;           /*!< Absolute tick count. Requests with the same priority
+                                        are executed earliest deadline first, requests not
+                                        started before the deadline complete with ESP_ERR_TIMEOUT.
+                                        0 means no deadline */
+    i2c_dev_callback_t cb;         //!< Completion callback, called from the scheduler task
+    void *arg;                     //!< Callback argument
+    TaskHandle_t notify;           //!< Task to notify with xTaskNotifyGive() when cb is NULL
+    esp_err_t *result;             //!< Where to store the result if non-null
+} i2c_dev_request_t;
+
+/**
+ * @brief Start scheduler task for I2C port
+ *
+ * The task owns the port and executes submitted requests ordered by
+ * priority and deadline. Blocking functions still can be used
+ * on the same port.
+ *
+ * @param port I2C port number
+ * @param priority Scheduler task priority
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_scheduler_start(i2c_port_t port, UBaseType_t priority);
+
+/**
+ * @brief Stop scheduler task for I2C port
+ *
+ * Requests submitted before this call are executed first.
+ *
+ * @param port I2C port number
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_scheduler_stop(i2c_port_t port);
+
+/**
+ * @brief Submit request to the port scheduler
+ *
+ * Request descriptor is copied, so it can be reused after this call,
+ * but segments and their buffers must stay valid until completion.
+ *
+ * @param req Request
+ * @param timeout Ticks to wait for free space in the scheduler queue
+ * @return ESP_OK if request was queued
+ */
+esp_err_t i2c_dev_submit(const i2c_dev_request_t *req, TickType_t timeout);
+
+#endif
+
+#if CONFIG_I2CDEV_MUX || defined(__DOXYGEN__)
+
+/**
+ * @brief Connect device to a channel of I2C switch
+ *
+ * Switch must be a TCA9548/PCA954x-like device selecting channels with
+ * a single control byte. Before every transaction with the device
+ * i2cdev selects the channels, the write is skipped when they are
+ * already selected. Switches can be cascaded.
+ *
+ * Must be called after ::i2c_dev_create_mutex().
+ *
+ * @param dev Device descriptor
+ * @param mux Switch descriptor on the same port, NULL to connect directly
+ * @param channels Channel mask to select
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_set_mux(i2c_dev_t *dev, const i2c_dev_t *mux, uint8_t channels);
+
+/**
+ * @brief Select channels on I2C switch
+ *
+ * Like plain control byte write, but keeps track of selected channels.
+ *
+ * @param mux Switch descriptor
+ * @param channels Channel mask
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_mux_select(const i2c_dev_t *mux, uint8_t channels);
+
+#endif
+
+#if CONFIG_I2CDEV_STATS || defined(__DOXYGEN__)
+
+/**
+ * @brief Get transaction statistics of device
+ *
+ * Blocking, scheduled and asynchronous transactions are counted,
+ * probes are not. Bus time of asynchronous transactions includes
+ * time spent in the driver queue.
+ *
+ * @param dev Device descriptor
+ * @param[out] stats Statistics
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_get_stats(const i2c_dev_t *dev, i2c_dev_stats_t *stats);
+
+/**
+ * @brief Reset transaction statistics of device
+ *
+ * @param dev Device descriptor
+ * @return ESP_OK on success
+ */
+esp_err_t i2c_dev_reset_stats(i2c_dev_t *dev);
+
+/**
+ * @brief Get transaction statistics of all devices on port
+ *
+ * @param port I2C port number
+ * @param[out] stats Statistics
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_get_port_stats(i2c_port_t port, i2c_dev_stats_t *stats);
+
+/**
+ * @brief Reset transaction statistics of port
+ *
+ * @param port I2C port number
+ * @return ESP_OK on success
+ */
+esp_err_t i2cdev_reset_port_stats(i2c_port_t port);
+
+/**
+ * @brief Log device statistics as one line
+ *
+ * @param dev Device descriptor
+ */
+void i2c_dev_dump_stats(const i2c_dev_t *dev);
+
+/**
+ * @brief Log port statistics as one line
+ *
+ * @param port I2C port number
+ */
+void i2cdev_dump_port_stats(i2c_port_t port);
+
+#endif
+
 #define I2C_DEV_TAKE_MUTEX(dev) do { \
         esp_err_t __ = i2c_dev_take_mutex(dev); \
         if (__ != ESP_OK) return __;\
@@ -0,0 +1,267 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2cdev_sim.c
+ *
+ * I2C bus simulator for linux target
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <esp_log.h>
+#include "i2cdev_sim.h"
+
+#define SIM_DEFAULT_CLK_SPEED 100000
+
+static const char *TAG = "i2cdev_sim";
+
+typedef struct
+{
+    i2cdev_sim_dev_t *devs;
+    uint32_t overhead_us;
+    bool realtime;
+} sim_port_t;
+
+static sim_port_t ports[I2C_NUM_MAX];
+
+int64_t i2cdev_sim_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint8_t i2cdev_sim_crc8(const uint8_t *data, size_t size)
+{
+    uint8_t crc = 0xff;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+esp_err_t i2cdev_sim_attach(i2cdev_sim_dev_t *sim, const i2cdev_sim_model_t *model, i2c_port_t port, uint8_t addr)
+{
+    if (!sim || !model || !model->read || !model->write || port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+    if (i2cdev_sim_find(port, addr))
+    {
+        ESP_LOGE(TAG, "Address 0x%02x is already taken on port %d", addr, port);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(sim, 0, sizeof(i2cdev_sim_dev_t));
+    sim->model = model;
+    sim->port = port;
+    sim->addr = addr;
+    sim->temperature = 25.0f;
+    sim->humidity = 50.0f;
+    sim->pressure = 101325.0f;
+    sim->co2 = 400;
+    if (model->reset)
+        model->reset(sim);
+
+    sim->next = ports[port].devs;
+    ports[port].devs = sim;
+    ESP_LOGD(TAG, "Attached %s at 0x%02x on port %d", model->name, addr, port);
+
+    return ESP_OK;
+}
+
+esp_err_t i2cdev_sim_detach(i2cdev_sim_dev_t *sim)
+{
+    if (!sim || sim->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    for (i2cdev_sim_dev_t **p = &ports[sim->port].devs; *p; p = &(*p)->next)
+        if (*p == sim)
+        {
+            *p = sim->next;
+            sim->next = NULL;
+            return ESP_OK;
+        }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+i2cdev_sim_dev_t *i2cdev_sim_find(i2c_port_t port, uint8_t addr)
+{
+    if (port >= I2C_NUM_MAX) return NULL;
+
+    for (i2cdev_sim_dev_t *sim = ports[port].devs; sim; sim = sim->next)
+        if (sim->addr == addr)
+            return sim;
+
+    return NULL;
+}
+
+esp_err_t i2cdev_sim_set_latency(i2c_port_t port, uint32_t overhead_us, bool realtime)
+{
+    if (port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    ports[port].overhead_us = overhead_us;
+    ports[port].realtime = realtime;
+
+    return ESP_OK;
+}
+
+void i2cdev_sim_reset_counters(void)
+{
+    for (int i = 0; i < I2C_NUM_MAX; i++)
+        for (i2cdev_sim_dev_t *sim = ports[i].devs; sim; sim = sim->next)
+        {
+            sim->transactions = 0;
+            sim->bytes = 0;
+            sim->bus_time_us = 0;
+        }
+}
+
+static esp_err_t sim_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    if (!sim)
+        return ESP_FAIL;
+    if (sim->timeout_count)
+    {
+        sim->timeout_count--;
+        return ESP_ERR_TIMEOUT;
+    }
+    if (sim->nack_count)
+    {
+        sim->nack_count--;
+        return ESP_FAIL;
+    }
+    return sim->model->start ? sim->model->start(sim, read) : ESP_OK;
+}
+
+static void sim_account(const i2c_dev_t *dev, i2cdev_sim_dev_t *sim, size_t addr_bytes, size_t bytes, esp_err_t res)
+{
+    sim_port_t *port = &ports[dev->port];
+    uint32_t clk = dev->cfg.master.clk_speed ? dev->cfg.master.clk_speed : SIM_DEFAULT_CLK_SPEED;
+    uint64_t us = port->overhead_us + (uint64_t)(addr_bytes + bytes) * 9 * 1000000 / clk;
+    if (res == ESP_ERR_TIMEOUT)
+        us += (uint64_t)CONFIG_I2CDEV_TIMEOUT * 1000;
+
+    if (sim)
+    {
+        sim->transactions++;
+        sim->bytes += bytes;
+        sim->bus_time_us += us;
+    }
+    if (port->realtime && us)
+        usleep(us);
+}
+
+esp_err_t i2cdev_sim_transfer(const i2c_dev_t *dev, const i2c_dev_segment_t *segs, size_t count)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    i2cdev_sim_dev_t *sim = i2cdev_sim_find(dev->port, dev->addr);
+    esp_err_t res = ESP_OK;
+    bool in_phase = false;
+    bool read = false;
+    size_t index = 0, addr_bytes = 0, bytes = 0;
+
+    for (size_t i = 0; i < count && res == ESP_OK; i++)
+    {
+        const i2c_dev_segment_t *seg = &segs[i];
+        bool seg_read = seg->type == I2C_DEV_READ;
+        if (!in_phase || seg_read != read)
+        {
+            if (in_phase && sim->model->stop)
+                sim->model->stop(sim, read, index);
+            in_phase = false;
+            addr_bytes++;
+            if ((res = sim_start(sim, seg_read)) != ESP_OK)
+                break;
+            in_phase = true;
+            read = seg_read;
+            index = 0;
+        }
+
+        for (size_t b = 0; b < seg->size; b++, index++, bytes++)
+        {
+            if (read)
+                ((uint8_t *)seg->data)[b] = sim->model->read(sim, index);
+            else if ((res = sim->model->write(sim, ((const uint8_t *)seg->data)[b], index)) != ESP_OK)
+                break;
+        }
+
+        if (seg->stop && in_phase)
+        {
+            if (sim->model->stop)
+                sim->model->stop(sim, read, index);
+            in_phase = false;
+        }
+    }
+    if (in_phase && sim->model->stop)
+        sim->model->stop(sim, read, index);
+
+    sim_account(dev, sim, addr_bytes, bytes, res);
+
+    return res;
+}
+
+esp_err_t i2cdev_sim_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type)
+{
+    if (dev->port >= I2C_NUM_MAX) return ESP_ERR_INVALID_ARG;
+
+    i2cdev_sim_dev_t *sim = i2cdev_sim_find(dev->port, dev->addr);
+    bool read = operation_type == I2C_DEV_READ;
+    esp_err_t res = sim_start(sim, read);
+    if (res == ESP_OK && sim->model->stop)
+        sim->model->stop(sim, read, 0);
+
+    sim_account(dev, sim, 1, 0, res);
+
+    return res;
+}
+
+/* Generic register map */
+
+esp_err_t i2cdev_sim_regmap_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    if (index)
+        sim->regs[sim->reg++] = val;
+    else
+        sim->reg = val;
+    return ESP_OK;
+}
+
+uint8_t i2cdev_sim_regmap_read(i2cdev_sim_dev_t *sim, size_t index)
+{
+    (void)index;
+    return sim->regs[sim->reg++];
+}
+
+const i2cdev_sim_model_t i2cdev_sim_regmap = {
+    .name = "regmap",
+    .write = i2cdev_sim_regmap_write,
+    .read = i2cdev_sim_regmap_read,
+};
@@ -0,0 +1,270 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2cdev_sim.h
+ * @defgroup i2cdev_sim i2cdev_sim
+ * @{
+ *
+ * I2C bus simulator for linux target.
+ *
+ * On linux target i2cdev routes all transactions to in-process device
+ * models attached to simulated ports. A model sees the bus at the byte
+ * level: address phase, written bytes, read bytes and the end of each
+ * phase (STOP or repeated START), so unmodified drivers run against it.
+ *
+ * Typical use:
+ *
+ *     static i2cdev_sim_dev_t sht;
+ *
+ *     i2cdev_sim_attach(&sht, &i2cdev_sim_sht3x, 0, 0x44);
+ *     sht.temperature = 21.5f;
+ *     sht.humidity = 40.0f;
+ *     i2cdev_sim_set_latency(0, 20, true);
+ *
+ *     // run the driver, then inspect sht.transactions and sht.bus_time_us
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __I2CDEV_SIM_H__
+#define __I2CDEV_SIM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "i2cdev.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define I2CDEV_SIM_OUT_SIZE 18 //!< Size of the response buffer of command based models
+
+typedef struct i2cdev_sim_dev_s i2cdev_sim_dev_t;
+
+/**
+ * Device model
+ *
+ * All callbacks are optional except `read` and `write`.
+ */
+typedef struct
+{
+    const char *name;                                                /*!< Model name */
+    void (*reset)(i2cdev_sim_dev_t *sim);                            /*!< Set power-on state */
+    esp_err_t (*start)(i2cdev_sim_dev_t *sim, bool read);            /*!< Address phase, return ESP_FAIL to NACK */
+    esp_err_t (*write)(i2cdev_sim_dev_t *sim, uint8_t val, size_t index); /*!< Byte written by master,
+                                                                          index is counted from the
+                                                                          start of the phase. Return
+                                                                          ESP_FAIL to NACK */
+    uint8_t (*read)(i2cdev_sim_dev_t *sim, size_t index);            /*!< Byte read by master */
+    void (*stop)(i2cdev_sim_dev_t *sim, bool read, size_t bytes);    /*!< End of phase: STOP or repeated START */
+} i2cdev_sim_model_t;
+
+/**
+ * Simulated device
+ *
+ * Scripts may change environment values, registers and fault injection
+ * counters at any time when the bus is idle.
+ */
+struct i2cdev_sim_dev_s
+{
+    const i2cdev_sim_model_t *model; //!< Device model
+    i2c_port_t port;                 //!< Port the device is attached to
+    uint8_t addr;                    //!< Device address
+    i2cdev_sim_dev_t *next;          //!< Next device on the bus, internal
+
+    uint8_t regs[256];               //!< Register map of register based models
+    uint8_t reg;                     //!< Register pointer, auto-incremented
+    uint16_t cmd;                    //!< Last command of command based models
+    uint8_t args[6];                 //!< Command arguments received after command word
+    uint8_t out[I2CDEV_SIM_OUT_SIZE]; //!< Response of command based models
+    uint8_t out_len;                 //!< Length of valid response, reads past it return 0xff
+    uint8_t mode;                    //!< Model-specific operating mode
+    uint16_t status;                 //!< Model-specific status word
+    uint32_t period_ms;              //!< Interval of periodic measurements
+    int64_t busy_until_us;           /*!< End of current measurement, simulator time.
+                                          Scripts may zero it to skip the wait */
+
+    float temperature;               //!< Environment: temperature, deg.C
+    float humidity;                  //!< Environment: relative humidity, %
+    float pressure;                  //!< Environment: pressure, Pa
+    uint16_t co2;                    //!< Environment: CO2 concentration, ppm
+
+    uint32_t nack_count;             //!< Fault injection: NACK address of next N transactions
+    uint32_t timeout_count;          //!< Fault injection: time out next N transactions
+    uint32_t transactions;           //!< Transactions addressed to the device
+    uint64_t bytes;                  //!< Data bytes transferred, not counting addresses
+    uint64_t bus_time_us;            //!< Bus time spent on the device, us
+};
+
+/**
+ * Sensirion SHT3x humidity sensor, default address 0x44.
+ * Supports single shot and periodic measurements, fetch, status,
+ * heater and soft reset commands. Address is NACKed while measuring.
+ */
+extern const i2cdev_sim_model_t i2cdev_sim_sht3x;
+
+/**
+ * Sensirion SCD4x CO2 sensor, default address 0x62.
+ * Supports periodic, low power periodic and single shot measurements,
+ * data ready status, serial number and configuration commands.
+ */
+extern const i2cdev_sim_model_t i2cdev_sim_scd4x;
+
+/**
+ * Bosch BMP280 pressure sensor, default address 0x76.
+ * Register map with datasheet calibration example, forced and normal modes.
+ * Environment values are not used: raw values are taken from the data
+ * registers which scripts may change.
+ */
+extern const i2cdev_sim_model_t i2cdev_sim_bmp280;
+
+/**
+ * Bosch BME680 environmental sensor, default address 0x77.
+ * Register map with sample calibration data, forced mode measurement
+ * with measuring/new data status and gas heater duration.
+ * Raw values are taken from the data registers.
+ */
+extern const i2cdev_sim_model_t i2cdev_sim_bme680;
+
+/**
+ * Generic 8-bit register map device: first written byte sets register
+ * pointer, following bytes are written to the registers, reads return
+ * registers. Pointer is auto-incremented.
+ */
+extern const i2cdev_sim_model_t i2cdev_sim_regmap;
+
+/**
+ * @brief Write callback of generic register map
+ *
+ * May be used by custom register based models.
+ */
+esp_err_t i2cdev_sim_regmap_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index);
+
+/**
+ * @brief Read callback of generic register map
+ *
+ * May be used by custom register based models.
+ */
+uint8_t i2cdev_sim_regmap_read(i2cdev_sim_dev_t *sim, size_t index);
+
+/**
+ * @brief Attach simulated device to a port
+ *
+ * Device structure is reset to power-on state of the model, environment
+ * defaults to 25 deg.C, 50 %, 101325 Pa and 400 ppm.
+ *
+ * @param sim Device
+ * @param model Device model
+ * @param port Simulated port
+ * @param addr Device address
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2cdev_sim_attach(i2cdev_sim_dev_t *sim, const i2cdev_sim_model_t *model, i2c_port_t port, uint8_t addr);
+
+/**
+ * @brief Detach simulated device from its port
+ *
+ * @param sim Device
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2cdev_sim_detach(i2cdev_sim_dev_t *sim);
+
+/**
+ * @brief Find device attached to a port
+ *
+ * @param port Simulated port
+ * @param addr Device address
+ * @return Device or NULL
+ */
+i2cdev_sim_dev_t *i2cdev_sim_find(i2c_port_t port, uint8_t addr);
+
+/**
+ * @brief Configure bus latency of a port
+ *
+ * Every transaction takes `overhead_us` plus 9 bit times per transferred
+ * byte including address bytes at the clock speed of the device
+ * descriptor (100 kHz if not set). The time is accumulated in device
+ * counters and, when `realtime` is true, the calling task sleeps for it.
+ *
+ * @param port Simulated port
+ * @param overhead_us Fixed per-transaction overhead, us
+ * @param realtime Sleep for the simulated bus time
+ * @return `ESP_OK` on success
+ */
+esp_err_t i2cdev_sim_set_latency(i2c_port_t port, uint32_t overhead_us, bool realtime);
+
+/**
+ * @brief Reset transaction counters of all attached devices
+ */
+void i2cdev_sim_reset_counters(void);
+
+/**
+ * @brief Current simulator time, us
+ *
+ * Monotonic clock used by the models for measurement durations.
+ */
+int64_t i2cdev_sim_time_us(void);
+
+/**
+ * @brief Compute Sensirion CRC-8 (polynomial 0x31, init 0xff)
+ *
+ * @param data Data
+ * @param size Data size
+ * @return CRC
+ */
+uint8_t i2cdev_sim_crc8(const uint8_t *data, size_t size);
+
+/**
+ * @brief Execute transaction on simulated bus
+ *
+ * Used by i2cdev on linux target.
+ *
+ * @param dev Device descriptor
+ * @param segs Transaction segments
+ * @param count Number of segments
+ * @return `ESP_OK` on success, `ESP_FAIL` on NACK, `ESP_ERR_TIMEOUT`
+ *         on injected timeout
+ */
+esp_err_t i2cdev_sim_transfer(const i2c_dev_t *dev, const i2c_dev_segment_t *segs, size_t count);
+
+/**
+ * @brief Probe address on simulated bus
+ *
+ * Used by i2cdev on linux target.
+ *
+ * @param dev Device descriptor
+ * @param operation_type Operation type
+ * @return `ESP_OK` if device acknowledged its address
+ */
+esp_err_t i2cdev_sim_probe(const i2c_dev_t *dev, i2c_dev_type_t operation_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __I2CDEV_SIM_H__ */
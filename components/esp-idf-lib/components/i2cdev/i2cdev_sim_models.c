@@ -0,0 +1,569 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file i2cdev_sim_models.c
+ *
+ * Device models for I2C bus simulator
+ *
+ * Copyright (c) 2018 Ruslan V. Uss <unclerus@gmail.com>
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include <string.h>
+#include "i2cdev_sim.h"
+
+#define MS(x) ((int64_t)(x) * 1000)
+
+enum {
+    MODE_IDLE = 0,
+    MODE_SINGLE,
+    MODE_PERIODIC,
+};
+
+static inline bool is_busy(const i2cdev_sim_dev_t *sim)
+{
+    return i2cdev_sim_time_us() < sim->busy_until_us;
+}
+
+static inline uint16_t clamp_u16(float v)
+{
+    return v < 0 ? 0 : v > 65535 ? 65535 : (uint16_t)(v + 0.5f);
+}
+
+/* Sensirion command based sensors */
+
+static void sensirion_out(i2cdev_sim_dev_t *sim, const uint16_t *words, size_t count)
+{
+    for (size_t i = 0; i < count && i * 3 + 3 <= I2CDEV_SIM_OUT_SIZE; i++)
+    {
+        uint8_t *p = sim->out + i * 3;
+        p[0] = words[i] >> 8;
+        p[1] = words[i];
+        p[2] = i2cdev_sim_crc8(p, 2);
+    }
+    sim->out_len = count * 3;
+}
+
+static inline uint16_t sensirion_arg(const i2cdev_sim_dev_t *sim, size_t n)
+{
+    return (sim->args[n * 3] << 8) | sim->args[n * 3 + 1];
+}
+
+static esp_err_t sensirion_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    if (index == 0)
+        sim->cmd = val << 8;
+    else if (index == 1)
+        sim->cmd |= val;
+    else if (index - 2 < sizeof(sim->args))
+        sim->args[index - 2] = val;
+    else
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+static uint8_t sensirion_read(i2cdev_sim_dev_t *sim, size_t index)
+{
+    return index < sim->out_len ? sim->out[index] : 0xff;
+}
+
+/* SHT3x */
+
+#define SHT3X_STATUS_HEATER 0x2000
+#define SHT3X_STATUS_RESET  0x0010
+
+static void sht3x_measure(i2cdev_sim_dev_t *sim)
+{
+    uint16_t words[2] = {
+        clamp_u16((sim->temperature + 45.0f) * 65535.0f / 175.0f),
+        clamp_u16(sim->humidity * 65535.0f / 100.0f),
+    };
+    sensirion_out(sim, words, 2);
+}
+
+// Measurement duration by repeatability code of the command LSB
+static uint32_t sht3x_duration(uint8_t rep)
+{
+    switch (rep)
+    {
+        case 0x00: case 0x06: case 0x30: case 0x32: case 0x34: case 0x36: case 0x37:
+            return 15;
+        case 0x0b: case 0x0d: case 0x20: case 0x21: case 0x22: case 0x24: case 0x26:
+            return 6;
+        default:
+            return 4;
+    }
+}
+
+static void sht3x_reset(i2cdev_sim_dev_t *sim)
+{
+    sim->mode = MODE_IDLE;
+    sim->status = SHT3X_STATUS_RESET;
+    sim->out_len = 0;
+    sim->busy_until_us = 0;
+}
+
+static esp_err_t sht3x_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    // No clock stretching: address is NACKed until single shot measurement is done
+    if (sim->mode == MODE_SINGLE && is_busy(sim))
+        return ESP_FAIL;
+    // Nothing to read
+    if (read && !sim->out_len)
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+static void sht3x_stop(i2cdev_sim_dev_t *sim, bool read, size_t bytes)
+{
+    if (read)
+    {
+        // Data can be read only once
+        sim->out_len = 0;
+        return;
+    }
+    if (bytes < 2)
+        return;
+
+    uint8_t msb = sim->cmd >> 8;
+    switch (sim->cmd)
+    {
+        case 0xf32d: // status
+            sensirion_out(sim, &sim->status, 1);
+            return;
+        case 0x3041: // clear status
+            sim->status &= SHT3X_STATUS_HEATER;
+            return;
+        case 0x30a2: // soft reset
+            sht3x_reset(sim);
+            return;
+        case 0x3093: // stop periodic
+            sim->mode = MODE_IDLE;
+            sim->out_len = 0;
+            return;
+        case 0x306d: // heater on
+            sim->status |= SHT3X_STATUS_HEATER;
+            return;
+        case 0x3066: // heater off
+            sim->status &= ~SHT3X_STATUS_HEATER;
+            return;
+        case 0xe000: // fetch
+            sim->out_len = 0;
+            if (sim->mode == MODE_SINGLE && !is_busy(sim))
+            {
+                sht3x_measure(sim);
+                sim->mode = MODE_IDLE;
+            }
+            else if (sim->mode == MODE_PERIODIC && !is_busy(sim))
+            {
+                sht3x_measure(sim);
+                sim->busy_until_us = i2cdev_sim_time_us() + MS(sim->period_ms);
+            }
+            return;
+    }
+
+    uint32_t duration = sht3x_duration(sim->cmd & 0xff);
+    int64_t now = i2cdev_sim_time_us();
+    sim->out_len = 0;
+    switch (msb)
+    {
+        case 0x24: // single shot, no clock stretching
+        case 0x2c: // single shot, clock stretching
+            sim->mode = MODE_SINGLE;
+            sim->busy_until_us = now + MS(duration);
+            return;
+        case 0x20: sim->period_ms = 2000; break; // 0.5 mps
+        case 0x21: sim->period_ms = 1000; break;
+        case 0x22: sim->period_ms = 500; break;
+        case 0x23: sim->period_ms = 250; break;
+        case 0x27: sim->period_ms = 100; break;
+        default:
+            return;
+    }
+    sim->mode = MODE_PERIODIC;
+    sim->busy_until_us = now + MS(duration);
+}
+
+const i2cdev_sim_model_t i2cdev_sim_sht3x = {
+    .name = "sht3x",
+    .reset = sht3x_reset,
+    .start = sht3x_start,
+    .write = sensirion_write,
+    .read = sensirion_read,
+    .stop = sht3x_stop,
+};
+
+/* SCD4x, settings are kept in regs[] as words */
+
+#define SCD4X_SET_T_OFFSET 0
+#define SCD4X_SET_ALTITUDE 1
+#define SCD4X_SET_ASC      2
+
+enum {
+    SCD4X_MODE_LOW_POWER = MODE_PERIODIC + 1,
+    SCD4X_MODE_POWER_DOWN,
+};
+
+static uint16_t *scd4x_settings(i2cdev_sim_dev_t *sim)
+{
+    return (uint16_t *)sim->regs;
+}
+
+static void scd4x_factory_reset(i2cdev_sim_dev_t *sim)
+{
+    uint16_t *set = scd4x_settings(sim);
+    set[SCD4X_SET_T_OFFSET] = 1498; // 4 deg.C
+    set[SCD4X_SET_ALTITUDE] = 0;
+    set[SCD4X_SET_ASC] = 1;
+}
+
+static void scd4x_reset(i2cdev_sim_dev_t *sim)
+{
+    sim->mode = MODE_IDLE;
+    sim->out_len = 0;
+    sim->busy_until_us = 0;
+    scd4x_factory_reset(sim);
+}
+
+static esp_err_t scd4x_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    if (sim->mode == SCD4X_MODE_POWER_DOWN && !read)
+        return ESP_OK; // only wake_up is accepted, checked on stop
+    if (sim->mode == SCD4X_MODE_POWER_DOWN || (read && !sim->out_len))
+        return ESP_FAIL;
+    return ESP_OK;
+}
+
+static void scd4x_stop(i2cdev_sim_dev_t *sim, bool read, size_t bytes)
+{
+    if (read)
+    {
+        sim->out_len = 0;
+        return;
+    }
+    if (bytes < 2)
+        return;
+
+    uint16_t *set = scd4x_settings(sim);
+    int64_t now = i2cdev_sim_time_us();
+    uint16_t word;
+
+    sim->out_len = 0;
+    if (sim->mode == SCD4X_MODE_POWER_DOWN)
+    {
+        if (sim->cmd == 0x36f6)
+            sim->mode = MODE_IDLE;
+        return;
+    }
+
+    switch (sim->cmd)
+    {
+        case 0x21b1: // start periodic
+            sim->mode = MODE_PERIODIC;
+            sim->period_ms = 5000;
+            sim->busy_until_us = now + MS(sim->period_ms);
+            break;
+        case 0x21ac: // start low power periodic
+            sim->mode = SCD4X_MODE_LOW_POWER;
+            sim->period_ms = 30000;
+            sim->busy_until_us = now + MS(sim->period_ms);
+            break;
+        case 0x219d: // single shot
+        case 0x2196: // single shot, RHT only
+            sim->mode = MODE_SINGLE;
+            sim->busy_until_us = now + MS(sim->cmd == 0x219d ? 5000 : 50);
+            break;
+        case 0x3f86: // stop periodic
+            sim->mode = MODE_IDLE;
+            break;
+        case 0xec05: // read measurement
+            if (sim->mode == MODE_IDLE || is_busy(sim))
+                break;
+            {
+                uint16_t words[3] = {
+                    sim->co2,
+                    clamp_u16((sim->temperature + 45.0f) * 65536.0f / 175.0f),
+                    clamp_u16(sim->humidity * 65536.0f / 100.0f),
+                };
+                sensirion_out(sim, words, 3);
+            }
+            if (sim->mode == MODE_SINGLE)
+                sim->mode = MODE_IDLE;
+            else
+                sim->busy_until_us = now + MS(sim->period_ms);
+            break;
+        case 0xe4b8: // data ready status
+            word = sim->mode != MODE_IDLE && !is_busy(sim) ? 0x8006 : 0x8000;
+            sensirion_out(sim, &word, 1);
+            break;
+        case 0x3682: // serial number
+        {
+            static const uint16_t serial[3] = { 0xf896, 0x9f07, 0x3bb3 };
+            sensirion_out(sim, serial, 3);
+            break;
+        }
+        case 0x2318: sensirion_out(sim, &set[SCD4X_SET_T_OFFSET], 1); break;
+        case 0x2322: sensirion_out(sim, &set[SCD4X_SET_ALTITUDE], 1); break;
+        case 0x2313: sensirion_out(sim, &set[SCD4X_SET_ASC], 1); break;
+        case 0x241d: if (bytes >= 5) set[SCD4X_SET_T_OFFSET] = sensirion_arg(sim, 0); break;
+        case 0x2427: if (bytes >= 5) set[SCD4X_SET_ALTITUDE] = sensirion_arg(sim, 0); break;
+        case 0x2416: if (bytes >= 5) set[SCD4X_SET_ASC] = sensirion_arg(sim, 0); break;
+        case 0x362f: // forced recalibration, no correction
+            word = 0x8000;
+            sensirion_out(sim, &word, 1);
+            break;
+        case 0x3639: // self test passed
+            word = 0;
+            sensirion_out(sim, &word, 1);
+            break;
+        case 0x3632: // factory reset
+            scd4x_factory_reset(sim);
+            break;
+        case 0x36e0: // power down
+            sim->mode = SCD4X_MODE_POWER_DOWN;
+            break;
+        default: // ambient pressure, persist settings, reinit
+            break;
+    }
+}
+
+const i2cdev_sim_model_t i2cdev_sim_scd4x = {
+    .name = "scd4x",
+    .reset = scd4x_reset,
+    .start = scd4x_start,
+    .write = sensirion_write,
+    .read = sensirion_read,
+    .stop = scd4x_stop,
+};
+
+/* Bosch register based sensors */
+
+typedef struct
+{
+    uint8_t reg;
+    uint8_t val;
+} reg_init_t;
+
+static void regs_init(i2cdev_sim_dev_t *sim, const reg_init_t *init, size_t count)
+{
+    memset(sim->regs, 0, sizeof(sim->regs));
+    for (size_t i = 0; i < count; i++)
+        sim->regs[init[i].reg] = init[i].val;
+    sim->reg = 0;
+    sim->mode = MODE_IDLE;
+    sim->busy_until_us = 0;
+}
+
+// Oversampling setting to number of samples
+static inline uint32_t osr_samples(uint8_t osr)
+{
+    return osr ? 1 << ((osr > 5 ? 5 : osr) - 1) : 0;
+}
+
+/* BMP280 */
+
+#define BMP280_REG_STATUS 0xf3
+#define BMP280_REG_CTRL   0xf4
+#define BMP280_REG_RESET  0xe0
+
+// Datasheet section 8.1 calibration example, T = 25.08 deg.C, P = 100653 Pa
+static const reg_init_t bmp280_init[] = {
+    { 0xd0, 0x58 },
+    { 0x88, 0x70 }, { 0x89, 0x6b }, { 0x8a, 0x43 }, { 0x8b, 0x67 }, { 0x8c, 0x18 }, { 0x8d, 0xfc },
+    { 0x8e, 0x7d }, { 0x8f, 0x8e }, { 0x90, 0x43 }, { 0x91, 0xd6 }, { 0x92, 0xd0 }, { 0x93, 0x0b },
+    { 0x94, 0x27 }, { 0x95, 0x0b }, { 0x96, 0x8c }, { 0x97, 0x00 }, { 0x98, 0xf9 }, { 0x99, 0xff },
+    { 0x9a, 0x8c }, { 0x9b, 0x3c }, { 0x9c, 0xf8 }, { 0x9d, 0xc6 }, { 0x9e, 0x70 }, { 0x9f, 0x17 },
+    { 0xf7, 0x65 }, { 0xf8, 0x5a }, { 0xf9, 0xc0 },
+    { 0xfa, 0x7e }, { 0xfb, 0xed }, { 0xfc, 0x00 },
+};
+
+static void bmp280_reset(i2cdev_sim_dev_t *sim)
+{
+    regs_init(sim, bmp280_init, sizeof(bmp280_init) / sizeof(bmp280_init[0]));
+}
+
+static esp_err_t bmp280_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    (void)read;
+    // Forced measurement done, back to sleep
+    if (sim->mode == MODE_SINGLE && !is_busy(sim))
+    {
+        sim->regs[BMP280_REG_CTRL] &= ~0x03;
+        sim->mode = MODE_IDLE;
+    }
+    sim->regs[BMP280_REG_STATUS] = sim->mode == MODE_SINGLE ? 0x08 : 0;
+    return ESP_OK;
+}
+
+// Datasheet section 5.2.1: write is a sequence of register address / data
+// pairs, the last address is the start of a following read
+static esp_err_t bmp280_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    if (!(index & 1))
+    {
+        sim->reg = val;
+        return ESP_OK;
+    }
+
+    uint8_t reg = sim->reg;
+    if (reg == BMP280_REG_RESET)
+    {
+        if (val == 0xb6)
+            bmp280_reset(sim);
+        return ESP_OK;
+    }
+    // Read-only: calibration, id, status, data
+    if ((reg >= 0x88 && reg <= 0xa1) || reg == 0xd0 || reg == BMP280_REG_STATUS || reg >= 0xf7)
+        return ESP_OK;
+
+    sim->regs[reg] = val;
+    if (reg == BMP280_REG_CTRL && (val & 0x03) && (val & 0x03) != 0x03)
+    {
+        // Datasheet section 9.1, typical measurement time
+        uint32_t us = 1000 + 2000 * osr_samples(val >> 5) + (val & 0x1c ? 2000 * osr_samples((val >> 2) & 7) + 500 : 0);
+        sim->mode = MODE_SINGLE;
+        sim->busy_until_us = i2cdev_sim_time_us() + us;
+    }
+    else if (reg == BMP280_REG_CTRL)
+        sim->mode = (val & 0x03) ? MODE_PERIODIC : MODE_IDLE;
+    return ESP_OK;
+}
+
+const i2cdev_sim_model_t i2cdev_sim_bmp280 = {
+    .name = "bmp280",
+    .reset = bmp280_reset,
+    .start = bmp280_start,
+    .write = bmp280_write,
+    .read = i2cdev_sim_regmap_read,
+};
+
+/* BME680 */
+
+#define BME680_REG_MEAS_STATUS_0 0x1d
+#define BME680_REG_GAS_R_LSB_0   0x2b
+#define BME680_REG_GAS_WAIT_0    0x64
+#define BME680_REG_CTRL_GAS_1    0x71
+#define BME680_REG_CTRL_HUM      0x72
+#define BME680_REG_CTRL_MEAS     0x74
+#define BME680_REG_RESET         0xe0
+
+// Sample calibration data, raw values give approx. 25 deg.C
+static const reg_init_t bme680_init[] = {
+    { 0xd0, 0x61 },
+    // 0x89..0xa1
+    { 0x8a, 0xda }, { 0x8b, 0x66 }, { 0x8c, 0x03 },                 // par_t2, par_t3
+    { 0x8e, 0x1a }, { 0x8f, 0x8e }, { 0x90, 0x18 }, { 0x91, 0xd7 }, // par_p1, par_p2
+    { 0x92, 0x58 }, { 0x94, 0xcc }, { 0x95, 0x1b }, { 0x96, 0x5b }, // par_p3, par_p4, par_p5
+    { 0x97, 0xff }, { 0x98, 0x40 }, { 0x99, 0x1e },                 // par_p5, par_p7, par_p6
+    { 0x9c, 0xc9 }, { 0x9d, 0xf3 }, { 0x9e, 0x6d }, { 0x9f, 0xf6 }, // par_p8, par_p9
+    { 0xa0, 0x1e },                                                 // par_p10
+    // 0xe1..0xf0
+    { 0xe1, 0x3f }, { 0xe2, 0x8b }, { 0xe3, 0x2f },                 // par_h2, par_h1
+    { 0xe4, 0x00 }, { 0xe5, 0x2d }, { 0xe6, 0x14 }, { 0xe7, 0x78 }, // par_h3..par_h6
+    { 0xe8, 0x9c },                                                 // par_h7
+    { 0xe9, 0x5a }, { 0xea, 0x65 },                                 // par_t1
+    { 0xeb, 0xb6 }, { 0xec, 0xd6 }, { 0xed, 0xe2 }, { 0xee, 0x12 }, // par_gh2, par_gh1, par_gh3
+    // 0x00..0x07
+    { 0x00, 0x34 }, { 0x02, 0x16 },                                 // res_heat_val, res_heat_range
+    // raw data
+    { 0x1f, 0x55 }, { 0x20, 0x73 }, { 0x21, 0x00 },                 // pressure
+    { 0x22, 0x78 }, { 0x23, 0xcc }, { 0x24, 0x00 },                 // temperature
+    { 0x25, 0x55 }, { 0x26, 0x00 },                                 // humidity
+    { 0x2a, 0x68 }, { 0x2b, 0x04 },                                 // gas resistance
+};
+
+static void bme680_reset(i2cdev_sim_dev_t *sim)
+{
+    regs_init(sim, bme680_init, sizeof(bme680_init) / sizeof(bme680_init[0]));
+}
+
+static esp_err_t bme680_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    (void)read;
+    uint8_t *status = &sim->regs[BME680_REG_MEAS_STATUS_0];
+    if (sim->mode != MODE_SINGLE)
+        return ESP_OK;
+    if (is_busy(sim))
+        return ESP_OK;
+
+    // Forced measurement done: new data, gas valid and heater stable if gas was run
+    bool gas = sim->regs[BME680_REG_CTRL_GAS_1] & 0x10;
+    *status = 0x80 | (sim->regs[BME680_REG_CTRL_GAS_1] & 0x0f);
+    sim->regs[BME680_REG_GAS_R_LSB_0] = (sim->regs[BME680_REG_GAS_R_LSB_0] & 0xcf) | (gas ? 0x30 : 0);
+    sim->regs[BME680_REG_CTRL_MEAS] &= ~0x03;
+    sim->mode = MODE_IDLE;
+    return ESP_OK;
+}
+
+static void bme680_force(i2cdev_sim_dev_t *sim)
+{
+    uint8_t meas = sim->regs[BME680_REG_CTRL_MEAS];
+    uint8_t gas_1 = sim->regs[BME680_REG_CTRL_GAS_1];
+    // Datasheet section 3.3.1, TPH duration plus heater wait time
+    uint32_t cycles = osr_samples(meas >> 5) + osr_samples((meas >> 2) & 7)
+                      + osr_samples(sim->regs[BME680_REG_CTRL_HUM] & 7);
+    uint32_t us = cycles * 1963 + 477 * 4 + 477 * 5 + 500 + 1000;
+    if (gas_1 & 0x10)
+    {
+        uint8_t wait = sim->regs[BME680_REG_GAS_WAIT_0 + (gas_1 & 0x0f)];
+        us += (uint32_t)(wait & 0x3f) * (1 << ((wait >> 6) * 2)) * 1000;
+    }
+
+    sim->mode = MODE_SINGLE;
+    sim->busy_until_us = i2cdev_sim_time_us() + us;
+    sim->regs[BME680_REG_MEAS_STATUS_0] = 0x20 | (gas_1 & 0x10 ? 0x40 : 0) | (gas_1 & 0x0f);
+}
+
+static esp_err_t bme680_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    if (!index)
+    {
+        sim->reg = val;
+        return ESP_OK;
+    }
+
+    uint8_t reg = sim->reg++;
+    if (reg == BME680_REG_RESET)
+    {
+        if (val == 0xb6)
+            bme680_reset(sim);
+        return ESP_OK;
+    }
+    // Read-only: calibration, id, data
+    if ((reg >= 0x89 && reg <= 0xa1) || (reg >= 0xe1 && reg <= 0xf0) || reg <= 0x4d || reg == 0xd0)
+        return ESP_OK;
+
+    sim->regs[reg] = val;
+    if (reg == BME680_REG_CTRL_MEAS && (val & 0x03) == 0x01)
+        bme680_force(sim);
+    return ESP_OK;
+}
+
+const i2cdev_sim_model_t i2cdev_sim_bme680 = {
+    .name = "bme680",
+    .reset = bme680_reset,
+    .start = bme680_start,
+    .write = bme680_write,
+    .read = i2cdev_sim_regmap_read,
+};
@@ -535,6 +535,32 @@ esp_err_t icm42670_flush_fifo(icm42670_t *dev)
     return ESP_OK;
 }
 
+esp_err_t icm42670_get_fifo_count(icm42670_t *dev, uint16_t *count)
+{
+    CHECK_ARG(dev && count);
+
+    // COUNTH and COUNTL in one burst, big endian by default (FIFO_COUNT_ENDIAN = 1)
+    uint8_t buf[2];
+    CHECK(i2c_dev_read_reg(&dev->i2c_dev, ICM42670_REG_FIFO_COUNTH, buf, sizeof(buf)));
+    *count = (buf[0] << 8) | buf[1];
+
+    return ESP_OK;
+}
+
+esp_err_t icm42670_read_fifo(icm42670_t *dev, uint8_t *data, size_t length)
+{
+    CHECK_ARG(dev && data && length);
+
+    return i2c_dev_read_bulk(&dev->i2c_dev, ICM42670_REG_FIFO_DATA, data, length);
+}
+
+esp_err_t icm42670_fifo_stream_init(icm42670_t *dev, i2c_dev_stream_t *stream, uint8_t *buf0, uint8_t *buf1, size_t size)
+{
+    CHECK_ARG(dev && stream && buf0 && buf1 && size);
+
+    return i2c_dev_stream_init(stream, &dev->i2c_dev, ICM42670_REG_FIFO_DATA, buf0, buf1, size);
+}
+
 esp_err_t icm42670_set_gyro_fsr(icm42670_t *dev, icm42670_gyro_fsr_t range)
 {
     CHECK_ARG(dev);
@@ -458,6 +458,45 @@ esp_err_t icm42670_reset(icm42670_t *dev);
  */
 esp_err_t icm42670_flush_fifo(icm42670_t *dev);
 
+/**
+ * @brief Get number of bytes stored in the FIFO
+ *
+ * Assumes default FIFO count format (bytes, big endian).
+ *
+ * @param dev Device descriptor
+ * @param[out] count Number of bytes
+ * @return `ESP_OK` on success
+ */
+esp_err_t icm42670_get_fifo_count(icm42670_t *dev, uint16_t *count);
+
+/**
+ * @brief Read FIFO contents in a single burst
+ *
+ * See i2c_dev_read_bulk().
+ *
+ * @param dev Device descriptor
+ * @param[out] data Buffer to store read bytes
+ * @param length Number of bytes to read, up to 1024
+ * @return `ESP_OK` on success
+ */
+esp_err_t icm42670_read_fifo(icm42670_t *dev, uint8_t *data, size_t length);
+
+/**
+ * @brief Initialize double-buffered FIFO stream
+ *
+ * Use i2c_dev_stream_next() to get the burst requested by the previous
+ * call while the next one is being read, and i2c_dev_stream_free() when
+ * done. Request sizes should be multiples of the FIFO packet size.
+ *
+ * @param dev Device descriptor
+ * @param stream Stream descriptor
+ * @param buf0 First buffer
+ * @param buf1 Second buffer
+ * @param size Size of each buffer, up to 1024
+ * @return `ESP_OK` on success
+ */
+esp_err_t icm42670_fifo_stream_init(icm42670_t *dev, i2c_dev_stream_t *stream, uint8_t *buf0, uint8_t *buf1, size_t size);
+
 /**
  * @brief Set the measurement FSR (Full Scale Range) of the gyro
  *
@@ -34,13 +34,38 @@
 #include <esp_log.h>
 #include <esp_attr.h>
 #include <stdlib.h>
-#include <ets_sys.h>
 #include <esp_idf_lib_helpers.h>
 
 #if HELPER_TARGET_IS_ESP8266
 #error led_strip is not supported on ESP8266
 #endif
 
+#if CONFIG_LED_STRIP_RMT_TX_API
+
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+#error RMT TX channel API requires ESP-IDF >= 5.0
+#endif
+
+#include <soc/soc_caps.h>
+
+#define LED_STRIP_RMT_RESOLUTION 40000000 // 40 MHz, 25 ns per tick
+
+// Reset gap is split into symbols with both halves fitting 15-bit duration
+#define LED_RESET_DURATION_MAX 0x7fff
+#define LED_RESET_TICKS (CONFIG_LED_STRIP_PAUSE_LENGTH * (LED_STRIP_RMT_RESOLUTION / 1000000))
+#define LED_RESET_SYMBOLS (LED_RESET_TICKS > 2 * LED_RESET_DURATION_MAX \
+        ? (LED_RESET_TICKS + 2 * LED_RESET_DURATION_MAX - 1) / (2 * LED_RESET_DURATION_MAX) : 1)
+
+#if CONFIG_LED_STRIP_RMT_DMA
+#define LED_STRIP_RMT_MEM_SYMBOLS 1024
+#else
+#define LED_STRIP_RMT_MEM_SYMBOLS SOC_RMT_MEM_WORDS_PER_CHANNEL
+#endif
+
+#else
+
+#include <ets_sys.h>
+
 #ifndef RMT_DEFAULT_CONFIG_TX
 #define RMT_DEFAULT_CONFIG_TX(gpio, channel_id)      \
     {                                                \
@@ -61,18 +86,172 @@
     }
 #endif
 
-static const char *TAG = "led_strip";
-
 #define LED_STRIP_RMT_CLK_DIV 2
 
+#endif
+
+static const char *TAG = "led_strip";
+
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
 #define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
 
+typedef enum {
+    ORDER_GRB,
+    ORDER_RGB,
+} color_order_t;
+
+typedef struct {
+    uint32_t t0h, t0l, t1h, t1l;
+    color_order_t order;
+} led_params_t;
+
+static const led_params_t led_params[] = {
+    [LED_STRIP_WS2812]  = { .t0h = 400, .t0l = 1000, .t1h = 1000, .t1l = 400, .order = ORDER_GRB },
+    [LED_STRIP_SK6812]  = { .t0h = 300, .t0l = 900,  .t1h = 600,  .t1l = 600, .order = ORDER_GRB },
+    [LED_STRIP_APA106]  = { .t0h = 350, .t0l = 1360, .t1h = 1360, .t1l = 350, .order = ORDER_RGB },
+    [LED_STRIP_SM16703] = { .t0h = 300, .t0l = 900,  .t1h = 1360, .t1l = 350, .order = ORDER_RGB },
+};
+
+#if CONFIG_LED_STRIP_RMT_TX_API
+
+typedef struct {
+    rmt_encoder_t base; // must be first
+    rmt_encoder_t *bytes;
+    rmt_encoder_t *copy;
+    int state;
+    rmt_symbol_word_t reset[LED_RESET_SYMBOLS];
+} led_encoder_t;
+
+// Pixel data followed by the reset gap as trailing low level symbols
+static size_t IRAM_ATTR led_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
+                                   const void *data, size_t size, rmt_encode_state_t *ret_state)
+{
+    led_encoder_t *led = (led_encoder_t *)encoder;
+    rmt_encode_state_t session = RMT_ENCODING_RESET;
+    int state = RMT_ENCODING_RESET;
+    size_t encoded = 0;
+
+    if (led->state == 0)
+    {
+        encoded += led->bytes->encode(led->bytes, channel, data, size, &session);
+        if (session & RMT_ENCODING_COMPLETE)
+            led->state = 1;
+        if (session & RMT_ENCODING_MEM_FULL)
+        {
+            *ret_state = RMT_ENCODING_MEM_FULL;
+            return encoded;
+        }
+    }
+
+    encoded += led->copy->encode(led->copy, channel, led->reset, sizeof(led->reset), &session);
+    if (session & RMT_ENCODING_COMPLETE)
+    {
+        led->state = 0;
+        state |= RMT_ENCODING_COMPLETE;
+    }
+    if (session & RMT_ENCODING_MEM_FULL)
+        state |= RMT_ENCODING_MEM_FULL;
+
+    *ret_state = (rmt_encode_state_t)state;
+    return encoded;
+}
+
+static esp_err_t led_encoder_reset(rmt_encoder_t *encoder)
+{
+    led_encoder_t *led = (led_encoder_t *)encoder;
+    rmt_encoder_reset(led->bytes);
+    rmt_encoder_reset(led->copy);
+    led->state = 0;
+    return ESP_OK;
+}
+
+static esp_err_t led_encoder_del(rmt_encoder_t *encoder)
+{
+    led_encoder_t *led = (led_encoder_t *)encoder;
+    if (led->bytes)
+        rmt_del_encoder(led->bytes);
+    if (led->copy)
+        rmt_del_encoder(led->copy);
+    free(led);
+    return ESP_OK;
+}
+
+#define NS_TO_TICKS(ns) ((ns) * (LED_STRIP_RMT_RESOLUTION / 1000000) / 1000)
+
+static bool IRAM_ATTR on_trans_done(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *ctx)
+{
+    (void)channel;
+    (void)edata;
+    led_strip_t *strip = (led_strip_t *)ctx;
+    return strip->done_cb(strip, strip->done_ctx);
+}
+
+static esp_err_t led_encoder_new(led_strip_type_t type, rmt_encoder_handle_t *encoder)
+{
+    led_encoder_t *led = calloc(1, sizeof(led_encoder_t));
+    if (!led)
+    {
+        ESP_LOGE(TAG, "Not enough memory");
+        return ESP_ERR_NO_MEM;
+    }
+    led->base.encode = led_encode;
+    led->base.reset = led_encoder_reset;
+    led->base.del = led_encoder_del;
+
+    const led_params_t *p = &led_params[type];
+    rmt_bytes_encoder_config_t bytes_config = {
+        .bit0 = {
+            .level0 = 1,
+            .duration0 = NS_TO_TICKS(p->t0h),
+            .level1 = 0,
+            .duration1 = NS_TO_TICKS(p->t0l),
+        },
+        .bit1 = {
+            .level0 = 1,
+            .duration0 = NS_TO_TICKS(p->t1h),
+            .level1 = 0,
+            .duration1 = NS_TO_TICKS(p->t1l),
+        },
+        .flags.msb_first = 1,
+    };
+    rmt_copy_encoder_config_t copy_config = { 0 };
+
+    // Zero duration would terminate transmission, so the gap is at least two ticks.
+    // Ticks are spread evenly over all halves, none exceeds LED_RESET_DURATION_MAX
+    uint32_t halves = 2 * LED_RESET_SYMBOLS;
+    uint32_t ticks = LED_RESET_TICKS < 2 ? 2 : LED_RESET_TICKS;
+    for (uint32_t i = 0; i < LED_RESET_SYMBOLS; i++)
+    {
+        led->reset[i].level0 = 0;
+        led->reset[i].duration0 = ticks / halves + (2 * i < ticks % halves);
+        led->reset[i].level1 = 0;
+        led->reset[i].duration1 = ticks / halves + (2 * i + 1 < ticks % halves);
+    }
+
+    esp_err_t res = rmt_new_bytes_encoder(&bytes_config, &led->bytes);
+    if (res == ESP_OK)
+        res = rmt_new_copy_encoder(&copy_config, &led->copy);
+    if (res != ESP_OK)
+    {
+        led_encoder_del(&led->base);
+        return res;
+    }
+
+    *encoder = &led->base;
+    return ESP_OK;
+}
+
+#else
+
+typedef struct {
+    uint32_t nibble[16][4]; // RMT items for every 4-bit value, MSB first
+} led_rmt_t;
+
 static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                    size_t wanted_num, size_t *translated_size, size_t *item_num,
-                                   const rmt_item32_t *bit0, const rmt_item32_t *bit1)
+                                   const led_rmt_t *items)
 {
     if (!src || !dest)
     {
@@ -82,27 +261,22 @@ static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t s
     }
     size_t size = 0;
     size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
-#ifdef LED_STRIP_BRIGHTNESS
-    led_strip_t *strip;
-    esp_err_t r = rmt_translator_get_context(item_num, (void **)&strip);
-    uint8_t brightness = r == ESP_OK ? strip->brightness : 255;
-#endif
+    const uint8_t *psrc = (const uint8_t *)src;
+    uint32_t *pdest = (uint32_t *)dest;
     while (size < src_size && num < wanted_num)
     {
-#ifdef LED_STRIP_BRIGHTNESS
-        uint8_t b = brightness != 255 ? scale8_video(*psrc, brightness) : *psrc;
-#else
-        uint8_t b = *psrc;
-#endif
-        for (int i = 0; i < 8; i++)
-        {
-            // MSB first
-            pdest->val = b & (1 << (7 - i)) ? bit1->val : bit0->val;
-            num++;
-            pdest++;
-        }
+        const uint32_t *hi = items->nibble[*psrc >> 4];
+        const uint32_t *lo = items->nibble[*psrc & 0x0f];
+        pdest[0] = hi[0];
+        pdest[1] = hi[1];
+        pdest[2] = hi[2];
+        pdest[3] = hi[3];
+        pdest[4] = lo[0];
+        pdest[5] = lo[1];
+        pdest[6] = lo[2];
+        pdest[7] = lo[3];
+        pdest += 8;
+        num += 8;
         size++;
         psrc++;
     }
@@ -110,118 +284,372 @@ static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t s
     *item_num = num;
 }
 
-typedef struct {
-    rmt_item32_t bit0, bit1;
-} led_rmt_t;
-
+// Must be in DRAM, translators are called from ISR
 static led_rmt_t rmt_items[LED_STRIP_TYPE_MAX] = { 0 };
 
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_WS2812].bit0, &rmt_items[LED_STRIP_WS2812].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_WS2812]);
 }
 
 static void IRAM_ATTR sk6812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SK6812].bit0, &rmt_items[LED_STRIP_SK6812].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SK6812]);
 }
 
 static void IRAM_ATTR apa106_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
         size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_APA106].bit0, &rmt_items[LED_STRIP_APA106].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_APA106]);
 }
 
 static void IRAM_ATTR sm16703_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                          size_t wanted_num, size_t *translated_size, size_t *item_num)
 {
-    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SM16703].bit0, &rmt_items[LED_STRIP_SM16703].bit1);
+    _rmt_adapter(src, dest, src_size, wanted_num, translated_size, item_num, &rmt_items[LED_STRIP_SM16703]);
 }
 
-typedef enum {
-    ORDER_GRB,
-    ORDER_RGB,
-} color_order_t;
+// TX end callback of legacy driver is global
+static led_strip_t *channel_strips[RMT_CHANNEL_MAX] = { 0 };
+static bool tx_end_registered = false;
 
-typedef struct {
-    uint32_t t0h, t0l, t1h, t1l;
-    color_order_t order;
-    sample_to_rmt_t adapter;
-} led_params_t;
+static void IRAM_ATTR on_tx_end(rmt_channel_t channel, void *arg)
+{
+    (void)arg;
+    led_strip_t *strip = channel_strips[channel];
+    if (strip && strip->done_cb && strip->done_cb(strip, strip->done_ctx))
+        portYIELD_FROM_ISR();
+}
 
-static const led_params_t led_params[] = {
-    [LED_STRIP_WS2812]  = { .t0h = 400, .t0l = 1000, .t1h = 1000, .t1l = 400, .order = ORDER_GRB, .adapter = ws2812_rmt_adapter },
-    [LED_STRIP_SK6812]  = { .t0h = 300, .t0l = 900,  .t1h = 600,  .t1l = 600, .order = ORDER_GRB, .adapter = sk6812_rmt_adapter },
-    [LED_STRIP_APA106]  = { .t0h = 350, .t0l = 1360, .t1h = 1360, .t1l = 350, .order = ORDER_RGB, .adapter = apa106_rmt_adapter },
-    [LED_STRIP_SM16703] = { .t0h = 300, .t0l = 900,  .t1h = 1360, .t1l = 350, .order = ORDER_RGB, .adapter = sm16703_rmt_adapter },
+static const sample_to_rmt_t adapters[] = {
+    [LED_STRIP_WS2812]  = ws2812_rmt_adapter,
+    [LED_STRIP_SK6812]  = sk6812_rmt_adapter,
+    [LED_STRIP_APA106]  = apa106_rmt_adapter,
+    [LED_STRIP_SM16703] = sm16703_rmt_adapter,
 };
 
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void led_strip_install()
 {
+#if !CONFIG_LED_STRIP_RMT_TX_API
     float ratio = (float)APB_CLK_FREQ / LED_STRIP_RMT_CLK_DIV / 1e09f;
 
     for (size_t i = 0; i < LED_STRIP_TYPE_MAX; i++)
     {
-        // 0 bit
-        rmt_items[i].bit0.duration0 = (uint32_t)(ratio * led_params[i].t0h);
-        rmt_items[i].bit0.level0 = 1;
-        rmt_items[i].bit0.duration1 = (uint32_t)(ratio * led_params[i].t0l);
-        rmt_items[i].bit0.level1 = 0;
-        // 1 bit
-        rmt_items[i].bit1.duration0 = (uint32_t)(ratio * led_params[i].t1h);
-        rmt_items[i].bit1.level0 = 1;
-        rmt_items[i].bit1.duration1 = (uint32_t)(ratio * led_params[i].t1l);
-        rmt_items[i].bit1.level1 = 0;
+        rmt_item32_t bit0 = {
+            .duration0 = (uint32_t)(ratio * led_params[i].t0h),
+            .level0 = 1,
+            .duration1 = (uint32_t)(ratio * led_params[i].t0l),
+            .level1 = 0,
+        };
+        rmt_item32_t bit1 = {
+            .duration0 = (uint32_t)(ratio * led_params[i].t1h),
+            .level0 = 1,
+            .duration1 = (uint32_t)(ratio * led_params[i].t1l),
+            .level1 = 0,
+        };
+        for (size_t n = 0; n < 16; n++)
+            for (size_t b = 0; b < 4; b++)
+                rmt_items[i].nibble[n][b] = n & (8 >> b) ? bit1.val : bit0.val;
     }
+#endif
 }
 
 esp_err_t led_strip_init(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->length > 0 && strip->type < LED_STRIP_TYPE_MAX);
 
+    esp_err_t err = ESP_ERR_NO_MEM;
+    strip->tx_buf = NULL;
+#ifdef LED_STRIP_BRIGHTNESS
+    strip->dither_err = NULL;
+#endif
+#if CONFIG_LED_STRIP_RMT_TX_API
+    strip->channel = NULL;
+    strip->encoder = NULL;
+#else
+    bool installed = false;
+#endif
+
     strip->buf = calloc(strip->length, COLOR_SIZE(strip));
-    if (!strip->buf)
+    if (!strip->buf || (strip->double_buffer && !(strip->tx_buf = calloc(strip->length, COLOR_SIZE(strip)))))
     {
         ESP_LOGE(TAG, "Not enough memory");
-        return ESP_ERR_NO_MEM;
+        goto fail;
     }
 
+#if CONFIG_LED_STRIP_RMT_TX_API
+    rmt_tx_channel_config_t config = {
+        .gpio_num = strip->gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = LED_STRIP_RMT_RESOLUTION,
+        .mem_block_symbols = LED_STRIP_RMT_MEM_SYMBOLS,
+        .trans_queue_depth = 4,
+#if CONFIG_LED_STRIP_RMT_DMA
+        .flags.with_dma = 1,
+#endif
+    };
+
+    if ((err = rmt_new_tx_channel(&config, &strip->channel)) != ESP_OK)
+        goto fail;
+    if ((err = led_encoder_new(strip->type, &strip->encoder)) != ESP_OK)
+        goto fail;
+    if (strip->done_cb)
+    {
+        rmt_tx_event_callbacks_t cbs = { .on_trans_done = on_trans_done };
+        if ((err = rmt_tx_register_event_callbacks(strip->channel, &cbs, strip)) != ESP_OK)
+            goto fail;
+    }
+    if ((err = rmt_enable(strip->channel)) != ESP_OK)
+        goto fail;
+#else
     rmt_config_t config = RMT_DEFAULT_CONFIG_TX(strip->gpio, strip->channel);
     config.clk_div = LED_STRIP_RMT_CLK_DIV;
 
-    CHECK(rmt_config(&config));
-    CHECK(rmt_driver_install(config.channel, 0, 0));
+    if ((err = rmt_config(&config)) != ESP_OK)
+        goto fail;
+    if ((err = rmt_driver_install(config.channel, 0, 0)) != ESP_OK)
+        goto fail;
+    installed = true;
+    if ((err = rmt_translator_init(config.channel, adapters[strip->type])) != ESP_OK)
+        goto fail;
 
-    CHECK(rmt_translator_init(config.channel, led_params[strip->type].adapter));
-#ifdef LED_STRIP_BRIGHTNESS
-    // No support for translator context prior to ESP-IDF 4.3
-    CHECK(rmt_translator_set_context(config.channel, strip));
+    channel_strips[strip->channel] = strip;
+    if (strip->done_cb && !tx_end_registered)
+    {
+        rmt_register_tx_end_callback(on_tx_end, NULL);
+        tx_end_registered = true;
+    }
 #endif
 
     return ESP_OK;
+
+fail:
+#if CONFIG_LED_STRIP_RMT_TX_API
+    if (strip->encoder)
+        rmt_del_encoder(strip->encoder);
+    if (strip->channel)
+        rmt_del_channel(strip->channel);
+    strip->encoder = NULL;
+    strip->channel = NULL;
+#else
+    if (installed)
+        rmt_driver_uninstall(strip->channel);
+#endif
+    free(strip->buf);
+    free(strip->tx_buf);
+    strip->buf = NULL;
+    strip->tx_buf = NULL;
+    return err;
 }
 
 esp_err_t led_strip_free(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
-    free(strip->buf);
 
+    // Buffers are released only when the channel no longer reads them
+#if CONFIG_LED_STRIP_RMT_TX_API
+    CHECK(rmt_tx_wait_all_done(strip->channel, CONFIG_LED_STRIP_FLUSH_TIMEOUT));
+    CHECK(rmt_disable(strip->channel));
+    CHECK(rmt_del_encoder(strip->encoder));
+    CHECK(rmt_del_channel(strip->channel));
+    strip->encoder = NULL;
+    strip->channel = NULL;
+#else
     CHECK(rmt_driver_uninstall(strip->channel));
+    channel_strips[strip->channel] = NULL;
+#endif
+
+    free(strip->buf);
+    free(strip->tx_buf);
+    strip->buf = NULL;
+    strip->tx_buf = NULL;
+#ifdef LED_STRIP_BRIGHTNESS
+    free(strip->dither_err);
+    strip->dither_err = NULL;
+#endif
+
+    return ESP_OK;
+}
+
+#ifdef LED_STRIP_BRIGHTNESS
+// Scale with 8 fractional bits, the fraction is added to the next frame,
+// so the average of output values equals the exact scaled value.
+// Back buffer is left intact, so the same frame can be sent again
+static void dither(led_strip_t *strip, size_t size)
+{
+    if (!strip->dither_err && !(strip->dither_err = calloc(size, 1)))
+    {
+        // not enough memory for accumulators, scale without dithering
+        for (size_t i = 0; i < size; i++)
+            strip->tx_buf[i] = scale8_video(strip->buf[i], strip->brightness);
+        return;
+    }
+
+    uint16_t scale = strip->brightness + 1;
+    for (size_t i = 0; i < size; i++)
+    {
+        uint16_t val = strip->buf[i] * scale + strip->dither_err[i];
+        strip->tx_buf[i] = val >> 8;
+        strip->dither_err[i] = val & 0xff;
+    }
+}
+#endif
+
+// Scaled copy is allocated by the first flush with brightness below 255
+static esp_err_t tx_buffer_alloc(led_strip_t *strip)
+{
+#ifdef LED_STRIP_BRIGHTNESS
+    if (strip->brightness != 255 && !strip->tx_buf
+            && !(strip->tx_buf = malloc(strip->length * COLOR_SIZE(strip))))
+    {
+        ESP_LOGE(TAG, "Not enough memory");
+        return ESP_ERR_NO_MEM;
+    }
+#else
+    (void)strip;
+#endif
+    return ESP_OK;
+}
+
+// Buffer to send: brightness is applied to a copy, so translator only expands
+// bits. In double buffered mode back and front buffers are swapped.
+static uint8_t *tx_buffer(led_strip_t *strip)
+{
+    if (tx_buffer_alloc(strip) != ESP_OK)
+        return NULL;
+#ifdef LED_STRIP_BRIGHTNESS
+    if (strip->brightness != 255)
+    {
+        size_t size = strip->length * COLOR_SIZE(strip);
+        if (strip->dither)
+            dither(strip, size);
+        else
+            for (size_t i = 0; i < size; i++)
+                strip->tx_buf[i] = scale8_video(strip->buf[i], strip->brightness);
+        return strip->tx_buf;
+    }
+#endif
+    if (!strip->double_buffer)
+        return strip->buf;
+
+    uint8_t *front = strip->buf;
+    strip->buf = strip->tx_buf;
+    strip->tx_buf = front;
+    return front;
+}
+
+#if CONFIG_LED_STRIP_RMT_TX_API
+
+static int ticks_to_ms(TickType_t timeout)
+{
+    return timeout == portMAX_DELAY ? -1 : (int)pdTICKS_TO_MS(timeout);
+}
+
+static esp_err_t transmit(led_strip_t *strip)
+{
+    uint8_t *buf = tx_buffer(strip);
+    if (!buf)
+        return ESP_ERR_NO_MEM;
+
+    // Reset gap is a part of the frame, no need to wait for it
+    rmt_transmit_config_t config = { .loop_count = 0 };
+    return rmt_transmit(strip->channel, strip->encoder, buf,
+                        strip->length * COLOR_SIZE(strip), &config);
+}
+
+esp_err_t led_strip_flush(led_strip_t *strip)
+{
+    CHECK_ARG(strip && strip->buf);
+
+    CHECK(rmt_tx_wait_all_done(strip->channel, CONFIG_LED_STRIP_FLUSH_TIMEOUT));
+    return transmit(strip);
+}
+
+bool led_strip_busy(led_strip_t *strip)
+{
+    if (!strip) return false;
+    return rmt_tx_wait_all_done(strip->channel, 0) == ESP_ERR_TIMEOUT;
+}
+
+esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout)
+{
+    CHECK_ARG(strip);
+
+    return rmt_tx_wait_all_done(strip->channel, ticks_to_ms(timeout));
+}
+
+#ifdef LED_STRIP_SYNC
+
+esp_err_t led_strip_sync_init(led_strip_sync_t *sync, led_strip_t **strips, size_t count)
+{
+    CHECK_ARG(sync && strips && count && count <= SOC_RMT_TX_CANDIDATES_PER_GROUP);
+
+    rmt_channel_handle_t channels[SOC_RMT_TX_CANDIDATES_PER_GROUP];
+    for (size_t i = 0; i < count; i++)
+    {
+        CHECK_ARG(strips[i] && strips[i]->channel);
+        channels[i] = strips[i]->channel;
+    }
+
+    rmt_sync_manager_config_t config = {
+        .tx_channel_array = channels,
+        .array_size = count,
+    };
+    CHECK(rmt_new_sync_manager(&config, &sync->manager));
+    sync->strips = strips;
+    sync->count = count;
 
     return ESP_OK;
 }
 
+esp_err_t led_strip_sync_free(led_strip_sync_t *sync)
+{
+    CHECK_ARG(sync && sync->manager);
+
+    CHECK(rmt_del_sync_manager(sync->manager));
+    sync->manager = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_sync_flush(led_strip_sync_t *sync)
+{
+    CHECK_ARG(sync && sync->manager);
+
+    for (size_t i = 0; i < sync->count; i++)
+        CHECK(rmt_tx_wait_all_done(sync->strips[i]->channel, CONFIG_LED_STRIP_FLUSH_TIMEOUT));
+    // Nothing may fail after the reset, part of the group would stay armed
+    for (size_t i = 0; i < sync->count; i++)
+        CHECK(tx_buffer_alloc(sync->strips[i]));
+
+    // Channels start together when the last one of the group is armed
+    CHECK(rmt_sync_reset(sync->manager));
+    for (size_t i = 0; i < sync->count; i++)
+        CHECK(transmit(sync->strips[i]));
+
+    return ESP_OK;
+}
+
+#endif
+
+#else
+
 esp_err_t led_strip_flush(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
 
     CHECK(rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+    uint8_t *buf = tx_buffer(strip);
+    if (!buf)
+        return ESP_ERR_NO_MEM;
     ets_delay_us(CONFIG_LED_STRIP_PAUSE_LENGTH);
-    return rmt_write_sample(strip->channel, strip->buf,
+    return rmt_write_sample(strip->channel, buf,
                             strip->length * COLOR_SIZE(strip), false);
 }
 
@@ -238,10 +666,14 @@ esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout)
     return rmt_wait_tx_done(strip->channel, timeout);
 }
 
+#endif
+
 esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
 {
     CHECK_ARG(strip && strip->buf && num <= strip->length);
     size_t idx = num * COLOR_SIZE(strip);
+    if (strip->lut)
+        color = rgb_lut_apply(strip->lut, color);
     switch (led_params[strip->type].order)
     {
         case ORDER_GRB:
@@ -270,6 +702,27 @@ esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb
     return ESP_OK;
 }
 
+esp_err_t led_strip_set_pixels_indexed(led_strip_t *strip, size_t start, size_t len, const uint8_t *index,
+        const rgb_t *colors)
+{
+    CHECK_ARG(strip && strip->buf && index && colors && len && start + len <= strip->length);
+
+    uint8_t *dst = strip->buf + start * COLOR_SIZE(strip);
+    bool grb = led_params[strip->type].order == ORDER_GRB;
+    for (size_t i = 0; i < len; i++)
+    {
+        rgb_t color = colors[index[i]];
+        if (strip->lut)
+            color = rgb_lut_apply(strip->lut, color);
+        *dst++ = grb ? color.g : color.r;
+        *dst++ = grb ? color.r : color.g;
+        *dst++ = color.b;
+        if (strip->is_rgbw)
+            *dst++ = rgb_luma(color);
+    }
+    return ESP_OK;
+}
+
 esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t color)
 {
     CHECK_ARG(strip && strip->buf && len && start + len <= strip->length);
@@ -35,10 +35,16 @@
 #ifndef __LED_STRIP_H__
 #define __LED_STRIP_H__
 
+#include <freertos/FreeRTOS.h>
 #include <driver/gpio.h>
 #include <esp_err.h>
-#include <driver/rmt.h>
 #include <color.h>
+#if CONFIG_LED_STRIP_RMT_TX_API
+#include <driver/rmt_tx.h>
+#include <soc/soc_caps.h>
+#else
+#include <driver/rmt.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,6 +54,10 @@ extern "C" {
 #define LED_STRIP_BRIGHTNESS 1
 #endif
 
+#if (CONFIG_LED_STRIP_RMT_TX_API && SOC_RMT_SUPPORT_TX_SYNCHRO) || defined(__DOXYGEN__)
+#define LED_STRIP_SYNC 1
+#endif
+
 /**
  * LED type
  */
@@ -61,22 +71,53 @@ typedef enum
     LED_STRIP_TYPE_MAX
 } led_strip_type_t;
 
+typedef struct led_strip_s led_strip_t;
+
+/**
+ * Callback of sent frame
+ *
+ * Called from ISR when transmission of the frame is complete.
+ *
+ * @param strip Descriptor of LED strip
+ * @param ctx User context
+ * @return true if a higher priority task has been woken
+ */
+typedef bool (*led_strip_done_cb_t)(led_strip_t *strip, void *ctx);
+
 /**
  * LED strip descriptor
  */
-typedef struct
+struct led_strip_s
 {
     led_strip_type_t type; ///< LED type
     bool is_rgbw;          ///< true for RGBW strips
 #ifdef LED_STRIP_BRIGHTNESS
     uint8_t brightness;    ///< Brightness 0..255, call ::led_strip_flush() after change.
                            ///< Supported only for ESP-IDF version >= 4.3
+    bool dither;           ///< Temporal dithering of brightness scaling: fractions lost by
+                           ///< scaling are accumulated per channel and carried to next
+                           ///< flushes. Flush continuously, even without changes, at a high
+                           ///< frame rate to avoid visible flicker
 #endif
     size_t length;         ///< Number of LEDs in strip
     gpio_num_t gpio;       ///< Data GPIO pin
+#if CONFIG_LED_STRIP_RMT_TX_API
+    rmt_channel_handle_t channel; ///< RMT TX channel, allocated by ::led_strip_init()
+    rmt_encoder_handle_t encoder; ///< RMT encoder, allocated by ::led_strip_init()
+#else
     rmt_channel_t channel; ///< RMT channel
-    uint8_t *buf;
-} led_strip_t;
+#endif
+    bool double_buffer;    ///< Render into back buffer while front buffer is being sent
+    led_strip_done_cb_t done_cb; ///< Callback of sent frame, may be NULL. Set before ::led_strip_init()
+    void *done_ctx;        ///< User context of done_cb
+    const rgb_lut_t *lut;  ///< Gamma/brightness/color correction tables applied when
+                           ///< setting pixels, may be NULL. See ::rgb_lut_set()
+    uint8_t *buf;          ///< Pixel buffer (back buffer in double buffered mode)
+    uint8_t *tx_buf;       ///< Front buffer or brightness-scaled copy of buf, internal
+#ifdef LED_STRIP_BRIGHTNESS
+    uint8_t *dither_err;   ///< Dithering error accumulators, internal
+#endif
+};
 
 /**
  * @brief Setup library
@@ -104,6 +145,14 @@ esp_err_t led_strip_free(led_strip_t *strip);
 /**
  * @brief Send strip buffer to LEDs
  *
+ * Function waits for the previous frame to be sent, then starts
+ * transmission and returns without waiting for it.
+ *
+ * In double buffered mode buffers are swapped: `buf` is sent and the
+ * former front buffer becomes new `buf`. Its content is undefined, so
+ * the next frame must be rendered completely. Use ::led_strip_wait()
+ * or `done_cb` to pace frames.
+ *
  * @param strip Descriptor of LED strip
  * @return `ESP_OK` on success
  */
@@ -126,6 +175,55 @@ bool led_strip_busy(led_strip_t *strip);
  */
 esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout);
 
+#ifdef LED_STRIP_SYNC
+
+/**
+ * Group of strips transmitted simultaneously
+ *
+ * Available with RMT TX channel API on chips supporting synchronous
+ * transmission of several RMT channels (not on ESP32).
+ */
+typedef struct
+{
+    rmt_sync_manager_handle_t manager; ///< RMT sync manager
+    led_strip_t **strips;              ///< Strips of the group
+    size_t count;                      ///< Number of strips
+} led_strip_sync_t;
+
+/**
+ * @brief Create group of strips started simultaneously
+ *
+ * Strips must be initialized by ::led_strip_init(). Array of strip
+ * pointers is not copied and must be valid until ::led_strip_sync_free().
+ * Strips of the group should be sent only with ::led_strip_sync_flush().
+ *
+ * @param sync Group descriptor
+ * @param strips Array of pointers to strip descriptors
+ * @param count Number of strips
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_sync_init(led_strip_sync_t *sync, led_strip_t **strips, size_t count);
+
+/**
+ * @brief Release group of strips
+ *
+ * Strips themselves are not freed.
+ *
+ * @param sync Group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_sync_free(led_strip_sync_t *sync);
+
+/**
+ * @brief Send buffers of all strips in group, starting them simultaneously
+ *
+ * @param sync Group descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_sync_flush(led_strip_sync_t *sync);
+
+#endif
+
 /**
  * @brief Set color of single LED in strip
  *
@@ -153,6 +251,24 @@ esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color);
  */
 esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb_t *data);
 
+/**
+ * @brief Set colors of multiple LEDs from palette indices
+ *
+ * Colors are written straight to the strip buffer, so palette-indexed
+ * framebuffers need no intermediate RGB copy.
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param len Number of LEDs
+ * @param index Palette indices
+ * @param colors Table of 256 colors, e.g. `colors` of palette-indexed framebuffer
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_set_pixels_indexed(led_strip_t *strip, size_t start, size_t len, const uint8_t *index,
+        const rgb_t *colors);
+
 /**
  * @brief Set multiple LEDs to the one color
  *
@@ -339,7 +339,7 @@ esp_err_t led_strip_spi_fill(led_strip_spi_t*strip, size_t start, size_t len, rg
 esp_err_t led_strip_spi_set_pixel_brightness(led_strip_spi_t *strip, const int index, const rgb_t color, const uint8_t brightness)
 {
 #if CONFIG_LED_STRIP_SPI_USING_SK9822
-    return led_strip_spi_set_pixel_sk9822(strip, index, color, brightness);
+    return led_strip_spi_set_pixel_sk9822(strip, index, strip->lut ? rgb_lut_apply(strip->lut, color) : color, brightness);
 #endif
     return ESP_ERR_NOT_SUPPORTED;
 }
@@ -34,6 +34,7 @@
 #include <esp_idf_lib_helpers.h>
 #include <esp_idf_version.h>
 #include <driver/spi_master.h>
+#include <color.h>
 
 #if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 0, 0)
 #define LED_STRIP_SPI_DEFAULT_HOST_DEVICE  HSPI_HOST
@@ -72,6 +73,7 @@ typedef struct
     spi_device_handle_t device_handle;  ///< Device handle assigned by the driver. The caller must provdie this.
     int dma_chan;                       ///< DMA channed to use. Either 1 or 2.
     spi_transaction_t transaction;      ///< SPI transaction used internally by the driver.
+    const rgb_lut_t *lut;               ///< Gamma/brightness/color correction tables applied when setting pixels, may be NULL.
 } led_strip_spi_esp32_t;
 
 /**
@@ -96,6 +98,7 @@ typedef struct
  * `queue_size`: 1,
  * `device_handle`: `NULL`,
  * `dma_chan`: 1
+ * `lut`: `NULL`
  */
 #define LED_STRIP_SPI_DEFAULT_ESP32() \
 { \
@@ -109,6 +112,7 @@ typedef struct
     .queue_size = 1,                                  \
     .device_handle = NULL,                            \
     .dma_chan = LED_STRIP_SPI_DEFAULT_DMA_CHAN,       \
+    .lut = NULL,                                      \
 }
 
 /** @} */
@@ -80,12 +80,20 @@ static const char *TAG = "mcp23x17";
 
 #ifdef CONFIG_MCP23X17_IFACE_I2C
 
+// Configuration registers, GPIO/OLAT and interrupt flags are volatile.
+// IOCON is not cached: it is mirrored at 0x0B and write to either address
+// changes both
+static const uint8_t shadow_regs[] = {
+    REG_IODIRA, REG_IODIRB, REG_IPOLA, REG_IPOLB, REG_GPINTENA, REG_GPINTENB,
+    REG_DEFVALA, REG_DEFVALB, REG_INTCONA, REG_INTCONB, REG_GPPUA, REG_GPPUB
+};
+
 static esp_err_t read_reg_16(mcp23x17_t *dev, uint8_t reg, uint16_t *val)
 {
     CHECK_ARG(dev && val);
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_read_reg(dev, reg, val, 2));
+    I2C_DEV_CHECK(dev, i2c_dev_read_reg_cached(dev, reg, val, 2));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
@@ -96,7 +104,7 @@ static esp_err_t write_reg_16(mcp23x17_t *dev, uint8_t reg, uint16_t val)
     CHECK_ARG(dev);
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_write_reg(dev, reg, &val, 2));
+    I2C_DEV_CHECK(dev, i2c_dev_write_reg_cached(dev, reg, &val, 2));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
@@ -109,9 +117,9 @@ static esp_err_t write_reg_bit_16(mcp23x17_t *dev, uint8_t reg, bool val, uint8_
     uint16_t buf;
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_read_reg(dev, reg, &buf, 2));
+    I2C_DEV_CHECK(dev, i2c_dev_read_reg_cached(dev, reg, &buf, 2));
     buf = (buf & ~BV(bit)) | (val ? BV(bit) : 0);
-    I2C_DEV_CHECK(dev, i2c_dev_write_reg(dev, reg, &buf, 2));
+    I2C_DEV_CHECK(dev, i2c_dev_write_reg_cached(dev, reg, &buf, 2));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
@@ -124,7 +132,7 @@ static esp_err_t read_reg_bit_8(mcp23x17_t *dev, uint8_t reg, bool *val, uint8_t
     uint8_t buf;
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_read_reg(dev, reg, &buf, 1));
+    I2C_DEV_CHECK(dev, i2c_dev_read_reg_cached(dev, reg, &buf, 1));
     I2C_DEV_GIVE_MUTEX(dev);
 
     *val = (buf & BV(bit)) >> bit;
@@ -139,9 +147,9 @@ static esp_err_t write_reg_bit_8(mcp23x17_t *dev, uint8_t reg, bool val, uint8_t
     uint8_t buf;
 
     I2C_DEV_TAKE_MUTEX(dev);
-    I2C_DEV_CHECK(dev, i2c_dev_read_reg(dev, reg, &buf, 1));
+    I2C_DEV_CHECK(dev, i2c_dev_read_reg_cached(dev, reg, &buf, 1));
     buf = (buf & ~BV(bit)) | (val ? BV(bit) : 0);
-    I2C_DEV_CHECK(dev, i2c_dev_write_reg(dev, reg, &buf, 1));
+    I2C_DEV_CHECK(dev, i2c_dev_write_reg_cached(dev, reg, &buf, 1));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
@@ -299,7 +307,9 @@ esp_err_t mcp23x17_init_desc(mcp23x17_t *dev, uint8_t addr, i2c_port_t port, gpi
     dev->cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
-    return i2c_dev_create_mutex(dev);
+    CHECK(i2c_dev_create_mutex(dev));
+
+    return i2c_dev_shadow_init(dev, shadow_regs, sizeof(shadow_regs));
 }
 
 esp_err_t mcp23x17_free_desc(mcp23x17_t *dev)
@@ -59,6 +59,20 @@
 
 static const char *TAG = "mpu6050";
 
+// Configuration registers changed only by host, cached for read-modify-write
+static const uint8_t shadow_regs[] = {
+    MPU6050_REGISTER_SMPLRT_DIV,
+    MPU6050_REGISTER_CONFIG,
+    MPU6050_REGISTER_GYRO_CONFIG,
+    MPU6050_REGISTER_ACCEL_CONFIG,
+    MPU6050_REGISTER_FIFO_EN,
+    MPU6050_REGISTER_INT_PIN_CFG,
+    MPU6050_REGISTER_INT_ENABLE,
+    MPU6050_REGISTER_MOT_DETECT_CTRL,
+    MPU6050_REGISTER_PWR_MGMT_1,
+    MPU6050_REGISTER_PWR_MGMT_2,
+};
+
 static const float accel_res[] = {
     [MPU6050_ACCEL_RANGE_2]  = 2.0f / 32768.0f,
     [MPU6050_ACCEL_RANGE_4]  = 4.0f / 32768.0f,
@@ -100,7 +114,7 @@ static esp_err_t read_reg_bits(mpu6050_dev_t *dev, uint8_t reg_addr, uint8_t off
     uint8_t buf;
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, reg_addr, &buf, 1));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg_cached(&dev->i2c_dev, reg_addr, &buf, 1));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     *value = (buf & mask) >> offset;
@@ -112,14 +126,8 @@ static esp_err_t write_reg_bits(mpu6050_dev_t *dev, uint8_t reg_addr, uint8_t of
 {
     CHECK_ARG(dev && mask);
 
-    uint8_t buf;
-
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, reg_addr, &buf, 1));
-
-    buf = (buf & ~mask) | ((value << offset) & mask);
-
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_write_reg(&dev->i2c_dev, reg_addr, &buf, 1));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_update_reg(&dev->i2c_dev, reg_addr, mask, value << offset));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
@@ -130,7 +138,7 @@ static esp_err_t read_reg(mpu6050_dev_t *dev, uint8_t reg_addr, uint8_t *value)
     CHECK_ARG(dev && value);
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, reg_addr, value, 1));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg_cached(&dev->i2c_dev, reg_addr, value, 1));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
@@ -141,7 +149,7 @@ static esp_err_t write_reg(mpu6050_dev_t *dev, uint8_t reg_addr, uint8_t data)
     CHECK_ARG(dev);
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_write_reg(&dev->i2c_dev, reg_addr, &data, 1));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_write_reg_cached(&dev->i2c_dev, reg_addr, &data, 1));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
@@ -211,7 +219,9 @@ esp_err_t mpu6050_init_desc(mpu6050_dev_t *dev, uint8_t addr, i2c_port_t port, g
     dev->i2c_dev.cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
-    return i2c_dev_create_mutex(&dev->i2c_dev);
+    CHECK(i2c_dev_create_mutex(&dev->i2c_dev));
+
+    return i2c_dev_shadow_init(&dev->i2c_dev, shadow_regs, sizeof(shadow_regs));
 }
 
 esp_err_t mpu6050_free_desc(mpu6050_dev_t *dev)
@@ -1088,7 +1098,11 @@ esp_err_t mpu6050_reset_sensors(mpu6050_dev_t *dev)
 
 esp_err_t mpu6050_reset(mpu6050_dev_t *dev)
 {
-    return write_reg_bool(dev, MPU6050_REGISTER_PWR_MGMT_1, MPU6050_PWR1_DEVICE_RESET_BIT, 1);
+    CHECK(write_reg_bool(dev, MPU6050_REGISTER_PWR_MGMT_1, MPU6050_PWR1_DEVICE_RESET_BIT, 1));
+    // All registers are back to defaults, DEVICE_RESET bit is cleared by device
+    i2c_dev_shadow_invalidate(&dev->i2c_dev);
+
+    return ESP_OK;
 }
 
 esp_err_t mpu6050_get_sleep_enabled(mpu6050_dev_t *dev, bool *enabled)
@@ -1201,12 +1215,19 @@ esp_err_t mpu6050_get_fifo_bytes(mpu6050_dev_t *dev, uint8_t *data, size_t lengt
     CHECK_ARG(dev && data && length);
 
     I2C_DEV_TAKE_MUTEX(&dev->i2c_dev);
-    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_reg(&dev->i2c_dev, MPU6050_REGISTER_FIFO_COUNTH, data, length));
+    I2C_DEV_CHECK(&dev->i2c_dev, i2c_dev_read_bulk(&dev->i2c_dev, MPU6050_REGISTER_FIFO_R_W, data, length));
     I2C_DEV_GIVE_MUTEX(&dev->i2c_dev);
 
     return ESP_OK;
 }
 
+esp_err_t mpu6050_fifo_stream_init(mpu6050_dev_t *dev, i2c_dev_stream_t *stream, uint8_t *buf0, uint8_t *buf1, size_t size)
+{
+    CHECK_ARG(dev && stream && buf0 && buf1 && size);
+
+    return i2c_dev_stream_init(stream, &dev->i2c_dev, MPU6050_REGISTER_FIFO_R_W, buf0, buf1, size);
+}
+
 esp_err_t mpu6050_get_fifo_byte(mpu6050_dev_t *dev, uint8_t *data)
 {
     return read_reg(dev, MPU6050_REGISTER_FIFO_R_W, data);
@@ -1292,7 +1313,7 @@ esp_err_t mpu6050_calibrate(mpu6050_dev_t *dev, float *accel_bias_res, float *gy
     for (int i = 0; i < packet_count; i++)
     {
         // Read data for averaging:
-        CHECK(mpu6050_get_fifo_bytes(dev, &tmp_data[0], 6));
+        CHECK(mpu6050_get_fifo_bytes(dev, tmp_data, sizeof(tmp_data)));
         accel_temp[0] = (int16_t)(((int16_t)tmp_data[0] << 8) | tmp_data[1]);
         accel_temp[1] = (int16_t)(((int16_t)tmp_data[2] << 8) | tmp_data[3]);
         accel_temp[2] = (int16_t)(((int16_t)tmp_data[4] << 8) | tmp_data[5]);
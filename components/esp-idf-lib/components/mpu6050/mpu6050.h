@@ -2346,14 +2346,33 @@ esp_err_t mpu6050_get_fifo_byte(mpu6050_dev_t *dev, uint8_t *data);
 /**
  * @brief Get bytes from FIFO buffer.
  *
+ * Bytes are read in a single burst, see i2c_dev_read_bulk().
+ *
  * @param dev Device descriptor
  * @param[out] data Buffer to store read bytes
- * @param length How many bytes to read
+ * @param length How many bytes to read, up to 1024
  *
  * @return `ESP_OK` on success
  */
 esp_err_t mpu6050_get_fifo_bytes(mpu6050_dev_t *dev, uint8_t *data, size_t length);
 
+/**
+ * @brief Initialize double-buffered FIFO stream.
+ *
+ * Use i2c_dev_stream_next() to get the burst requested by the previous
+ * call while the next one is being read, and i2c_dev_stream_free() when
+ * done. Request sizes should be multiples of the FIFO packet size.
+ *
+ * @param dev Device descriptor
+ * @param stream Stream descriptor
+ * @param buf0 First buffer
+ * @param buf1 Second buffer
+ * @param size Size of each buffer, up to 1024
+ *
+ * @return `ESP_OK` on success
+ */
+esp_err_t mpu6050_fifo_stream_init(mpu6050_dev_t *dev, i2c_dev_stream_t *stream, uint8_t *buf0, uint8_t *buf1, size_t size);
+
 /**
  * @brief Write byte to FIFO buffer.
  *
@@ -21,6 +21,7 @@
  * SOFTWARE.
  */
 
+#include <stdlib.h>
 #include "noise.h"
 
 #define ALWAYS_INLINE static inline __attribute__((always_inline))
@@ -258,15 +259,20 @@ int16_t inoise16_3d_raw(uint32_t x, uint32_t y, uint32_t z)
     return lerp15by16(Y1, Y2, w);
 }
 
-uint16_t inoise16_3d(uint32_t x, uint32_t y, uint32_t z)
+ALWAYS_INLINE uint16_t scale_noise16_3d(int16_t raw)
 {
-    int32_t ans = inoise16_3d_raw(x, y, z);
+    int32_t ans = raw;
     ans = ans + 19052L;
     uint32_t pan = ans;
     pan *= 440L;
     return pan >> 8;
 }
 
+uint16_t inoise16_3d(uint32_t x, uint32_t y, uint32_t z)
+{
+    return scale_noise16_3d(inoise16_3d_raw(x, y, z));
+}
+
 int16_t inoise16_2d_raw(uint32_t x, uint32_t y)
 {
     // Find the unit cube containing the point
@@ -489,3 +495,250 @@ void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves,
         scx <<= 1;
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// Noise fields
+
+typedef struct
+{
+    int16_t xx;     // signed fractional part for gradients
+    uint16_t eased; // eased fractional part for interpolation
+    uint16_t cell;  // index of lattice cell
+} noise_axis_t;
+
+typedef struct
+{
+    noise_axis_t *cols;
+    noise_axis_t *rows;
+    uint8_t *cells_x;  // lattice coordinates of cells
+    uint8_t *cells_y;
+    size_t num_cells_x;
+    size_t num_cells_y;
+    uint32_t *hashes;  // gradient hashes of cell corners, 4 bits each
+    int z;             // lattice Z of hashes, -1 if not computed
+} noise_octave_t;
+
+typedef struct
+{
+    uint16_t *row;          // 16-bit samples of row for 8-bit fill
+    noise_octave_t oct[];
+} noise_cache_t;
+
+// Gradient hashes of 8 corners in the order used by inoise16_3d_raw()
+static uint32_t corner_hashes(uint8_t X, uint8_t Y, uint8_t Z)
+{
+    uint8_t A  = P(X) + Y;
+    uint8_t AA = P(A) + Z;
+    uint8_t AB = P(A + 1) + Z;
+    uint8_t B  = P(X + 1) + Y;
+    uint8_t BA = P(B) + Z;
+    uint8_t BB = P(B + 1) + Z;
+
+    return (uint32_t)(P(AA) & 15)
+           | (uint32_t)(P(BA) & 15) << 4
+           | (uint32_t)(P(AB) & 15) << 8
+           | (uint32_t)(P(BB) & 15) << 12
+           | (uint32_t)(P(AA + 1) & 15) << 16
+           | (uint32_t)(P(BA + 1) & 15) << 20
+           | (uint32_t)(P(AB + 1) & 15) << 24
+           | (uint32_t)(P(BB + 1) & 15) << 28;
+}
+
+// inoise16_3d_raw() with precomputed hashes and fractional parts
+ALWAYS_INLINE int16_t cached_noise16_3d(uint32_t h, const noise_axis_t *col, const noise_axis_t *row,
+        int16_t zz, uint16_t w)
+{
+    int16_t xx = col->xx;
+    int16_t yy = row->xx;
+    uint16_t N = 0x8000L;
+
+    int16_t X1 = lerp15by16(grad16_3d(h, xx, yy, zz), grad16_3d(h >> 4, xx - N, yy, zz), col->eased);
+    int16_t X2 = lerp15by16(grad16_3d(h >> 8, xx, yy - N, zz), grad16_3d(h >> 12, xx - N, yy - N, zz), col->eased);
+    int16_t X3 = lerp15by16(grad16_3d(h >> 16, xx, yy, zz - N), grad16_3d(h >> 20, xx - N, yy, zz - N), col->eased);
+    int16_t X4 = lerp15by16(grad16_3d(h >> 24, xx, yy - N, zz - N), grad16_3d(h >> 28, xx - N, yy - N, zz - N), col->eased);
+
+    int16_t Y1 = lerp15by16(X1, X2, row->eased);
+    int16_t Y2 = lerp15by16(X3, X4, row->eased);
+
+    return lerp15by16(Y1, Y2, w);
+}
+
+// Returns number of lattice cells spanned by axis samples.
+// With axis == NULL cells are only counted.
+static size_t setup_axis(noise_axis_t *axis, uint8_t *cells, size_t num, uint32_t origin, uint32_t scale, uint8_t octave)
+{
+    size_t count = 0;
+    uint8_t last = 0;
+    for (size_t i = 0; i < num; i++)
+    {
+        uint32_t pos = (origin + i * scale) << octave;
+        uint8_t cell = pos >> 16;
+        if (!count || last != cell)
+        {
+            if (cells)
+                cells[count] = cell;
+            last = cell;
+            count++;
+        }
+        if (!axis)
+            continue;
+        axis[i].cell = count - 1;
+        axis[i].xx = ((pos & 0xFFFF) >> 1) & 0x7FFF;
+        axis[i].eased = ease16InOutQuad(pos & 0xFFFF);
+    }
+    return count;
+}
+
+bool noise_field_init(noise_field_t *field, size_t width, size_t height, uint8_t octaves)
+{
+    if (!field || !width || !height || !octaves)
+        return false;
+
+    field->width = width;
+    field->height = height;
+    field->octaves = octaves;
+    noise_cache_t *cache = calloc(1, sizeof(noise_cache_t) + octaves * sizeof(noise_octave_t));
+    field->cache = cache;
+    if (!cache)
+        return false;
+
+    noise_octave_t *oct = cache->oct;
+    cache->row = malloc(width * sizeof(uint16_t));
+    if (!cache->row)
+    {
+        noise_field_free(field);
+        return false;
+    }
+    for (uint8_t o = 0; o < octaves; o++)
+    {
+        oct[o].cols = malloc(width * sizeof(noise_axis_t));
+        oct[o].rows = malloc(height * sizeof(noise_axis_t));
+        oct[o].cells_x = malloc(width);
+        oct[o].cells_y = malloc(height);
+        if (!oct[o].cols || !oct[o].rows || !oct[o].cells_x || !oct[o].cells_y)
+        {
+            noise_field_free(field);
+            return false;
+        }
+    }
+
+    if (!noise_field_set(field, 0, 0, 1 << 16, 1 << 16))
+    {
+        noise_field_free(field);
+        return false;
+    }
+    return true;
+}
+
+void noise_field_free(noise_field_t *field)
+{
+    if (!field || !field->cache)
+        return;
+
+    noise_cache_t *cache = (noise_cache_t *)field->cache;
+    noise_octave_t *oct = cache->oct;
+    free(cache->row);
+    for (uint8_t o = 0; o < field->octaves; o++)
+    {
+        free(oct[o].cols);
+        free(oct[o].rows);
+        free(oct[o].cells_x);
+        free(oct[o].cells_y);
+        free(oct[o].hashes);
+    }
+    free(field->cache);
+    field->cache = NULL;
+}
+
+bool noise_field_set(noise_field_t *field, uint32_t x, uint32_t y, uint32_t scale_x, uint32_t scale_y)
+{
+    if (!field || !field->cache)
+        return false;
+
+    noise_octave_t *oct = ((noise_cache_t *)field->cache)->oct;
+
+    // Grow hash buffers first: on failure the field keeps its previous state
+    for (uint8_t o = 0; o < field->octaves; o++)
+    {
+        size_t num_x = setup_axis(NULL, NULL, field->width, x, scale_x, o);
+        size_t num_y = setup_axis(NULL, NULL, field->height, y, scale_y, o);
+        if (oct[o].hashes && num_x * num_y <= oct[o].num_cells_x * oct[o].num_cells_y)
+            continue;
+        uint32_t *hashes = realloc(oct[o].hashes, num_x * num_y * sizeof(uint32_t));
+        if (!hashes)
+            return false;
+        oct[o].hashes = hashes;
+    }
+
+    field->x = x;
+    field->y = y;
+    field->scale_x = scale_x;
+    field->scale_y = scale_y;
+
+    for (uint8_t o = 0; o < field->octaves; o++)
+    {
+        oct[o].num_cells_x = setup_axis(oct[o].cols, oct[o].cells_x, field->width, x, scale_x, o);
+        oct[o].num_cells_y = setup_axis(oct[o].rows, oct[o].cells_y, field->height, y, scale_y, o);
+        oct[o].z = -1;
+    }
+
+    return true;
+}
+
+// Fill 16 bit or 8 bit samples
+static void fill_field(noise_field_t *field, uint32_t z, uint16_t *data16, uint8_t *data8)
+{
+    // time is the same for all samples
+    uint8_t Z = (z >> 16) & 0xFF;
+    uint16_t w = z & 0xFFFF;
+    int16_t zz = (w >> 1) & 0x7FFF;
+    w = ease16InOutQuad(w);
+
+    noise_cache_t *cache = (noise_cache_t *)field->cache;
+    noise_octave_t *oct = cache->oct;
+    for (uint8_t o = 0; o < field->octaves; o++)
+    {
+        // corner hashes change only when time crosses lattice cell
+        if (oct[o].z == Z)
+            continue;
+        for (size_t cy = 0; cy < oct[o].num_cells_y; cy++)
+            for (size_t cx = 0; cx < oct[o].num_cells_x; cx++)
+                oct[o].hashes[cy * oct[o].num_cells_x + cx] = corner_hashes(oct[o].cells_x[cx], oct[o].cells_y[cy], Z);
+        oct[o].z = Z;
+    }
+
+    // Row by row, octave by octave: row parts and hash row are loop
+    // invariants, octaves are summed with saturation in place
+    for (size_t j = 0; j < field->height; j++)
+    {
+        uint16_t *out = data16 ? data16 + j * field->width : cache->row;
+        for (uint8_t o = 0; o < field->octaves; o++)
+        {
+            const noise_axis_t *row = &oct[o].rows[j];
+            const noise_axis_t *col = oct[o].cols;
+            const uint32_t *hashes = oct[o].hashes + row->cell * oct[o].num_cells_x;
+            for (size_t i = 0; i < field->width; i++, col++)
+            {
+                uint32_t val = scale_noise16_3d(cached_noise16_3d(hashes[col->cell], col, row, zz, w)) >> o;
+                if (o)
+                    val += out[i];
+                out[i] = val > 65535 ? 65535 : val;
+            }
+        }
+        if (data8)
+            for (size_t i = 0; i < field->width; i++)
+                data8[j * field->width + i] = out[i] >> 8;
+    }
+}
+
+void noise_field_fill16(noise_field_t *field, uint32_t z, uint16_t *data)
+{
+    if (field && field->cache && data)
+        fill_field(field, z, data, NULL);
+}
+
+void noise_field_fill8(noise_field_t *field, uint32_t z, uint8_t *data)
+{
+    if (field && field->cache && data)
+        fill_field(field, z, NULL, data);
+}
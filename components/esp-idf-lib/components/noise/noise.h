@@ -24,6 +24,8 @@
 #ifndef __NOISE_H__
 #define __NOISE_H__
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <lib8tion.h>
 
 ///@file noise.h
@@ -91,6 +93,58 @@ int8_t inoise8_1d_raw(uint16_t x);
 void fill_raw_noise8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint16_t x, int scale, uint16_t time);
 void fill_raw_noise16into8(uint8_t *pData, uint8_t num_points, uint8_t octaves, uint32_t x, int scale, uint32_t time);
 ///@}
+
+///@name noise fields
+///@{
+/// Noise field: rectangular grid of 3d noise samples where the third
+/// coordinate is time. Sample (i, j) of octave o is
+/// inoise16_3d((x + i * scale_x) << o, (y + j * scale_y) << o, time) >> o,
+/// octaves are summed with saturation, so with one octave the field is
+/// bit-exact with inoise16_3d().
+///
+/// Per-column and per-row parts of the noise function are computed once
+/// by noise_field_set(). Gradient hashes are cached per lattice cell and
+/// shared by all samples inside the cell; they are recomputed only when
+/// time crosses a lattice cell boundary, so consecutive frames mostly
+/// cost only gradients and interpolation.
+typedef struct
+{
+    size_t width;      ///< Number of samples in row
+    size_t height;     ///< Number of rows
+    uint8_t octaves;   ///< Number of octaves
+    uint32_t x;        ///< X coordinate of first sample, 16.16 fixed point
+    uint32_t y;        ///< Y coordinate of first sample, 16.16 fixed point
+    uint32_t scale_x;  ///< Distance between samples in row, 16.16 fixed point
+    uint32_t scale_y;  ///< Distance between rows, 16.16 fixed point
+    void *cache;       ///< Internal
+} noise_field_t;
+
+/// Allocate noise field, origin is (0, 0) and scale is 1.0
+///@param field noise field descriptor
+///@param width number of samples in row
+///@param height number of rows
+///@param octaves number of octaves
+///@returns true on success
+bool noise_field_init(noise_field_t *field, size_t width, size_t height, uint8_t octaves);
+
+/// Free noise field memory
+void noise_field_free(noise_field_t *field);
+
+/// Set origin and scale of noise field. Cheap for small fields, may be
+/// called every frame to scroll the field. On failure the field keeps its
+/// previous origin and scale
+///@returns true on success
+bool noise_field_set(noise_field_t *field, uint32_t x, uint32_t y, uint32_t scale_x, uint32_t scale_y);
+
+/// Fill width * height 16-bit samples, row by row
+///@param field noise field descriptor
+///@param time time coordinate, 16.16 fixed point
+///@param data output array
+void noise_field_fill16(noise_field_t *field, uint32_t time, uint16_t *data);
+
+/// Fill width * height 8-bit samples (high bytes of 16-bit samples), row by row
+void noise_field_fill8(noise_field_t *field, uint32_t time, uint8_t *data);
+///@}
 ///@}
 
 #ifdef __cplusplus
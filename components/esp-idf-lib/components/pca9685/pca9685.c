@@ -86,6 +86,8 @@
 
 static const char *TAG = "pca9685";
 
+static const uint8_t shadow_regs[] = { REG_MODE1, REG_MODE2, REG_PRE_SCALE };
+
 inline static uint32_t round_div(uint32_t x, uint32_t y)
 {
     return (x + y / 2) / y;
@@ -93,23 +95,17 @@ inline static uint32_t round_div(uint32_t x, uint32_t y)
 
 inline static esp_err_t write_reg(i2c_dev_t *dev, uint8_t reg, uint8_t val)
 {
-    return i2c_dev_write_reg(dev, reg, &val, 1);
+    return i2c_dev_write_reg_cached(dev, reg, &val, 1);
 }
 
 inline static esp_err_t read_reg(i2c_dev_t *dev, uint8_t reg, uint8_t *val)
 {
-    return i2c_dev_read_reg(dev, reg, val, 1);
+    return i2c_dev_read_reg_cached(dev, reg, val, 1);
 }
 
-static esp_err_t update_reg(i2c_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t val)
+inline static esp_err_t update_reg(i2c_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t val)
 {
-    uint8_t v;
-
-    CHECK(read_reg(dev, reg, &v));
-    v = (v & ~mask) | val;
-    CHECK(write_reg(dev, reg, v));
-
-    return ESP_OK;
+    return i2c_dev_update_reg(dev, reg, mask, val);
 }
 
 static esp_err_t dev_sleep(i2c_dev_t *dev, bool sleep)
@@ -136,7 +132,9 @@ esp_err_t pca9685_init_desc(i2c_dev_t *dev, uint8_t addr, i2c_port_t port, gpio_
     dev->cfg.master.clk_speed = I2C_FREQ_HZ;
 #endif
 
-    return i2c_dev_create_mutex(dev);
+    CHECK(i2c_dev_create_mutex(dev));
+
+    return i2c_dev_shadow_init(dev, shadow_regs, sizeof(shadow_regs));
 }
 
 esp_err_t pca9685_free_desc(i2c_dev_t *dev)
@@ -178,14 +176,17 @@ esp_err_t pca9685_restart(i2c_dev_t *dev)
     CHECK_ARG(dev);
 
     I2C_DEV_TAKE_MUTEX(dev);
+    // RESTART bit is set by device, so bypass the register cache
     uint8_t mode;
-    I2C_DEV_CHECK(dev, read_reg(dev, REG_MODE1, &mode));
+    I2C_DEV_CHECK(dev, i2c_dev_read_reg(dev, REG_MODE1, &mode, 1));
     if (mode & MODE1_RESTART)
     {
-        I2C_DEV_CHECK(dev, write_reg(dev, REG_MODE1, mode & ~MODE1_SLEEP));
+        mode &= ~MODE1_SLEEP;
+        I2C_DEV_CHECK(dev, i2c_dev_write_reg(dev, REG_MODE1, &mode, 1));
         ets_delay_us(WAKEUP_DELAY_US);
     }
-    I2C_DEV_CHECK(dev, write_reg(dev, REG_MODE1, (mode & ~MODE1_SLEEP) | MODE1_RESTART));
+    mode = (mode & ~MODE1_SLEEP) | MODE1_RESTART;
+    I2C_DEV_CHECK(dev, i2c_dev_write_reg(dev, REG_MODE1, &mode, 1));
     I2C_DEV_GIVE_MUTEX(dev);
 
     return ESP_OK;
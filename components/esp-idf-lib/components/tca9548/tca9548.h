@@ -92,6 +92,9 @@ esp_err_t tca9548_free_desc(i2c_dev_t *dev);
 /**
  * @brief Switch channels
  *
+ * With CONFIG_I2CDEV_MUX enabled there is no need to switch channels
+ * manually, see ::i2c_dev_set_mux().
+ *
  * @param dev Device descriptor
  * @param channels Channel flags, combination of TCA9548_CHANNELn
  * @return `ESP_OK` on success
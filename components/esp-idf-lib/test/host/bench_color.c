@@ -0,0 +1,108 @@
+/*
+ * Color kernels on a 32x32 frame against per pixel reference
+ * implementations and scalar conversions
+ */
+#include <stdlib.h>
+#include <color.h>
+#include "color_ref.h"
+#include "harness.h"
+
+#define W      32
+#define H      32
+#define FRAMES 5000
+
+static rgb_t frame[W * H];
+
+static void report(const char *what, double fast, double ref)
+{
+    printf("%-28s %8.2f us/frame, reference %8.2f us/frame, x%.1f\n",
+           what, fast * 1e6 / FRAMES, ref * 1e6 / FRAMES, ref / fast);
+}
+
+static void randomize(void)
+{
+    for (size_t i = 0; i < W * H; i++)
+        frame[i] = rgb_from_values(rand(), rand(), rand());
+}
+
+static int bench_fade(void)
+{
+    randomize();
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        rgb_scale_n(frame, W * H, 250);
+    double fast = harness_now() - start;
+
+    randomize();
+    start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        ref_scale_n(frame, W * H, 250);
+    report("fade", fast, harness_now() - start);
+    return 0;
+}
+
+static int bench_blur2d(void)
+{
+    randomize();
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        blur2d(frame, W, H, 64, NULL, NULL);
+    double fast = harness_now() - start;
+
+    randomize();
+    start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        ref_blur2d(frame, W, H, 64);
+    report("blur2d", fast, harness_now() - start);
+    return 0;
+}
+
+static int bench_hsv2rgb(void)
+{
+    static hsv_t hsv[W * H];
+    for (size_t i = 0; i < W * H; i++)
+        hsv[i] = hsv_from_values(rand(), rand(), rand());
+
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        hsv2rgb_rainbow_n(hsv, frame, W * H);
+    double fast = harness_now() - start;
+
+    start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        for (size_t j = 0; j < W * H; j++)
+            frame[j] = hsv2rgb_rainbow(hsv[j]);
+    report("hsv2rgb_rainbow", fast, harness_now() - start);
+    return 0;
+}
+
+static int bench_rgb2hsv(void)
+{
+    static hsv_t hsv[W * H];
+    randomize();
+
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        rgb2hsv_approximate_n(frame, hsv, W * H);
+    double fast = harness_now() - start;
+
+    start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        for (size_t j = 0; j < W * H; j++)
+            hsv[j] = rgb2hsv_approximate(frame[j]);
+    report("rgb2hsv_approximate", fast, harness_now() - start);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    srand(1);
+    RUN_TEST(bench_fade);
+    RUN_TEST(bench_blur2d);
+    RUN_TEST(bench_hsv2rgb);
+    RUN_TEST(bench_rgb2hsv);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Bus cost of one measurement of each driver: transactions, data bytes
+ * and simulated bus time at 100 kHz with 20 us per-transaction overhead
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include <sht3x.h>
+#include <bmp280.h>
+#include <scd4x.h>
+#include <bme680.h>
+#include "harness.h"
+
+#define PORT 0
+#define OVERHEAD_US 20
+
+static void report(const char *what, const i2cdev_sim_dev_t *sim)
+{
+    printf("%-28s %6u transactions %6llu bytes %8llu us\n", what, (unsigned)sim->transactions,
+            (unsigned long long)sim->bytes, (unsigned long long)sim->bus_time_us);
+}
+
+static int bench_sht3x(void)
+{
+    static i2cdev_sim_dev_t sim;
+    sht3x_t dev;
+    float t, h;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_sht3x, PORT, SHT3X_I2C_ADDR_GND));
+    TEST_ESP_OK(sht3x_init_desc(&dev, SHT3X_I2C_ADDR_GND, PORT, 0, 0));
+    TEST_ESP_OK(sht3x_init(&dev));
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(sht3x_measure(&dev, &t, &h));
+    report("sht3x_measure", &sim);
+    TEST_ESP_OK(sht3x_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int bench_bmp280(void)
+{
+    static i2cdev_sim_dev_t sim;
+    bmp280_t dev;
+    bmp280_params_t params;
+    float t, p, h;
+    bool busy;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_bmp280, PORT, BMP280_I2C_ADDRESS_0));
+    TEST_ESP_OK(bmp280_init_desc(&dev, BMP280_I2C_ADDRESS_0, PORT, 0, 0));
+    TEST_ESP_OK(bmp280_init_default_params(&params));
+    params.mode = BMP280_MODE_FORCED;
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(bmp280_init(&dev, &params));
+    report("bmp280_init", &sim);
+
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(bmp280_force_measurement(&dev));
+    do
+    {
+        // poll every 2 ms like a typical application
+        vTaskDelay(pdMS_TO_TICKS(2));
+        TEST_ESP_OK(bmp280_is_measuring(&dev, &busy));
+    } while (busy);
+    TEST_ESP_OK(bmp280_read_float(&dev, &t, &p, &h));
+    report("bmp280 forced measurement", &sim);
+    TEST_ESP_OK(bmp280_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int bench_scd4x(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev;
+    uint16_t co2;
+    float t, h;
+    bool ready;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_scd4x, PORT, SCD4X_I2C_ADDR));
+    TEST_ESP_OK(scd4x_init_desc(&dev, PORT, 0, 0));
+    TEST_ESP_OK(scd4x_start_periodic_measurement(&dev));
+    sim.busy_until_us = 0;
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(scd4x_get_data_ready_status(&dev, &ready));
+    TEST_ESP_OK(scd4x_read_measurement(&dev, &co2, &t, &h));
+    report("scd4x ready + read", &sim);
+    TEST_ESP_OK(scd4x_stop_periodic_measurement(&dev));
+    TEST_ESP_OK(scd4x_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int bench_bme680(void)
+{
+    static i2cdev_sim_dev_t sim;
+    bme680_t dev;
+    bme680_values_float_t values;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_bme680, PORT, BME680_I2C_ADDR_1));
+    TEST_ESP_OK(bme680_init_desc(&dev, BME680_I2C_ADDR_1, PORT, 0, 0));
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(bme680_init_sensor(&dev));
+    report("bme680_init_sensor", &sim);
+    i2cdev_sim_reset_counters();
+    TEST_ESP_OK(bme680_measure_float(&dev, &values));
+    report("bme680_measure_float", &sim);
+    TEST_ESP_OK(bme680_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, OVERHEAD_US, false));
+
+    RUN_TEST(bench_sht3x);
+    RUN_TEST(bench_bmp280);
+    RUN_TEST(bench_scd4x);
+    RUN_TEST(bench_bme680);
+
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * Transaction rate of i2cdev with port and device locks taken and with
+ * locks elided on a port bound to the calling task (CONFIG_I2CDEV_PORT_OWNER).
+ * Simulated bus is instant, so the rate shows the i2cdev overhead only.
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR 0x20
+#define COUNT 200000
+
+static i2cdev_sim_dev_t sim;
+static i2c_dev_t dev;
+
+// Register read the way drivers do it: device mutex around the transaction
+static esp_err_t driver_read(uint8_t *val)
+{
+    I2C_DEV_TAKE_MUTEX(&dev);
+    I2C_DEV_CHECK(&dev, i2c_dev_read_reg(&dev, 0x10, val, 1));
+    I2C_DEV_GIVE_MUTEX(&dev);
+    return ESP_OK;
+}
+
+static int run(const char *what)
+{
+    uint8_t val;
+
+    double start = harness_now();
+    for (int i = 0; i < COUNT; i++)
+        TEST_ESP_OK(driver_read(&val));
+    double elapsed = harness_now() - start;
+
+    TEST_ASSERT(val == 0xa5);
+    printf("%-28s %10.0f transactions/s %8.1f ns/transaction\n", what, COUNT / elapsed, elapsed * 1e9 / COUNT);
+    return 0;
+}
+
+static int bench_locked(void)
+{
+    return run("locked");
+}
+
+static int bench_port_owner(void)
+{
+    TEST_ESP_OK(i2cdev_port_bind(PORT, NULL));
+    int res = run("bound to task");
+    TEST_ESP_OK(i2cdev_port_unbind(PORT));
+    return res;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, ADDR));
+    sim.regs[0x10] = 0xa5;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+
+    RUN_TEST(bench_locked);
+    RUN_TEST(bench_port_owner);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
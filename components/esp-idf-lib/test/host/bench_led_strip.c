@@ -0,0 +1,83 @@
+/*
+ * RMT translator throughput: nibble table of the driver against the
+ * per-bit reference. Translators run in RMT ISR on every memory refill,
+ * so time per LED bounds the strip length at a given frame rate.
+ */
+#include <stdlib.h>
+#include <led_strip.h>
+#include "led_strip_ref.h"
+#include "harness.h"
+
+#define CHANNEL     0
+#define REF_CHANNEL 1
+#define LENGTH      1024
+#define FRAMES      200
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#endif
+
+static led_strip_t strip = {
+    .type = LED_STRIP_WS2812,
+    .length = LENGTH,
+    .brightness = 255,
+    .channel = CHANNEL,
+};
+
+static void report(const char *what, double elapsed, double cycles)
+{
+    printf("%-28s %8.2f ns/LED", what, elapsed * 1e9 / FRAMES / LENGTH);
+    if (cycles > 0)
+        printf(" %8.1f TSC cycles/LED", cycles / FRAMES / LENGTH);
+    printf("\n");
+}
+
+static int run(const char *what, rmt_channel_t channel)
+{
+    double cycles = 0;
+#ifdef CYCLES
+    uint64_t c = CYCLES();
+#endif
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++)
+        TEST_ESP_OK(rmt_write_sample(channel, strip.buf, LENGTH * 3, true));
+    double elapsed = harness_now() - start;
+#ifdef CYCLES
+    cycles = (double)(CYCLES() - c);
+#endif
+    report(what, elapsed, cycles);
+    return 0;
+}
+
+static int bench_nibble_table(void)
+{
+    return run("nibble table", CHANNEL);
+}
+
+static int bench_per_bit_reference(void)
+{
+    TEST_ESP_OK(rmt_driver_install(REF_CHANNEL, 0, 0));
+    TEST_ESP_OK(rmt_translator_init(REF_CHANNEL, ref_rmt_adapter));
+    ref_rmt_set_type(strip.type);
+    int res = run("per-bit reference", REF_CHANNEL);
+    TEST_ESP_OK(rmt_driver_uninstall(REF_CHANNEL));
+    return res;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    led_strip_install();
+    TEST_ESP_OK(led_strip_init(&strip));
+    srand(1);
+    for (size_t i = 0; i < LENGTH * 3; i++)
+        strip.buf[i] = rand();
+
+    RUN_TEST(bench_nibble_table);
+    RUN_TEST(bench_per_bit_reference);
+
+    TEST_ESP_OK(led_strip_free(&strip));
+    return failures ? 1 : 0;
+}
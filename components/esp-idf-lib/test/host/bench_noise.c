@@ -0,0 +1,65 @@
+/*
+ * Noise field fill of a 32x32 frame against inoise16_3d() per sample,
+ * time advances slowly as in animations
+ */
+#include <noise.h>
+#include "harness.h"
+
+#define W      32
+#define H      32
+#define FRAMES 2000
+#define STEP   300
+#define SCALE  3000
+
+static uint16_t frame[W * H];
+
+static int run(uint8_t octaves)
+{
+    noise_field_t f;
+    TEST_ASSERT(noise_field_init(&f, W, H, octaves));
+    TEST_ASSERT(noise_field_set(&f, 12345, 54321, SCALE, SCALE));
+
+    uint32_t z = 0;
+    double start = harness_now();
+    for (int i = 0; i < FRAMES; i++, z += STEP)
+        noise_field_fill16(&f, z, frame);
+    double fast = harness_now() - start;
+
+    z = 0;
+    start = harness_now();
+    for (int i = 0; i < FRAMES; i++, z += STEP)
+        for (size_t y = 0; y < H; y++)
+            for (size_t x = 0; x < W; x++)
+            {
+                uint32_t acc = 0;
+                for (uint8_t o = 0; o < octaves; o++)
+                    acc += inoise16_3d((12345 + x * SCALE) << o, (54321 + y * SCALE) << o, z) >> o;
+                frame[y * W + x] = acc > 0xffff ? 0xffff : acc;
+            }
+    double ref = harness_now() - start;
+
+    printf("%u octave(s) %8.2f us/frame, inoise16_3d %8.2f us/frame, x%.1f\n",
+           octaves, fast * 1e6 / FRAMES, ref * 1e6 / FRAMES, ref / fast);
+    noise_field_free(&f);
+    return 0;
+}
+
+static int bench_one_octave(void)
+{
+    return run(1);
+}
+
+static int bench_three_octaves(void)
+{
+    return run(3);
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    RUN_TEST(bench_one_octave);
+    RUN_TEST(bench_three_octaves);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Reference implementations of color functions replaced by word-wise
+ * kernels: per pixel blur going through xy_to_offs_cb and per pixel fade.
+ */
+#ifndef __COLOR_REF_H__
+#define __COLOR_REF_H__
+
+#include <color.h>
+
+static size_t ref_width;
+
+// Row-major layout as a callback, set ref_width before use
+static inline size_t ref_xy(void *ctx, size_t x, size_t y)
+{
+    (void)ctx;
+    return y * ref_width + x;
+}
+
+static inline void ref_scale_n(rgb_t *leds, size_t num, uint8_t scaledown)
+{
+    for (size_t i = 0; i < num; i++)
+        leds[i] = rgb_scale(leds[i], scaledown);
+}
+
+static inline void ref_blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
+{
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    rgb_t carryover = rgb_from_code(0);
+    for (size_t i = 0; i < num_leds; ++i)
+    {
+        rgb_t cur = leds[i];
+        rgb_t part = rgb_scale(cur, seep);
+        cur = rgb_add_rgb(rgb_scale(cur, keep), carryover);
+        if (i)
+            leds[i - 1] = rgb_add_rgb(leds[i - 1], part);
+        leds[i] = cur;
+        carryover = part;
+    }
+}
+
+// Blur of lines going through xy(), columns if `columns` is true
+static inline void ref_blur_lines(rgb_t *leds, size_t width, size_t height, fract8 blur_amount,
+        xy_to_offs_cb xy, void *ctx, bool columns)
+{
+    uint8_t keep = 255 - blur_amount;
+    uint8_t seep = blur_amount >> 1;
+    size_t lines = columns ? width : height;
+    size_t len = columns ? height : width;
+    for (size_t line = 0; line < lines; line++)
+    {
+        rgb_t carryover = rgb_from_code(0);
+        for (size_t i = 0; i < len; i++)
+        {
+            size_t offs = columns ? xy(ctx, line, i) : xy(ctx, i, line);
+            rgb_t cur = leds[offs];
+            rgb_t part = rgb_scale(cur, seep);
+            cur = rgb_add_rgb(rgb_scale(cur, keep), carryover);
+            if (i)
+            {
+                size_t prev_offs = columns ? xy(ctx, line, i - 1) : xy(ctx, i - 1, line);
+                leds[prev_offs] = rgb_add_rgb(leds[prev_offs], part);
+            }
+            leds[offs] = cur;
+            carryover = part;
+        }
+    }
+}
+
+static inline void ref_blur2d(rgb_t *leds, size_t width, size_t height, fract8 blur_amount)
+{
+    ref_width = width;
+    ref_blur_lines(leds, width, height, blur_amount, ref_xy, NULL, false);
+    ref_blur_lines(leds, width, height, blur_amount, ref_xy, NULL, true);
+}
+
+#endif /* __COLOR_REF_H__ */
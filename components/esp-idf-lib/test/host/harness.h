@@ -0,0 +1,39 @@
+/*
+ * Minimal test harness for host tests: a test is a function returning
+ * 0 on success, TEST_ASSERT() reports the failed condition and returns 1.
+ */
+#ifndef __HARNESS_H__
+#define __HARNESS_H__
+
+#include <stdio.h>
+#include <time.h>
+
+#define TEST_ASSERT(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+#define TEST_ESP_OK(x) do { \
+        esp_err_t __res = (x); \
+        if (__res != ESP_OK) { \
+            fprintf(stderr, "%s:%d: %s returned %d\n", __FILE__, __LINE__, #x, __res); \
+            return 1; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) do { \
+        int __res = fn(); \
+        printf("%-40s %s\n", #fn, __res ? "FAIL" : "ok"); \
+        failures += __res; \
+    } while (0)
+
+static inline double harness_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#endif /* __HARNESS_H__ */
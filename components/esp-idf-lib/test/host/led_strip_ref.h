@@ -0,0 +1,60 @@
+/*
+ * Reference RMT translator of led_strip: per-bit expansion with a branch
+ * per bit, as the driver did before the nibble table.
+ */
+#ifndef __LED_STRIP_REF_H__
+#define __LED_STRIP_REF_H__
+
+#include <led_strip.h>
+
+#define REF_RMT_CLK_DIV 2
+
+// T0H, T0L, T1H, T1L from the datasheets, ns
+static const uint32_t ref_timings[LED_STRIP_TYPE_MAX][4] = {
+    [LED_STRIP_WS2812]  = { 400, 1000, 1000, 400 },
+    [LED_STRIP_SK6812]  = { 300, 900, 600, 600 },
+    [LED_STRIP_APA106]  = { 350, 1360, 1360, 350 },
+    [LED_STRIP_SM16703] = { 300, 900, 1360, 350 },
+};
+
+static rmt_item32_t ref_bit0, ref_bit1;
+
+static inline void ref_rmt_set_type(led_strip_type_t type)
+{
+    float ratio = (float)APB_CLK_FREQ / REF_RMT_CLK_DIV / 1e09f;
+    const uint32_t *t = ref_timings[type];
+
+    ref_bit0.val = 0;
+    ref_bit0.duration0 = (uint32_t)(ratio * t[0]);
+    ref_bit0.level0 = 1;
+    ref_bit0.duration1 = (uint32_t)(ratio * t[1]);
+    ref_bit1.val = 0;
+    ref_bit1.duration0 = (uint32_t)(ratio * t[2]);
+    ref_bit1.level0 = 1;
+    ref_bit1.duration1 = (uint32_t)(ratio * t[3]);
+}
+
+static void ref_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
+        size_t wanted_num, size_t *translated_size, size_t *item_num)
+{
+    size_t size = 0;
+    size_t num = 0;
+    const uint8_t *psrc = (const uint8_t *)src;
+    rmt_item32_t *pdest = dest;
+    while (size < src_size && num < wanted_num)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            // MSB first
+            pdest->val = *psrc & (1 << (7 - i)) ? ref_bit1.val : ref_bit0.val;
+            num++;
+            pdest++;
+        }
+        size++;
+        psrc++;
+    }
+    *translated_size = size;
+    *item_num = num;
+}
+
+#endif /* __LED_STRIP_REF_H__ */
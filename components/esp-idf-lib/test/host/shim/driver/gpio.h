@@ -0,0 +1,8 @@
+#ifndef __SHIM_DRIVER_GPIO_H__
+#define __SHIM_DRIVER_GPIO_H__
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC (-1)
+
+#endif
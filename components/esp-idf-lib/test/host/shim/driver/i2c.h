@@ -0,0 +1,37 @@
+/*
+ * Legacy I2C driver types used by i2cdev on ESP32 targets. Only the
+ * i2c_master shim (see i2c_master.c) is implemented for host tests.
+ */
+#ifndef __SHIM_DRIVER_I2C_H__
+#define __SHIM_DRIVER_I2C_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <driver/gpio.h>
+
+#define I2C_NUM_MAX 2
+
+typedef int i2c_port_t;
+
+typedef enum
+{
+    I2C_MODE_SLAVE = 0,
+    I2C_MODE_MASTER,
+} i2c_mode_t;
+
+typedef struct
+{
+    i2c_mode_t mode;
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    struct
+    {
+        uint32_t clk_speed;
+    } master;
+    uint32_t clk_flags;
+} i2c_config_t;
+
+#endif
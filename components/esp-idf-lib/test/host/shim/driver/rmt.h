@@ -0,0 +1,71 @@
+/*
+ * Legacy RMT driver API for host tests, see rmt.c. Samples written to
+ * a channel go through its translator into a per-channel item buffer.
+ */
+#ifndef __SHIM_DRIVER_RMT_H__
+#define __SHIM_DRIVER_RMT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <driver/gpio.h>
+
+#define APB_CLK_FREQ 80000000
+
+/* Items translated per call, as a half of RMT memory block on refill */
+#define RMT_SHIM_CHUNK 32
+
+typedef int rmt_channel_t;
+
+#define RMT_CHANNEL_MAX 8
+
+typedef enum
+{
+    RMT_MODE_TX = 0,
+} rmt_mode_t;
+
+typedef struct
+{
+    union
+    {
+        struct
+        {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef struct
+{
+    rmt_mode_t rmt_mode;
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) \
+    { .rmt_mode = RMT_MODE_TX, .channel = channel_id, .gpio_num = gpio, .clk_div = 80, .mem_block_num = 1 }
+
+typedef void (*sample_to_rmt_t)(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num,
+        size_t *translated_size, size_t *item_num);
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void *arg);
+
+esp_err_t rmt_config(const rmt_config_t *config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn);
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time);
+rmt_tx_end_fn_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg);
+
+/* Items of the last sample written to the channel */
+size_t rmt_shim_items(rmt_channel_t channel, const rmt_item32_t **items);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef __SHIM_ESP_ATTR_H__
+#define __SHIM_ESP_ATTR_H__
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef __SHIM_ESP_BIT_DEFS_H__
+#define __SHIM_ESP_BIT_DEFS_H__
+
+#define BIT(nr) (1UL << (nr))
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef __SHIM_ESP_IDF_VERSION_H__
+#define __SHIM_ESP_IDF_VERSION_H__
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(5, 2, 0)
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __SHIM_ESP_LOG_H__
+#define __SHIM_ESP_LOG_H__
+
+#include <stdio.h>
+
+/* Errors and warnings only, tests print their own results. Arguments of
+ * silent levels are still evaluated by the compiler for format checks */
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOG_SILENT(tag, fmt, ...) do { (void)(tag); if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_SILENT(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) ESP_LOG_SILENT(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) ESP_LOG_SILENT(tag, fmt, ##__VA_ARGS__)
+
+#define ESP_LOG_VERBOSE 5
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buf, len, level) do { (void)(tag); (void)(buf); (void)(len); } while (0)
+
+#endif /* __SHIM_ESP_LOG_H__ */
@@ -0,0 +1,9 @@
+#ifndef __SHIM_ESP_TIMER_H__
+#define __SHIM_ESP_TIMER_H__
+
+#include <stdint.h>
+
+/* Monotonic time, us */
+int64_t esp_timer_get_time(void);
+
+#endif
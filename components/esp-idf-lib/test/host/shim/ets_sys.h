@@ -0,0 +1,8 @@
+#ifndef __SHIM_ETS_SYS_H__
+#define __SHIM_ETS_SYS_H__
+
+#include <stdint.h>
+
+void ets_delay_us(uint32_t us);
+
+#endif
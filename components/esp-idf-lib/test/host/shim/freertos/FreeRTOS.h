@@ -0,0 +1,35 @@
+/* Minimal FreeRTOS API for host tests, see shim.c */
+#ifndef __SHIM_FREERTOS_H__
+#define __SHIM_FREERTOS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sdkconfig.h>
+#include <esp_idf_version.h> /* these come with FreeRTOS headers of ESP-IDF */
+#include <esp_bit_defs.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdFAIL  0
+#define pdPASS  1
+
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY      ((TickType_t)0xffffffff)
+#define pdMS_TO_TICKS(ms)  ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+/* Single process, critical sections are not needed */
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)      ((void)(mux))
+#define portEXIT_CRITICAL(mux)       ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux)  ((void)(mux))
+#define portYIELD_FROM_ISR()         do {} while (0)
+
+#endif /* __SHIM_FREERTOS_H__ */
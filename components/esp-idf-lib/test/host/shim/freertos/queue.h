@@ -0,0 +1,13 @@
+#ifndef __SHIM_QUEUE_H__
+#define __SHIM_QUEUE_H__
+
+#include "FreeRTOS.h"
+
+typedef struct shim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t q);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks);
+
+#endif /* __SHIM_QUEUE_H__ */
@@ -0,0 +1,16 @@
+#ifndef __SHIM_SEMPHR_H__
+#define __SHIM_SEMPHR_H__
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef struct shim_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t sem);
+
+#endif /* __SHIM_SEMPHR_H__ */
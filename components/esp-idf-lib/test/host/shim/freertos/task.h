@@ -0,0 +1,21 @@
+#ifndef __SHIM_TASK_H__
+#define __SHIM_TASK_H__
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+/* Every thread is a task, handle is unique per thread */
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+
+/* Tasks run as detached threads, priority and stack depth are ignored */
+typedef void (*TaskFunction_t)(void *);
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *created);
+void vTaskDelete(TaskHandle_t handle);
+BaseType_t xTaskNotifyGive(TaskHandle_t handle);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+#endif /* __SHIM_TASK_H__ */
@@ -0,0 +1,107 @@
+/*
+ * I2C master driver for host tests: bus and device handles are plain
+ * allocations, transfers are executed by the i2cdev simulator. Built
+ * together with i2cdev, see add_i2cdev_master() in CMakeLists.txt.
+ */
+#include <stdlib.h>
+#include <driver/i2c_master.h>
+#include <i2cdev_sim.h>
+
+struct i2c_master_bus_t
+{
+    i2c_port_t port;
+};
+
+struct i2c_master_dev_t
+{
+    i2c_dev_t dev;
+};
+
+static size_t devices, added;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *bus_config, i2c_master_bus_handle_t *ret_bus_handle)
+{
+    if (!bus_config || !ret_bus_handle || bus_config->i2c_port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    i2c_master_bus_handle_t bus = calloc(1, sizeof(struct i2c_master_bus_t));
+    if (!bus)
+        return ESP_ERR_NO_MEM;
+    bus->port = bus_config->i2c_port;
+    *ret_bus_handle = bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus_handle)
+{
+    free(bus_handle);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus_handle, const i2c_device_config_t *dev_config,
+        i2c_master_dev_handle_t *ret_handle)
+{
+    if (!bus_handle || !dev_config || !ret_handle)
+        return ESP_ERR_INVALID_ARG;
+
+    i2c_master_dev_handle_t handle = calloc(1, sizeof(struct i2c_master_dev_t));
+    if (!handle)
+        return ESP_ERR_NO_MEM;
+    handle->dev.port = bus_handle->port;
+    handle->dev.addr = dev_config->device_address;
+    handle->dev.cfg.master.clk_speed = dev_config->scl_speed_hz;
+    devices++;
+    added++;
+    *ret_handle = handle;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    if (!handle)
+        return ESP_ERR_INVALID_ARG;
+    free(handle);
+    devices--;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+        int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    i2c_dev_segment_t seg = I2C_DEV_SEG_WRITE(write_buffer, write_size);
+    return i2cdev_sim_transfer(&i2c_dev->dev, &seg, 1);
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t i2c_dev, uint8_t *read_buffer, size_t read_size,
+        int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    i2c_dev_segment_t seg = I2C_DEV_SEG_READ(read_buffer, read_size);
+    return i2cdev_sim_transfer(&i2c_dev->dev, &seg, 1);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t *write_buffer, size_t write_size,
+        uint8_t *read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    i2c_dev_segment_t segs[] = {
+        I2C_DEV_SEG_WRITE(write_buffer, write_size),
+        I2C_DEV_SEG_READ(read_buffer, read_size),
+    };
+    return i2cdev_sim_transfer(&i2c_dev->dev, segs, 2);
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus_handle, uint16_t address, int xfer_timeout_ms)
+{
+    (void)xfer_timeout_ms;
+    i2c_dev_t dev = { .port = bus_handle->port, .addr = address };
+    return i2cdev_sim_probe(&dev, I2C_DEV_WRITE);
+}
+
+size_t i2c_master_shim_devices(size_t *total)
+{
+    if (total)
+        *total = added;
+    return devices;
+}
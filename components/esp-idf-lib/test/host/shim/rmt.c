@@ -0,0 +1,106 @@
+/*
+ * Legacy RMT driver for host tests: translation is done synchronously
+ * in rmt_write_sample() in chunks, the result is kept for inspection.
+ */
+#include <stdlib.h>
+#include <driver/rmt.h>
+
+typedef struct
+{
+    bool installed;
+    sample_to_rmt_t translator;
+    rmt_item32_t *items;
+    size_t capacity;
+    size_t count;
+} shim_channel_t;
+
+static shim_channel_t channels[RMT_CHANNEL_MAX];
+static rmt_tx_end_fn_t tx_end_cb;
+static void *tx_end_arg;
+
+esp_err_t rmt_config(const rmt_config_t *config)
+{
+    return config->channel >= 0 && config->channel < RMT_CHANNEL_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+    (void)rx_buf_size;
+    (void)intr_alloc_flags;
+    if (channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    channels[channel].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+    shim_channel_t *ch = &channels[channel];
+    if (!ch->installed)
+        return ESP_ERR_INVALID_STATE;
+    free(ch->items);
+    *ch = (shim_channel_t){ 0 };
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn)
+{
+    if (!channels[channel].installed)
+        return ESP_ERR_INVALID_STATE;
+    channels[channel].translator = fn;
+    return ESP_OK;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done)
+{
+    (void)wait_tx_done;
+    shim_channel_t *ch = &channels[channel];
+    if (!ch->installed || !ch->translator)
+        return ESP_ERR_INVALID_STATE;
+
+    // A byte is translated completely, so a chunk may be overrun by 7 items
+    size_t needed = src_size * 8 + RMT_SHIM_CHUNK;
+    if (needed > ch->capacity)
+    {
+        rmt_item32_t *items = realloc(ch->items, needed * sizeof(rmt_item32_t));
+        if (!items)
+            return ESP_ERR_NO_MEM;
+        ch->items = items;
+        ch->capacity = needed;
+    }
+
+    ch->count = 0;
+    while (src_size)
+    {
+        size_t translated, num;
+        ch->translator(src, ch->items + ch->count, src_size, RMT_SHIM_CHUNK, &translated, &num);
+        if (!translated)
+            return ESP_FAIL;
+        src += translated;
+        src_size -= translated;
+        ch->count += num;
+    }
+    if (tx_end_cb)
+        tx_end_cb(channel, tx_end_arg);
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time)
+{
+    (void)wait_time;
+    return channels[channel].installed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+rmt_tx_end_fn_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg)
+{
+    rmt_tx_end_fn_t prev = tx_end_cb;
+    tx_end_cb = function;
+    tx_end_arg = arg;
+    return prev;
+}
+
+size_t rmt_shim_items(rmt_channel_t channel, const rmt_item32_t **items)
+{
+    *items = channels[channel].items;
+    return channels[channel].count;
+}
@@ -0,0 +1 @@
+/* Configuration is passed by compile definitions of the test targets */
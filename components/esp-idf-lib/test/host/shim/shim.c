@@ -0,0 +1,368 @@
+/*
+ * Host implementation of the FreeRTOS and ESP-IDF functions used by the
+ * tested components. Tasks are threads, semaphores and queues are pthread
+ * mutexes with conditions.
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <freertos/queue.h>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <ets_sys.h>
+
+// Waiting task, served in FIFO order as tasks of equal priority in FreeRTOS
+struct shim_waiter
+{
+    struct shim_waiter *next;
+    bool granted;
+};
+
+struct shim_semaphore
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool mutex;
+    unsigned count;
+    TaskHandle_t holder;
+    struct shim_waiter *waiters;
+};
+
+// Every thread is a task, handle points to its thread-local state
+struct shim_task
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+};
+
+static __thread struct shim_task task = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
+
+static void deadline_after(struct timespec *deadline, TickType_t ticks)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    uint64_t ns = deadline->tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+    deadline->tv_sec += ns / 1000000000;
+    deadline->tv_nsec = ns % 1000000000;
+}
+
+// Wait on condition with FreeRTOS timeout, false on timeout
+static bool wait_ticks(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline)
+{
+    if (ticks == portMAX_DELAY)
+        return !pthread_cond_wait(cond, lock);
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return &task;
+}
+
+typedef struct
+{
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    TaskHandle_t handle;
+} task_start_t;
+
+static void *task_thread(void *arg)
+{
+    task_start_t *start = arg;
+    TaskFunction_t fn = start->fn;
+    void *fn_arg = start->arg;
+
+    pthread_mutex_lock(&start->lock);
+    start->handle = xTaskGetCurrentTaskHandle();
+    pthread_cond_signal(&start->cond);
+    pthread_mutex_unlock(&start->lock);
+
+    fn(fn_arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+        UBaseType_t priority, TaskHandle_t *created)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    task_start_t start = { .fn = fn, .arg = arg };
+    pthread_mutex_init(&start.lock, NULL);
+    pthread_cond_init(&start.cond, NULL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_thread, &start))
+        return pdFAIL;
+    pthread_detach(thread);
+
+    // Handle is known only when the task runs
+    pthread_mutex_lock(&start.lock);
+    while (!start.handle)
+        pthread_cond_wait(&start.cond, &start.lock);
+    pthread_mutex_unlock(&start.lock);
+    pthread_cond_destroy(&start.cond);
+    pthread_mutex_destroy(&start.lock);
+
+    if (created)
+        *created = start.handle;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle)
+{
+    // Only self-deletion is supported
+    if (!handle || handle == xTaskGetCurrentTaskHandle())
+        pthread_exit(NULL);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    struct shim_task *t = handle;
+    pthread_mutex_lock(&t->lock);
+    t->notify++;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+    return pdPASS;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+static void sleep_us(uint64_t us)
+{
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) && errno == EINTR)
+        ;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sleep_us((uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&task.lock);
+    while (!task.notify && ticks && wait_ticks(&task.cond, &task.lock, ticks, &deadline))
+        ;
+    uint32_t value = task.notify;
+    if (value)
+        task.notify = clear ? 0 : value - 1;
+    pthread_mutex_unlock(&task.lock);
+    return value;
+}
+
+void ets_delay_us(uint32_t us)
+{
+    sleep_us(us);
+}
+
+static SemaphoreHandle_t create(bool mutex, unsigned count)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(struct shim_semaphore));
+    if (!sem)
+        return NULL;
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->mutex = mutex;
+    sem->count = count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return create(true, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return create(false, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (!sem)
+        return;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
+
+static void remove_waiter(SemaphoreHandle_t sem, struct shim_waiter *w)
+{
+    for (struct shim_waiter **p = &sem->waiters; *p; p = &(*p)->next)
+        if (*p == w)
+        {
+            *p = w->next;
+            return;
+        }
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count)
+        sem->count--;
+    else
+    {
+        // Give hands the semaphore over to the first waiter
+        struct shim_waiter self = { 0 };
+        struct shim_waiter **tail = &sem->waiters;
+        while (*tail)
+            tail = &(*tail)->next;
+        *tail = &self;
+        while (!self.granted)
+        {
+            if (!wait_ticks(&sem->cond, &sem->lock, ticks, &deadline) && !self.granted)
+            {
+                remove_waiter(sem, &self);
+                pthread_mutex_unlock(&sem->lock);
+                return pdFALSE;
+            }
+        }
+    }
+    if (sem->mutex)
+        sem->holder = xTaskGetCurrentTaskHandle();
+    pthread_mutex_unlock(&sem->lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t res = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    if (!sem->count && (!sem->mutex || sem->holder == xTaskGetCurrentTaskHandle()))
+    {
+        sem->holder = NULL;
+        if (sem->waiters)
+        {
+            sem->waiters->granted = true;
+            sem->waiters = sem->waiters->next;
+            pthread_cond_broadcast(&sem->cond);
+        }
+        else
+            sem->count = 1;
+        res = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return res;
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    TaskHandle_t holder = sem->holder;
+    pthread_mutex_unlock(&sem->lock);
+    return holder;
+}
+
+struct shim_queue
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    size_t item_size, length, head, count;
+    uint8_t items[];
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t q = calloc(1, sizeof(struct shim_queue) + (size_t)length * item_size);
+    if (!q)
+        return NULL;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->item_size = item_size;
+    q->length = length;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    if (!q)
+        return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->length)
+        if (!ticks || !wait_ticks(&q->cond, &q->lock, ticks, &deadline))
+        {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    memcpy(q->items + (q->head + q->count) % q->length * q->item_size, item, q->item_size);
+    q->count++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks)
+{
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+
+    pthread_mutex_lock(&q->lock);
+    while (!q->count)
+        if (!ticks || !wait_ticks(&q->cond, &q->lock, ticks, &deadline))
+        {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    memcpy(item, q->items + q->head * q->item_size, q->item_size);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+        default: return "UNKNOWN ERROR";
+    }
+}
@@ -0,0 +1 @@
+/* No I2C peripheral on host, i2cdev uses its default stretch time */
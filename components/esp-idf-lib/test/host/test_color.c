@@ -0,0 +1,227 @@
+/*
+ * Word-wise color kernels against per pixel reference implementations
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <color.h>
+#include <framebuffer.h>
+#include "color_ref.h"
+#include "harness.h"
+
+#define ROUNDS 20000
+#define MAX_W  13
+#define MAX_H  9
+
+static void randomize(rgb_t *leds, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        leds[i] = rgb_from_values(rand(), rand(), rand());
+}
+
+// Odd sizes and unaligned starts exercise partial words of kernels
+static int test_scale_n(void)
+{
+    rgb_t a[MAX_W * MAX_H + 1], b[MAX_W * MAX_H + 1];
+
+    srand(1);
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        size_t start = round & 3;
+        size_t num = rand() % (MAX_W * MAX_H + 1 - start);
+        uint8_t scale = rand();
+        randomize(a, MAX_W * MAX_H + 1);
+        memcpy(b, a, sizeof(a));
+
+        rgb_scale_n(a + start, num, scale);
+        ref_scale_n(b + start, num, scale);
+        TEST_ASSERT(!memcmp(a, b, sizeof(a)));
+    }
+    return 0;
+}
+
+static int test_blur1d(void)
+{
+    rgb_t a[MAX_W * MAX_H + 1], b[MAX_W * MAX_H + 1];
+
+    srand(2);
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        size_t start = round & 3;
+        size_t num = rand() % (MAX_W * MAX_H + 1 - start);
+        uint8_t amount = rand();
+        randomize(a, MAX_W * MAX_H + 1);
+        memcpy(b, a, sizeof(a));
+
+        blur1d(a + start, num, amount);
+        ref_blur1d(b + start, num, amount);
+        TEST_ASSERT(!memcmp(a, b, sizeof(a)));
+    }
+    return 0;
+}
+
+static int test_blur_rows_columns(void)
+{
+    rgb_t a[MAX_W * MAX_H], b[MAX_W * MAX_H], c[MAX_W * MAX_H];
+
+    srand(3);
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        size_t w = 1 + rand() % MAX_W;
+        size_t h = 1 + rand() % MAX_H;
+        uint8_t amount = rand();
+        bool columns = round & 1;
+        randomize(a, w * h);
+        memcpy(b, a, sizeof(a));
+        memcpy(c, a, sizeof(a));
+
+        // fast path, callback path and reference
+        ref_width = w;
+        if (columns)
+        {
+            blur_columns(a, w, h, amount, NULL, NULL);
+            blur_columns(b, w, h, amount, ref_xy, NULL);
+        }
+        else
+        {
+            blur_rows(a, w, h, amount, NULL, NULL);
+            blur_rows(b, w, h, amount, ref_xy, NULL);
+        }
+        ref_blur_lines(c, w, h, amount, ref_xy, NULL, columns);
+        TEST_ASSERT(!memcmp(a, c, w * h * sizeof(rgb_t)));
+        TEST_ASSERT(!memcmp(b, c, w * h * sizeof(rgb_t)));
+    }
+    return 0;
+}
+
+static esp_err_t render(framebuffer_t *fb, void *arg)
+{
+    (void)fb;
+    (void)arg;
+    return ESP_OK;
+}
+
+static int test_fb_fade_blur(void)
+{
+    framebuffer_t fb;
+    rgb_t ref[MAX_W * MAX_H];
+
+    srand(4);
+    for (int round = 0; round < ROUNDS / 10; round++)
+    {
+        size_t w = 1 + rand() % MAX_W;
+        size_t h = 1 + rand() % MAX_H;
+        uint8_t amount = rand();
+
+        TEST_ESP_OK(fb_init(&fb, w, h, render));
+        randomize(fb.data, w * h);
+        memcpy(ref, fb.data, w * h * sizeof(rgb_t));
+
+        TEST_ESP_OK(fb_fade(&fb, amount));
+        for (size_t i = 0; i < w * h; i++)
+            ref[i] = rgb_fade(ref[i], amount);
+        TEST_ASSERT(!memcmp(fb.data, ref, w * h * sizeof(rgb_t)));
+
+        TEST_ESP_OK(fb_blur2d(&fb, amount));
+        ref_blur2d(ref, w, h, amount);
+        TEST_ASSERT(!memcmp(fb.data, ref, w * h * sizeof(rgb_t)));
+
+        TEST_ESP_OK(fb_free(&fb));
+    }
+    return 0;
+}
+
+// Every input of both conversions, in batches as in frame rendering
+static int test_hsv_rgb_batch(void)
+{
+    hsv_t hsv[256], hsv_out[256];
+    rgb_t rgb[256], rgb_out[256];
+
+    for (uint32_t hi = 0; hi < 0x10000; hi++)
+    {
+        for (size_t lo = 0; lo < 256; lo++)
+        {
+            hsv[lo] = hsv_from_values(hi >> 8, hi & 0xff, lo);
+            rgb[lo] = rgb_from_values(hi >> 8, hi & 0xff, lo);
+        }
+        hsv2rgb_rainbow_n(hsv, rgb_out, 256);
+        rgb2hsv_approximate_n(rgb, hsv_out, 256);
+        for (size_t lo = 0; lo < 256; lo++)
+        {
+            rgb_t r = hsv2rgb_rainbow(hsv[lo]);
+            hsv_t h = rgb2hsv_approximate(rgb[lo]);
+            TEST_ASSERT(!memcmp(&r, &rgb_out[lo], sizeof(rgb_t)));
+            TEST_ASSERT(!memcmp(&h, &hsv_out[lo], sizeof(hsv_t)));
+        }
+    }
+    return 0;
+}
+
+static const rgb_t no_correction = { .r = 255, .g = 255, .b = 255 };
+
+static int test_lut_set(void)
+{
+    rgb_lut_t lut = { 0 };
+
+    // recomputed only on change
+    TEST_ASSERT(rgb_lut_set(&lut, 2.2f, 255, no_correction));
+    TEST_ASSERT(!rgb_lut_set(&lut, 2.2f, 255, no_correction));
+    TEST_ASSERT(rgb_lut_set(&lut, 2.2f, 254, no_correction));
+    TEST_ASSERT(rgb_lut_set(&lut, 2.2f, 254, (rgb_t){ .r = 255, .g = 176, .b = 240 }));
+    TEST_ASSERT(rgb_lut_set(&lut, 1.0f, 254, (rgb_t){ .r = 255, .g = 176, .b = 240 }));
+
+    // same as per pixel gamma functions
+    TEST_ASSERT(rgb_lut_set(&lut, 2.2f, 255, no_correction));
+    for (int i = 0; i < 256; i++)
+    {
+        rgb_t c = rgb_from_values(i, 255 - i, i / 2);
+        rgb_t ref = apply_gamma2rgb(c, 2.2f);
+        rgb_t res = rgb_lut_apply(&lut, c);
+        TEST_ASSERT(!memcmp(&res, &ref, sizeof(rgb_t)));
+    }
+
+    // linear with brightness
+    TEST_ASSERT(rgb_lut_set(&lut, 1.0f, 255, no_correction));
+    for (int i = 0; i < 256; i++)
+        TEST_ASSERT(lut.r[i] == i && lut.g[i] == i && lut.b[i] == i);
+    TEST_ASSERT(rgb_lut_set(&lut, 1.0f, 100, no_correction));
+    for (int i = 0; i < 256; i++)
+        TEST_ASSERT(lut.r[i] == scale8_video(i, 100) && lut.g[i] == lut.r[i] && lut.b[i] == lut.r[i]);
+
+    // correction scales channels on top of brightness, lit LEDs stay lit
+    TEST_ASSERT(rgb_lut_set(&lut, 2.2f, 128, (rgb_t){ .r = 255, .g = 176, .b = 0 }));
+    TEST_ASSERT(lut.r[255] == 128 && lut.g[255] == 88 && lut.b[255] == 0);
+    for (int i = 1; i < 256; i++)
+        TEST_ASSERT(lut.r[i] >= lut.r[i - 1] && lut.r[i] && lut.g[i] && !lut.b[i]);
+
+    return 0;
+}
+
+static int test_lut_apply_n(void)
+{
+    rgb_lut_t lut = { 0 };
+    rgb_t a[MAX_W * MAX_H], b[MAX_W * MAX_H];
+
+    srand(5);
+    TEST_ASSERT(rgb_lut_set(&lut, 2.5f, 200, (rgb_t){ .r = 255, .g = 176, .b = 240 }));
+    randomize(a, MAX_W * MAX_H);
+    for (size_t i = 0; i < MAX_W * MAX_H; i++)
+        b[i] = rgb_lut_apply(&lut, a[i]);
+    rgb_lut_apply_n(&lut, a, MAX_W * MAX_H);
+    TEST_ASSERT(!memcmp(a, b, sizeof(a)));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    RUN_TEST(test_scale_n);
+    RUN_TEST(test_blur1d);
+    RUN_TEST(test_blur_rows_columns);
+    RUN_TEST(test_fb_fade_blur);
+    RUN_TEST(test_hsv_rgb_batch);
+    RUN_TEST(test_lut_set);
+    RUN_TEST(test_lut_apply_n);
+
+    return failures ? 1 : 0;
+}
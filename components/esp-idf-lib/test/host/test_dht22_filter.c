@@ -0,0 +1,87 @@
+/*
+ * Hampel filter of DHT22 bursts (application component dht22)
+ */
+#include <math.h>
+#include <dht22_filter.h>
+#include "harness.h"
+
+#define NEAR(a, b) (fabsf((a) - (b)) < 1e-4f)
+
+static int test_spike_rejected(void)
+{
+    const float samples[] = { 21.0f, 21.1f, 35.0f, 21.0f, 21.1f };
+    float result;
+    uint8_t confidence;
+
+    TEST_ASSERT(dht22_filter_hampel(samples, 5, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 21.05f));
+    TEST_ASSERT(confidence == 80);
+    return 0;
+}
+
+static int test_equal_samples(void)
+{
+    // MAD is 0, resolution of the sensor is the threshold
+    const float equal[] = { 20.0f, 20.0f, 20.0f, 20.0f };
+    const float spike[] = { 20.0f, 20.0f, 20.3f, 20.0f };
+    const float step[] = { 20.0f, 20.0f, 20.1f, 20.0f };
+    float result;
+    uint8_t confidence;
+
+    TEST_ASSERT(dht22_filter_hampel(equal, 4, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 20.0f) && confidence == 100);
+    TEST_ASSERT(dht22_filter_hampel(spike, 4, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 20.0f) && confidence == 75);
+    TEST_ASSERT(dht22_filter_hampel(step, 4, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 20.025f) && confidence == 100);
+    return 0;
+}
+
+static int test_single_sample(void)
+{
+    const float one = 23.4f, failed = NAN;
+    float result;
+    uint8_t confidence = 0;
+
+    TEST_ASSERT(dht22_filter_hampel(&one, 1, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 23.4f) && confidence == 100);
+    TEST_ASSERT(dht22_filter_median(&one, 1, &result) && NEAR(result, 23.4f));
+
+    confidence = 100;
+    TEST_ASSERT(!dht22_filter_hampel(&failed, 1, &result, &confidence));
+    TEST_ASSERT(confidence == 0);
+    TEST_ASSERT(!dht22_filter_median(&failed, 1, &result));
+    return 0;
+}
+
+static int test_confidence(void)
+{
+    // failed reads count as rejected samples
+    const float samples[] = { 20.0f, NAN, 20.2f, 20.1f, NAN, 20.1f };
+    const float failed[] = { NAN, NAN, NAN };
+    float result;
+    uint8_t confidence;
+
+    TEST_ASSERT(dht22_filter_hampel(samples, 6, &result, &confidence));
+    TEST_ASSERT(NEAR(result, 20.1f));
+    TEST_ASSERT(confidence == 4 * 100 / 6);
+    TEST_ASSERT(dht22_filter_median(samples, 6, &result) && NEAR(result, 20.1f));
+
+    // confidence is optional
+    TEST_ASSERT(dht22_filter_hampel(samples, 6, &result, NULL));
+    TEST_ASSERT(!dht22_filter_hampel(failed, 3, &result, &confidence));
+    TEST_ASSERT(confidence == 0);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    RUN_TEST(test_spike_rejected);
+    RUN_TEST(test_equal_samples);
+    RUN_TEST(test_single_sample);
+    RUN_TEST(test_confidence);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,297 @@
+/*
+ * Framebuffer dirty row tracking and palette mode
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <framebuffer.h>
+#include <led_strip.h>
+#include "harness.h"
+
+#define CHECK_RENDER(x) do { esp_err_t __; if ((__ = (x)) != ESP_OK) return __; } while (0)
+
+#define WIDTH  8
+#define HEIGHT 70 // three words of dirty mask, last one partial
+
+static int renders;
+static esp_err_t render_res;
+static uint8_t rendered[HEIGHT]; // rows passed to render by spans
+
+static esp_err_t render(framebuffer_t *fb, void *arg)
+{
+    (void)arg;
+    renders++;
+    memset(rendered, 0, sizeof(rendered));
+    for (size_t y = 0, n; (n = fb_dirty_span(fb, &y)) > 0; y += n)
+        memset(rendered + y, 1, n);
+    return render_res;
+}
+
+static int render_rows(framebuffer_t *fb, const uint8_t *expected)
+{
+    int before = renders;
+    TEST_ESP_OK(fb_render(fb, NULL));
+    TEST_ASSERT(renders == before + 1);
+    TEST_ASSERT(!memcmp(rendered, expected, HEIGHT));
+    return 0;
+}
+
+static int test_skip_unchanged_frames(void)
+{
+    framebuffer_t fb;
+    uint8_t all[HEIGHT];
+    memset(all, 1, sizeof(all));
+
+    TEST_ESP_OK(fb_init(&fb, WIDTH, HEIGHT, render));
+    fb.track_dirty = true;
+    renders = 0;
+    render_res = ESP_OK;
+
+    // new framebuffer is dirty
+    if (render_rows(&fb, all))
+        return 1;
+    TEST_ESP_OK(fb_render(&fb, NULL));
+    TEST_ASSERT(renders == 1);
+
+    // failed render keeps rows dirty
+    TEST_ESP_OK(fb_set_pixel_rgb(&fb, 0, 5, (rgb_t){ .r = 1 }));
+    render_res = ESP_FAIL;
+    TEST_ASSERT(fb_render(&fb, NULL) == ESP_FAIL);
+    render_res = ESP_OK;
+    uint8_t row5[HEIGHT] = { [5] = 1 };
+    if (render_rows(&fb, row5))
+        return 1;
+
+    // without tracking every frame is rendered completely
+    fb.track_dirty = false;
+    if (render_rows(&fb, all) || render_rows(&fb, all))
+        return 1;
+
+    TEST_ESP_OK(fb_free(&fb));
+    return 0;
+}
+
+static int test_functions_mark_rows(void)
+{
+    framebuffer_t fb;
+    uint8_t expected[HEIGHT] = { 0 };
+    uint8_t all[HEIGHT];
+    memset(all, 1, sizeof(all));
+
+    TEST_ESP_OK(fb_init(&fb, WIDTH, HEIGHT, render));
+    fb.track_dirty = true;
+    render_res = ESP_OK;
+    TEST_ESP_OK(fb_render(&fb, NULL));
+
+    // spans across word boundaries
+    size_t rows[] = { 0, 30, 31, 32, 33, 63, 64, HEIGHT - 1 };
+    for (size_t i = 0; i < sizeof(rows) / sizeof(rows[0]); i++)
+    {
+        TEST_ESP_OK(fb_set_pixel_hsv(&fb, WIDTH - 1, rows[i], (hsv_t){ .val = 255 }));
+        expected[rows[i]] = 1;
+    }
+    if (render_rows(&fb, expected))
+        return 1;
+
+    // count is clipped to the framebuffer
+    memset(expected, 0, sizeof(expected));
+    memset(expected + 60, 1, HEIGHT - 60);
+    TEST_ESP_OK(fb_mark_dirty(&fb, 60, 100));
+    if (render_rows(&fb, expected))
+        return 1;
+    TEST_ASSERT(fb_mark_dirty(&fb, HEIGHT, 1) == ESP_ERR_INVALID_ARG);
+
+    // whole frame operations
+    TEST_ESP_OK(fb_shift(&fb, 1, FB_SHIFT_LEFT));
+    if (render_rows(&fb, all))
+        return 1;
+    TEST_ESP_OK(fb_fade(&fb, 10));
+    if (render_rows(&fb, all))
+        return 1;
+    TEST_ESP_OK(fb_clear(&fb));
+    if (render_rows(&fb, all))
+        return 1;
+
+    // no-op operations do not mark rows
+    int before = renders;
+    TEST_ESP_OK(fb_fade(&fb, 0));
+    TEST_ESP_OK(fb_blur2d(&fb, 0));
+    TEST_ESP_OK(fb_shift(&fb, WIDTH, FB_SHIFT_RIGHT));
+    TEST_ESP_OK(fb_render(&fb, NULL));
+    TEST_ASSERT(renders == before);
+
+    TEST_ESP_OK(fb_free(&fb));
+    return 0;
+}
+
+static int test_dirty_span_random(void)
+{
+    framebuffer_t fb;
+    uint8_t expected[HEIGHT];
+
+    TEST_ESP_OK(fb_init(&fb, WIDTH, HEIGHT, render));
+    fb.track_dirty = true;
+    render_res = ESP_OK;
+    srand(1);
+
+    for (int round = 0; round < 1000; round++)
+    {
+        TEST_ESP_OK(fb_render(&fb, NULL));
+        // sparse and dense masks
+        int density = 1 + round % 8;
+        memset(expected, 0, sizeof(expected));
+        for (size_t y = 0; y < HEIGHT; y++)
+            if (rand() % 8 < density - 1)
+            {
+                TEST_ESP_OK(fb_mark_dirty(&fb, y, 1));
+                expected[y] = 1;
+            }
+
+        // spans are maximal and do not overlap
+        size_t prev_end = 0;
+        bool first = true;
+        for (size_t y = 0, n; (n = fb_dirty_span(&fb, &y)) > 0; y += n)
+        {
+            TEST_ASSERT(y >= prev_end && (first || y > prev_end));
+            for (size_t i = prev_end; i < y; i++)
+                TEST_ASSERT(!expected[i]);
+            for (size_t i = y; i < y + n; i++)
+                TEST_ASSERT(expected[i]);
+            TEST_ASSERT(y + n == HEIGHT || !expected[y + n]);
+            prev_end = y + n;
+            first = false;
+        }
+        for (size_t i = prev_end; i < HEIGHT; i++)
+            TEST_ASSERT(!expected[i]);
+    }
+
+    TEST_ESP_OK(fb_free(&fb));
+    return 0;
+}
+
+static const rgb_t palette[4] = {
+    { .r = 255, .g = 0, .b = 0 },
+    { .r = 0, .g = 255, .b = 0 },
+    { .r = 0, .g = 0, .b = 255 },
+    { .r = 255, .g = 255, .b = 255 },
+};
+
+static int test_palette_mode(void)
+{
+    framebuffer_t fb;
+    rgb_t c;
+    uint8_t idx;
+
+    TEST_ESP_OK(fb_init_palette(&fb, WIDTH, HEIGHT, render));
+    TEST_ASSERT(!fb.data && fb.index && FB_SIZE(&fb) == WIDTH * HEIGHT);
+
+    // black until palette is set
+    TEST_ESP_OK(fb_set_pixel_index(&fb, 1, 2, 100));
+    TEST_ESP_OK(fb_get_pixel_rgb(&fb, 1, 2, &c));
+    TEST_ASSERT(!c.r && !c.g && !c.b);
+
+    for (int blend = 0; blend < 2; blend++)
+    {
+        TEST_ESP_OK(fb_set_palette(&fb, palette, 4, 200, blend));
+        for (int i = 0; i < 256; i++)
+        {
+            rgb_t ref = color_from_palette_rgb(palette, 4, i, 200, blend);
+            TEST_ASSERT(!memcmp(&fb.colors[i], &ref, sizeof(rgb_t)));
+        }
+        TEST_ESP_OK(fb_get_pixel_rgb(&fb, 1, 2, &c));
+        TEST_ASSERT(!memcmp(&c, &fb.colors[100], sizeof(rgb_t)));
+    }
+
+    // one byte per pixel in shifts
+    TEST_ESP_OK(fb_shift(&fb, 1, FB_SHIFT_RIGHT));
+    TEST_ESP_OK(fb_get_pixel_index(&fb, 2, 2, &idx));
+    TEST_ASSERT(idx == 100);
+    TEST_ESP_OK(fb_get_pixel_index(&fb, 1, 2, &idx));
+    TEST_ASSERT(!idx);
+    TEST_ESP_OK(fb_clear(&fb));
+    TEST_ESP_OK(fb_get_pixel_index(&fb, 2, 2, &idx));
+    TEST_ASSERT(!idx);
+
+    // RGB only functions and the other way round
+    TEST_ASSERT(fb_set_pixel_rgb(&fb, 0, 0, palette[0]) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(fb_fade(&fb, 10) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(fb_blur2d(&fb, 10) == ESP_ERR_INVALID_ARG);
+    TEST_ESP_OK(fb_free(&fb));
+
+    TEST_ESP_OK(fb_init(&fb, WIDTH, HEIGHT, render));
+    TEST_ASSERT(fb_set_pixel_index(&fb, 0, 0, 1) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(fb_set_palette(&fb, palette, 4, 255, false) == ESP_ERR_INVALID_ARG);
+    TEST_ESP_OK(fb_free(&fb));
+    return 0;
+}
+
+// Render callback of framebuffer documentation
+static esp_err_t render_indexed(framebuffer_t *fb, void *arg)
+{
+    for (size_t y = 0, n; (n = fb_dirty_span(fb, &y)) > 0; y += n)
+        CHECK_RENDER(led_strip_set_pixels_indexed(arg, y * fb->width, n * fb->width,
+                fb->index + FB_OFFSET(fb, 0, y), fb->colors));
+    return ESP_OK;
+}
+
+static int test_palette_render_to_strip(void)
+{
+    framebuffer_t fb;
+
+    for (int rgbw = 0; rgbw < 2; rgbw++)
+    {
+        led_strip_t strip = {
+            .type = LED_STRIP_WS2812,
+            .is_rgbw = rgbw,
+            .length = WIDTH * HEIGHT,
+            .brightness = 255,
+        };
+        TEST_ESP_OK(led_strip_init(&strip));
+        TEST_ESP_OK(fb_init_palette(&fb, WIDTH, HEIGHT, render_indexed));
+        TEST_ESP_OK(fb_set_palette(&fb, palette, 4, 255, true));
+        fb.track_dirty = true;
+
+        srand(5);
+        for (size_t y = 0; y < HEIGHT; y++)
+            for (size_t x = 0; x < WIDTH; x++)
+                TEST_ESP_OK(fb_set_pixel_index(&fb, x, y, rand()));
+        TEST_ESP_OK(fb_render(&fb, &strip));
+
+        // strip gets resolved colors, then only the changed row is written
+        uint8_t *expected = malloc(WIDTH * HEIGHT * (rgbw ? 4 : 3));
+        TEST_ASSERT(expected);
+        led_strip_t ref = strip;
+        ref.buf = expected;
+        for (size_t y = 0; y < HEIGHT; y++)
+            for (size_t x = 0; x < WIDTH; x++)
+            {
+                rgb_t c;
+                TEST_ESP_OK(fb_get_pixel_rgb(&fb, x, y, &c));
+                TEST_ESP_OK(led_strip_set_pixel(&ref, y * WIDTH + x, c));
+            }
+        TEST_ESP_OK(fb_set_pixel_index(&fb, 3, 40, 7));
+        memset(strip.buf + 40 * WIDTH * (rgbw ? 4 : 3), 0, WIDTH * (rgbw ? 4 : 3));
+        TEST_ESP_OK(fb_render(&fb, &strip));
+        rgb_t c;
+        TEST_ESP_OK(fb_get_pixel_rgb(&fb, 3, 40, &c));
+        TEST_ESP_OK(led_strip_set_pixel(&ref, 40 * WIDTH + 3, c));
+        TEST_ASSERT(!memcmp(strip.buf, expected, WIDTH * HEIGHT * (rgbw ? 4 : 3)));
+
+        free(expected);
+        TEST_ESP_OK(fb_free(&fb));
+        TEST_ESP_OK(led_strip_free(&strip));
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    RUN_TEST(test_skip_unchanged_frames);
+    RUN_TEST(test_functions_mark_rows);
+    RUN_TEST(test_dirty_span_random);
+    RUN_TEST(test_palette_mode);
+    RUN_TEST(test_palette_render_to_strip);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Per-device circuit breaker (CONFIG_I2CDEV_BREAKER_THRESHOLD)
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR 0x20
+
+static i2cdev_sim_dev_t sim;
+static i2c_dev_t dev;
+
+static int test_opens_after_timeouts(void)
+{
+    uint8_t val;
+
+    sim.timeout_count = CONFIG_I2CDEV_BREAKER_THRESHOLD;
+    for (int i = 0; i < CONFIG_I2CDEV_BREAKER_THRESHOLD; i++)
+        TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_ERR_TIMEOUT);
+    TEST_ASSERT(sim.timeout_count == 0);
+    TEST_ASSERT(dev.breaker.trips == 1);
+
+    // open breaker fails fast without touching the bus
+    uint32_t transactions = sim.transactions;
+    double started = harness_now();
+    for (int i = 0; i < 10; i++)
+        TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_ERR_INVALID_STATE);
+    TEST_ASSERT(sim.transactions == transactions);
+    TEST_ASSERT(harness_now() - started < CONFIG_I2CDEV_BREAKER_BACKOFF / 1000.0);
+    return 0;
+}
+
+static int test_backoff_doubles(void)
+{
+    uint8_t val;
+
+    // failed trial opens the breaker for twice as long
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_I2CDEV_BREAKER_BACKOFF + 20));
+    sim.timeout_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_ERR_TIMEOUT);
+    TEST_ASSERT(dev.breaker.trips == 2);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_I2CDEV_BREAKER_BACKOFF + 20));
+    TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_ERR_INVALID_STATE);
+    return 0;
+}
+
+static int test_recovers(void)
+{
+    uint8_t val = 0;
+
+    // successful trial closes the breaker
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_I2CDEV_BREAKER_BACKOFF + 20));
+    sim.regs[0x00] = 0x42;
+    TEST_ESP_OK(i2c_dev_read_reg(&dev, 0x00, &val, 1));
+    TEST_ASSERT(val == 0x42);
+    TEST_ASSERT(dev.breaker.timeouts == 0 && dev.breaker.trips == 0);
+
+    // single timeout does not open it
+    sim.timeout_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_ERR_TIMEOUT);
+    TEST_ESP_OK(i2c_dev_read_reg(&dev, 0x00, &val, 1));
+    return 0;
+}
+
+static int test_nacks_ignored(void)
+{
+    uint8_t val;
+
+    // busy devices NACK, this is not a reason to stop polling them
+    sim.nack_count = CONFIG_I2CDEV_BREAKER_THRESHOLD * 2;
+    for (int i = 0; i < CONFIG_I2CDEV_BREAKER_THRESHOLD * 2; i++)
+        TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, &val, 1) == ESP_FAIL);
+    TEST_ESP_OK(i2c_dev_read_reg(&dev, 0x00, &val, 1));
+    TEST_ASSERT(dev.breaker.trips == 0);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, ADDR));
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+
+    RUN_TEST(test_opens_after_timeouts);
+    RUN_TEST(test_backoff_doubles);
+    RUN_TEST(test_recovers);
+    RUN_TEST(test_nacks_ignored);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * i2c_master backend (CONFIG_I2CDEV_USE_MASTER_BUS): cached device handles,
+ * merging of transfer segments
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include <driver/i2c_master.h>
+#include "harness.h"
+
+#define PORT 0
+#define DEVS 3
+
+static i2cdev_sim_dev_t sims[DEVS];
+static i2c_dev_t devs[DEVS];
+
+static int read_dev(int i)
+{
+    uint8_t val = 0;
+    TEST_ESP_OK(i2c_dev_read_reg(&devs[i], 0x00, &val, 1));
+    TEST_ASSERT(val == devs[i].addr);
+    return 0;
+}
+
+static int test_handles_cached(void)
+{
+    size_t added;
+
+    TEST_ASSERT(read_dev(0) == 0);
+    TEST_ASSERT(read_dev(1) == 0);
+    TEST_ASSERT(read_dev(0) == 0);
+    TEST_ASSERT(read_dev(1) == 0);
+    TEST_ASSERT(i2c_master_shim_devices(&added) == 2);
+    TEST_ASSERT(added == 2);
+    return 0;
+}
+
+static int test_oldest_evicted(void)
+{
+    size_t added;
+
+    // all slots are taken, handle added first is released
+    TEST_ASSERT(read_dev(2) == 0);
+    TEST_ASSERT(i2c_master_shim_devices(&added) == CONFIG_I2CDEV_MAX_DEVICES_PER_PORT);
+    TEST_ASSERT(added == 3);
+    TEST_ASSERT(read_dev(1) == 0);
+    TEST_ASSERT(read_dev(2) == 0);
+    i2c_master_shim_devices(&added);
+    TEST_ASSERT(added == 3);
+
+    // then the next one
+    TEST_ASSERT(read_dev(0) == 0);
+    TEST_ASSERT(read_dev(2) == 0);
+    i2c_master_shim_devices(&added);
+    TEST_ASSERT(added == 4);
+    TEST_ASSERT(read_dev(1) == 0);
+    i2c_master_shim_devices(&added);
+    TEST_ASSERT(added == 5);
+    TEST_ASSERT(i2c_master_shim_devices(NULL) == CONFIG_I2CDEV_MAX_DEVICES_PER_PORT);
+    return 0;
+}
+
+static int test_speed_is_per_handle(void)
+{
+    size_t before, after;
+
+    // same address at another SCL speed needs its own handle
+    i2c_master_shim_devices(&before);
+    devs[1].cfg.master.clk_speed = 400000;
+    TEST_ASSERT(read_dev(1) == 0);
+    i2c_master_shim_devices(&after);
+    TEST_ASSERT(after == before + 1);
+    devs[1].cfg.master.clk_speed = 0;
+    return 0;
+}
+
+static int test_transfer_merged(void)
+{
+    i2cdev_sim_dev_t *sim = &sims[0];
+    uint8_t reg = 0x10, out[3][40], in[2][60], r1 = 0x00, r2 = 0x11, a, b[2];
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 40; j++)
+            out[i][j] = i * 40 + j + 1;
+    i2cdev_sim_reset_counters();
+
+    // runs longer than the stack buffer are merged on heap
+    i2c_dev_segment_t wr[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1),
+        I2C_DEV_SEG_WRITE(out[0], 40), I2C_DEV_SEG_WRITE(out[1], 40), I2C_DEV_SEG_WRITE(out[2], 40),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&devs[0], wr, 4));
+    TEST_ASSERT(sim->transactions == 1);
+    for (int i = 0; i < 120; i++)
+        TEST_ASSERT(sim->regs[0x10 + i] == i + 1);
+
+    i2c_dev_segment_t rd[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1), I2C_DEV_SEG_READ(in[0], 60), I2C_DEV_SEG_READ(in[1], 60),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&devs[0], rd, 3));
+    TEST_ASSERT(sim->transactions == 2);
+    for (int i = 0; i < 120; i++)
+        TEST_ASSERT(in[i / 60][i % 60] == i + 1);
+
+    // every write-read pair is a transaction
+    i2c_dev_segment_t mixed[] = {
+        I2C_DEV_SEG_WRITE(&r1, 1), I2C_DEV_SEG_READ(&a, 1),
+        I2C_DEV_SEG_WRITE(&r2, 1), I2C_DEV_SEG_READ(b, 2),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&devs[0], mixed, 4));
+    TEST_ASSERT(sim->transactions == 4);
+    TEST_ASSERT(a == devs[0].addr && b[0] == 2 && b[1] == 3);
+
+    // failed run ends the transfer
+    sim->nack_count = 1;
+    TEST_ASSERT(i2c_dev_transfer(&devs[0], mixed, 4) != ESP_OK);
+    TEST_ASSERT(sim->transactions == 5);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    for (int i = 0; i < DEVS; i++)
+    {
+        TEST_ESP_OK(i2cdev_sim_attach(&sims[i], &i2cdev_sim_regmap, PORT, 0x20 + i));
+        sims[i].regs[0] = 0x20 + i;
+        memset(&devs[i], 0, sizeof(i2c_dev_t));
+        devs[i].port = PORT;
+        devs[i].addr = 0x20 + i;
+        TEST_ESP_OK(i2c_dev_create_mutex(&devs[i]));
+    }
+
+    RUN_TEST(test_handles_cached);
+    RUN_TEST(test_oldest_evicted);
+    RUN_TEST(test_speed_is_per_handle);
+    RUN_TEST(test_transfer_merged);
+
+    for (int i = 0; i < DEVS; i++)
+        TEST_ESP_OK(i2c_dev_delete_mutex(&devs[i]));
+    TEST_ESP_OK(i2cdev_done());
+    TEST_ASSERT(i2c_master_shim_devices(NULL) == 0);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * Devices behind I2C switch (CONFIG_I2CDEV_MUX)
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define MUX_ADDR 0x70
+
+static i2cdev_sim_dev_t mux_sim, sim_a, sim_b;
+static i2c_dev_t mux, dev_a, dev_b;
+static unsigned selects;
+
+// TCA9548-like switch: single control byte
+static esp_err_t mux_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    (void)index;
+    sim->mode = val;
+    selects++;
+    return ESP_OK;
+}
+
+static uint8_t mux_read(i2cdev_sim_dev_t *sim, size_t index)
+{
+    (void)index;
+    return sim->mode;
+}
+
+static const i2cdev_sim_model_t mux_model = {
+    .name = "mux",
+    .write = mux_write,
+    .read = mux_read,
+};
+
+// Register map visible only when its channel (in mode) is selected
+static esp_err_t channel_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    (void)sim;
+    (void)read;
+    return mux_sim.mode & sim->mode ? ESP_OK : ESP_FAIL;
+}
+
+static const i2cdev_sim_model_t channel_model = {
+    .name = "channel",
+    .start = channel_start,
+    .write = i2cdev_sim_regmap_write,
+    .read = i2cdev_sim_regmap_read,
+};
+
+static int init_dev(i2c_dev_t *dev, i2cdev_sim_dev_t *sim, uint8_t addr, uint8_t channels)
+{
+    memset(dev, 0, sizeof(i2c_dev_t));
+    dev->port = PORT;
+    dev->addr = addr;
+    TEST_ESP_OK(i2c_dev_create_mutex(dev));
+    if (!sim)
+        return 0;
+    TEST_ESP_OK(i2cdev_sim_attach(sim, &channel_model, PORT, addr));
+    sim->mode = channels;
+    sim->regs[0] = addr;
+    TEST_ESP_OK(i2c_dev_set_mux(dev, &mux, channels));
+    return 0;
+}
+
+static int test_redundant_selects_skipped(void)
+{
+    uint8_t val;
+
+    selects = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+        TEST_ASSERT(val == dev_a.addr);
+    }
+    TEST_ASSERT(selects == 1);
+    TEST_ASSERT(sim_a.transactions == 3);
+
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_b, 0x00, &val, 1));
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_b, 0x00, &val, 1));
+    TEST_ASSERT(val == dev_b.addr);
+    TEST_ASSERT(selects == 2);
+
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ASSERT(selects == 3);
+    TEST_ASSERT(mux_sim.mode == 0x01);
+    return 0;
+}
+
+static int test_reselect_after_error(void)
+{
+    uint8_t val;
+
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    selects = 0;
+
+    // switch was reset by the same glitch which made the device time out
+    sim_a.timeout_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev_a, 0x00, &val, 1) == ESP_ERR_TIMEOUT);
+    mux_sim.mode = 0;
+    TEST_ASSERT(selects == 0);
+
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ASSERT(val == dev_a.addr);
+    TEST_ASSERT(selects == 1);
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ASSERT(selects == 1);
+
+    // failed channel write is retried with the next transaction
+    mux_sim.nack_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev_b, 0x00, &val, 1) != ESP_OK);
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_b, 0x00, &val, 1));
+    TEST_ASSERT(val == dev_b.addr);
+    TEST_ASSERT(selects == 2);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&mux_sim, &mux_model, PORT, MUX_ADDR));
+    TEST_ASSERT(init_dev(&mux, NULL, MUX_ADDR, 0) == 0);
+    TEST_ASSERT(init_dev(&dev_a, &sim_a, 0x40, 0x01) == 0);
+    TEST_ASSERT(init_dev(&dev_b, &sim_b, 0x41, 0x02) == 0);
+
+    RUN_TEST(test_redundant_selects_skipped);
+    RUN_TEST(test_reselect_after_error);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev_b));
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev_a));
+    TEST_ESP_OK(i2c_dev_delete_mutex(&mux));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Port ownership (CONFIG_I2CDEV_PORT_OWNER)
+ */
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR 0x20
+#define GATE_ADDR 0x21
+
+static i2cdev_sim_dev_t sim;
+static i2c_dev_t dev;
+
+// Device holding the bus until the gate is opened
+static pthread_mutex_t gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static bool gate_entered, gate_open;
+
+static esp_err_t gate_write(i2cdev_sim_dev_t *s, uint8_t val, size_t index)
+{
+    pthread_mutex_lock(&gate_lock);
+    gate_entered = true;
+    pthread_cond_broadcast(&gate_cond);
+    while (!gate_open)
+        pthread_cond_wait(&gate_cond, &gate_lock);
+    pthread_mutex_unlock(&gate_lock);
+    return i2cdev_sim_regmap_write(s, val, index);
+}
+
+static const i2cdev_sim_model_t gate_model = {
+    .name = "gate",
+    .write = gate_write,
+    .read = i2cdev_sim_regmap_read,
+};
+
+static TaskHandle_t main_task;
+
+static void *unbind_thread(void *arg)
+{
+    *(esp_err_t *)arg = i2cdev_port_unbind(PORT);
+    return NULL;
+}
+
+static void *take_thread(void *arg)
+{
+    *(esp_err_t *)arg = i2c_dev_take_mutex(&dev);
+    if (*(esp_err_t *)arg == ESP_OK)
+        i2c_dev_give_mutex(&dev);
+    return NULL;
+}
+
+static void *gate_thread(void *arg)
+{
+    i2c_dev_t gate = { .port = PORT, .addr = GATE_ADDR };
+    uint8_t val = 0;
+    *(esp_err_t *)arg = i2c_dev_write_reg(&gate, 0x00, &val, 1);
+    return NULL;
+}
+
+static void *bind_thread(void *arg)
+{
+    *(esp_err_t *)arg = i2cdev_port_bind(PORT, main_task);
+    return NULL;
+}
+
+static void *write_thread(void *arg)
+{
+    uint8_t val = 0x55;
+    *(esp_err_t *)arg = i2c_dev_write_reg(&dev, 0x02, &val, 1);
+    return NULL;
+}
+
+static int test_unbind_by_owner_only(void)
+{
+    pthread_t thread;
+    esp_err_t res = ESP_OK;
+
+    TEST_ASSERT(i2cdev_port_unbind(PORT) == ESP_ERR_INVALID_STATE);
+    TEST_ESP_OK(i2cdev_port_bind(PORT, NULL));
+
+    pthread_create(&thread, NULL, unbind_thread, &res);
+    pthread_join(thread, NULL);
+    TEST_ASSERT(res == ESP_ERR_INVALID_STATE);
+
+    TEST_ESP_OK(i2cdev_port_unbind(PORT));
+    return 0;
+}
+
+static int test_bound_port_transfers(void)
+{
+    uint8_t val = 0x42;
+
+    TEST_ESP_OK(i2cdev_port_bind(PORT, NULL));
+    TEST_ESP_OK(i2c_dev_take_mutex(&dev));
+    TEST_ESP_OK(i2c_dev_write_reg(&dev, 0x01, &val, 1));
+    val = 0;
+    TEST_ESP_OK(i2c_dev_read_reg(&dev, 0x01, &val, 1));
+    TEST_ESP_OK(i2c_dev_give_mutex(&dev));
+    TEST_ASSERT(val == 0x42);
+    TEST_ESP_OK(i2cdev_port_unbind(PORT));
+    return 0;
+}
+
+static int test_mutex_held_across_unbind(void)
+{
+    pthread_t thread;
+    esp_err_t res = ESP_FAIL;
+
+    // mutex taken before binding must still be released after it
+    TEST_ESP_OK(i2c_dev_take_mutex(&dev));
+    TEST_ESP_OK(i2cdev_port_bind(PORT, NULL));
+    TEST_ESP_OK(i2cdev_port_unbind(PORT));
+    TEST_ESP_OK(i2c_dev_give_mutex(&dev));
+
+    pthread_create(&thread, NULL, take_thread, &res);
+    pthread_join(thread, NULL);
+    TEST_ESP_OK(res);
+    return 0;
+}
+
+static int test_bind_while_waiting(void)
+{
+    i2cdev_sim_dev_t gate_sim;
+    pthread_t gate, bind, writer;
+    esp_err_t gate_res = ESP_FAIL, bind_res = ESP_FAIL, write_res = ESP_OK;
+
+    TEST_ESP_OK(i2cdev_sim_attach(&gate_sim, &gate_model, PORT, GATE_ADDR));
+    gate_entered = gate_open = false;
+    i2cdev_sim_reset_counters();
+
+    // bus is busy, binder and then writer wait for the port mutex
+    pthread_create(&gate, NULL, gate_thread, &gate_res);
+    pthread_mutex_lock(&gate_lock);
+    while (!gate_entered)
+        pthread_cond_wait(&gate_cond, &gate_lock);
+    pthread_mutex_unlock(&gate_lock);
+    pthread_create(&bind, NULL, bind_thread, &bind_res);
+    usleep(50000);
+    pthread_create(&writer, NULL, write_thread, &write_res);
+    usleep(50000);
+
+    pthread_mutex_lock(&gate_lock);
+    gate_open = true;
+    pthread_cond_broadcast(&gate_cond);
+    pthread_mutex_unlock(&gate_lock);
+    pthread_join(gate, NULL);
+    pthread_join(bind, NULL);
+    pthread_join(writer, NULL);
+
+    TEST_ESP_OK(gate_res);
+    TEST_ESP_OK(bind_res);
+    // writer queued before binding must not reach the bus
+    TEST_ASSERT(write_res == ESP_ERR_INVALID_STATE);
+    TEST_ASSERT(sim.transactions == 0);
+    TEST_ASSERT(sim.regs[0x02] != 0x55);
+
+    TEST_ESP_OK(i2cdev_port_unbind(PORT));
+    TEST_ESP_OK(i2cdev_sim_detach(&gate_sim));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, ADDR));
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+    main_task = xTaskGetCurrentTaskHandle();
+
+    RUN_TEST(test_unbind_by_owner_only);
+    RUN_TEST(test_bound_port_transfers);
+    RUN_TEST(test_mutex_held_across_unbind);
+    RUN_TEST(test_bind_while_waiting);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Port scheduler (CONFIG_I2CDEV_SCHEDULER): request ordering by priority
+ * and deadline
+ */
+#include <pthread.h>
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR 0x20
+#define GATE_ADDR 0x21
+#define REQUESTS 6
+
+static i2cdev_sim_dev_t sim, gate_sim;
+static i2c_dev_t dev, gate;
+
+// Device holding the scheduler until the gate is opened
+static pthread_mutex_t gate_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+static bool gate_entered, gate_open;
+
+static esp_err_t gate_write(i2cdev_sim_dev_t *s, uint8_t val, size_t index)
+{
+    pthread_mutex_lock(&gate_lock);
+    gate_entered = true;
+    pthread_cond_broadcast(&gate_cond);
+    while (!gate_open)
+        pthread_cond_wait(&gate_cond, &gate_lock);
+    pthread_mutex_unlock(&gate_lock);
+    return i2cdev_sim_regmap_write(s, val, index);
+}
+
+static const i2cdev_sim_model_t gate_model = {
+    .name = "gate",
+    .write = gate_write,
+    .read = i2cdev_sim_regmap_read,
+};
+
+// Completion order, written by the scheduler task
+static int done[REQUESTS];
+static esp_err_t results[REQUESTS];
+static size_t done_count;
+
+static void on_done(const i2c_dev_t *d, esp_err_t result, void *arg)
+{
+    (void)d;
+    int id = (int)(intptr_t)arg;
+    results[id] = result;
+    done[done_count++] = id;
+}
+
+static int test_order(void)
+{
+    uint8_t gate_data[] = { 0x00, 0x01 };
+    uint8_t data[REQUESTS][2];
+    i2c_dev_segment_t gate_seg = I2C_DEV_SEG_WRITE(gate_data, sizeof(gate_data));
+    i2c_dev_segment_t segs[REQUESTS];
+
+    i2c_dev_request_t req = { .dev = &gate, .segs = &gate_seg, .count = 1 };
+    TEST_ESP_OK(i2c_dev_submit(&req, 0));
+    pthread_mutex_lock(&gate_lock);
+    while (!gate_entered)
+        pthread_cond_wait(&gate_cond, &gate_lock);
+    pthread_mutex_unlock(&gate_lock);
+
+    // queued while the scheduler is busy
+    TickType_t now = xTaskGetTickCount();
+    const struct
+    {
+        uint8_t priority;
+        TickType_t deadline;
+    } params[REQUESTS] = {
+        { 0, 0 },          // 0: low, no deadline
+        { 0, now + 2000 }, // 1: late deadline
+        { 0, 0 },          // 2: low, submitted after 0
+        { 1, 0 },          // 3: high priority
+        { 0, now + 1000 }, // 4: early deadline
+        { 0, now + 1 },    // 5: expires while waiting
+    };
+    for (int i = 0; i < REQUESTS; i++)
+    {
+        // each request writes its number to its own register
+        data[i][0] = 0x10 + i;
+        data[i][1] = i + 1;
+        segs[i] = (i2c_dev_segment_t)I2C_DEV_SEG_WRITE(data[i], 2);
+        req = (i2c_dev_request_t) {
+            .dev = &dev, .segs = &segs[i], .count = 1,
+            .priority = params[i].priority, .deadline = params[i].deadline,
+            .cb = on_done, .arg = (void *)(intptr_t)i,
+        };
+        TEST_ESP_OK(i2c_dev_submit(&req, 0));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    pthread_mutex_lock(&gate_lock);
+    gate_open = true;
+    pthread_cond_broadcast(&gate_cond);
+    pthread_mutex_unlock(&gate_lock);
+
+    // stop waits for queued requests
+    TEST_ESP_OK(i2cdev_scheduler_stop(PORT));
+    TEST_ASSERT(gate_sim.regs[0x00] == 0x01);
+
+    static const int expected[REQUESTS] = { 3, 5, 4, 1, 0, 2 };
+    TEST_ASSERT(done_count == REQUESTS);
+    for (int i = 0; i < REQUESTS; i++)
+        TEST_ASSERT(done[i] == expected[i]);
+
+    // expired request is completed without touching the device
+    TEST_ASSERT(results[5] == ESP_ERR_TIMEOUT);
+    TEST_ASSERT(sim.regs[0x15] == 0);
+    TEST_ASSERT(sim.transactions == REQUESTS - 1);
+    for (int i = 0; i < REQUESTS - 1; i++)
+    {
+        TEST_ESP_OK(results[i]);
+        TEST_ASSERT(sim.regs[0x10 + i] == i + 1);
+    }
+    return 0;
+}
+
+static int test_notify(void)
+{
+    uint8_t reg = 0x10, val = 0;
+    esp_err_t result = ESP_FAIL;
+    i2c_dev_segment_t segs[] = { I2C_DEV_SEG_WRITE(&reg, 1), I2C_DEV_SEG_READ(&val, 1) };
+
+    // without callback the submitting task is notified
+    TEST_ESP_OK(i2cdev_scheduler_start(PORT, 5));
+    i2c_dev_request_t req = {
+        .dev = &dev, .segs = segs, .count = 2,
+        .notify = xTaskGetCurrentTaskHandle(), .result = &result,
+    };
+    TEST_ESP_OK(i2c_dev_submit(&req, 0));
+    TEST_ASSERT(ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)) == 1);
+    TEST_ESP_OK(result);
+    TEST_ASSERT(val == 1);
+
+    TEST_ESP_OK(i2cdev_scheduler_stop(PORT));
+    TEST_ASSERT(i2cdev_scheduler_stop(PORT) == ESP_ERR_INVALID_STATE);
+    TEST_ASSERT(i2c_dev_submit(&req, 0) == ESP_ERR_INVALID_STATE);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, ADDR));
+    TEST_ESP_OK(i2cdev_sim_attach(&gate_sim, &gate_model, PORT, GATE_ADDR));
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+    memset(&gate, 0, sizeof(gate));
+    gate.port = PORT;
+    gate.addr = GATE_ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&gate));
+    TEST_ESP_OK(i2cdev_scheduler_start(PORT, 5));
+
+    RUN_TEST(test_order);
+    RUN_TEST(test_notify);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&gate));
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Register shadow cache (CONFIG_I2CDEV_SHADOW_SIZE)
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR 0x20
+
+static const uint8_t regs[] = { 0x10, 0x11, 0x12 };
+
+static i2cdev_sim_dev_t sim;
+static i2c_dev_t dev;
+
+static int setup(void)
+{
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, ADDR));
+    sim.regs[0x10] = 0xa0;
+    sim.regs[0x11] = 0xa1;
+    sim.regs[0x12] = 0xa2;
+    TEST_ESP_OK(i2c_dev_shadow_init(&dev, regs, sizeof(regs)));
+    return 0;
+}
+
+static int test_hit_and_miss(void)
+{
+    uint8_t buf[3] = { 0 };
+
+    TEST_ASSERT(setup() == 0);
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 2));
+    TEST_ASSERT(sim.transactions == 1);
+    TEST_ASSERT(buf[0] == 0xa0 && buf[1] == 0xa1);
+
+    // cached registers are not read again
+    sim.regs[0x10] = 0;
+    memset(buf, 0, sizeof(buf));
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 2));
+    TEST_ASSERT(sim.transactions == 1);
+    TEST_ASSERT(buf[0] == 0xa0 && buf[1] == 0xa1);
+
+    // partially cached range is read from the bus
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x11, buf, 2));
+    TEST_ASSERT(sim.transactions == 2);
+    TEST_ASSERT(buf[0] == 0xa1 && buf[1] == 0xa2);
+
+    // range with uncacheable register always goes to the bus
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x12, buf, 2));
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x12, buf, 2));
+    TEST_ASSERT(sim.transactions == 4);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_cached_write(void)
+{
+    uint8_t val = 0x5a;
+
+    TEST_ASSERT(setup() == 0);
+    TEST_ESP_OK(i2c_dev_write_reg_cached(&dev, 0x11, &val, 1));
+    TEST_ASSERT(sim.regs[0x11] == 0x5a);
+    val = 0;
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x11, &val, 1));
+    TEST_ASSERT(val == 0x5a);
+    TEST_ASSERT(sim.transactions == 1);
+
+    // read-modify-write reads the register once
+    TEST_ESP_OK(i2c_dev_update_reg(&dev, 0x12, 0x0f, 0x05));
+    TEST_ESP_OK(i2c_dev_update_reg(&dev, 0x12, 0xf0, 0x30));
+    TEST_ASSERT(sim.regs[0x12] == 0x35);
+    TEST_ASSERT(sim.transactions == 4);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_plain_write_drops(void)
+{
+    uint8_t buf[3], val = 0x77;
+
+    TEST_ASSERT(setup() == 0);
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 3));
+    TEST_ESP_OK(i2c_dev_write_reg(&dev, 0x11, &val, 1));
+    TEST_ASSERT(sim.transactions == 2);
+
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 1));
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x12, buf, 1));
+    TEST_ASSERT(sim.transactions == 2);
+
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x11, buf, 1));
+    TEST_ASSERT(sim.transactions == 3);
+    TEST_ASSERT(buf[0] == 0x77);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_error_invalidates(void)
+{
+    uint8_t buf[3];
+
+    TEST_ASSERT(setup() == 0);
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 3));
+
+    // failed access to any register may mean device reset
+    sim.nack_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev, 0x00, buf, 1) != ESP_OK);
+    sim.regs[0x10] = 0x01;
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 3));
+    TEST_ASSERT(buf[0] == 0x01);
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 3));
+    TEST_ASSERT(sim.transactions == 3);
+
+    i2c_dev_shadow_invalidate(&dev);
+    TEST_ESP_OK(i2c_dev_read_reg_cached(&dev, 0x10, buf, 3));
+    TEST_ASSERT(sim.transactions == 4);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = ADDR;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+
+    RUN_TEST(test_hit_and_miss);
+    RUN_TEST(test_cached_write);
+    RUN_TEST(test_plain_write_drops);
+    RUN_TEST(test_error_invalidates);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
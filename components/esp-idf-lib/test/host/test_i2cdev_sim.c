@@ -0,0 +1,556 @@
+/*
+ * Drivers against the device models of the i2cdev simulator
+ */
+#include <math.h>
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include <sht3x.h>
+#include <bmp280.h>
+#include <scd4x.h>
+#include <bme680.h>
+#include <mpu6050.h>
+#include <mpu6050_regs.h>
+#include "harness.h"
+
+#define PORT 0
+
+// Register map logging bus events: Sw/Sr - address phase, hex - written
+// byte, r - read byte, P - STOP or repeated START
+static char bus_log[4096];
+static size_t log_len;
+static int nack_byte = -1;   // NACK written byte with this index
+static bool nack_read;       // NACK address of read phases
+static size_t max_index;
+
+static void log_event(const char *fmt, unsigned val)
+{
+    log_len += snprintf(bus_log + log_len, sizeof(bus_log) - log_len, fmt, val);
+    if (log_len >= sizeof(bus_log))
+        log_len = sizeof(bus_log) - 1;
+}
+
+static esp_err_t rec_start(i2cdev_sim_dev_t *sim, bool read)
+{
+    (void)sim;
+    if (read && nack_read)
+        return ESP_FAIL;
+    log_event(read ? "Sr " : "Sw ", 0);
+    return ESP_OK;
+}
+
+static esp_err_t rec_write(i2cdev_sim_dev_t *sim, uint8_t val, size_t index)
+{
+    if ((int)index == nack_byte)
+        return ESP_FAIL;
+    if (index > max_index)
+        max_index = index;
+    log_event("%02x ", val);
+    return i2cdev_sim_regmap_write(sim, val, index);
+}
+
+static uint8_t rec_read(i2cdev_sim_dev_t *sim, size_t index)
+{
+    if (index > max_index)
+        max_index = index;
+    log_event("r ", 0);
+    return i2cdev_sim_regmap_read(sim, index);
+}
+
+static void rec_stop(i2cdev_sim_dev_t *sim, bool read, size_t bytes)
+{
+    (void)sim;
+    (void)read;
+    (void)bytes;
+    log_event("P ", 0);
+}
+
+static const i2cdev_sim_model_t rec_model = {
+    .name = "recorder",
+    .start = rec_start,
+    .write = rec_write,
+    .read = rec_read,
+    .stop = rec_stop,
+};
+
+// Register map with MPU6050-like FIFO: data register does not increment
+// the pointer, count registers reflect FIFO contents
+static uint8_t fifo[1024];
+static size_t fifo_head, fifo_len;
+
+static void fifo_push(const void *data, size_t size)
+{
+    for (size_t i = 0; i < size && fifo_len < sizeof(fifo); i++, fifo_len++)
+        fifo[(fifo_head + fifo_len) % sizeof(fifo)] = ((const uint8_t *)data)[i];
+}
+
+static uint8_t fifo_read(i2cdev_sim_dev_t *sim, size_t index)
+{
+    uint8_t val;
+    switch (sim->reg)
+    {
+        case MPU6050_REGISTER_FIFO_R_W:
+            if (!fifo_len)
+                return 0xff;
+            val = fifo[fifo_head];
+            fifo_head = (fifo_head + 1) % sizeof(fifo);
+            fifo_len--;
+            return val;
+        case MPU6050_REGISTER_FIFO_COUNTH:
+            sim->reg++;
+            return fifo_len >> 8;
+        case MPU6050_REGISTER_FIFO_COUNTL:
+            sim->reg++;
+            return fifo_len & 0xff;
+        default:
+            return i2cdev_sim_regmap_read(sim, index);
+    }
+}
+
+static const i2cdev_sim_model_t fifo_model = {
+    .name = "fifo",
+    .write = i2cdev_sim_regmap_write,
+    .read = fifo_read,
+};
+
+static void log_reset(void)
+{
+    bus_log[0] = 0;
+    log_len = 0;
+    nack_byte = -1;
+    nack_read = false;
+    max_index = 0;
+}
+
+static int test_sht3x_measure(void)
+{
+    static i2cdev_sim_dev_t sim;
+    sht3x_t dev;
+    float t, h;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_sht3x, PORT, SHT3X_I2C_ADDR_GND));
+    sim.temperature = 21.5f;
+    sim.humidity = 40.0f;
+
+    TEST_ESP_OK(sht3x_init_desc(&dev, SHT3X_I2C_ADDR_GND, PORT, 0, 0));
+    TEST_ESP_OK(sht3x_init(&dev));
+    TEST_ESP_OK(sht3x_measure(&dev, &t, &h));
+    TEST_ASSERT(fabsf(t - 21.5f) < 0.05f);
+    TEST_ASSERT(fabsf(h - 40.0f) < 0.05f);
+    TEST_ASSERT(sim.transactions > 0);
+
+    TEST_ESP_OK(sht3x_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_sht3x_fault_injection(void)
+{
+    static i2cdev_sim_dev_t sim;
+    sht3x_t dev;
+    float t, h;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_sht3x, PORT, SHT3X_I2C_ADDR_GND));
+    TEST_ESP_OK(sht3x_init_desc(&dev, SHT3X_I2C_ADDR_GND, PORT, 0, 0));
+    TEST_ESP_OK(sht3x_init(&dev));
+
+    sim.nack_count = 1;
+    TEST_ASSERT(sht3x_measure(&dev, &t, &h) != ESP_OK);
+    TEST_ASSERT(sim.nack_count == 0);
+    TEST_ESP_OK(sht3x_measure(&dev, &t, &h));
+
+    sim.timeout_count = 1;
+    TEST_ASSERT(sht3x_measure(&dev, &t, &h) == ESP_ERR_TIMEOUT);
+    TEST_ESP_OK(sht3x_measure(&dev, &t, &h));
+
+    TEST_ESP_OK(sht3x_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_bmp280_datasheet_example(void)
+{
+    static i2cdev_sim_dev_t sim;
+    bmp280_t dev;
+    bmp280_params_t params;
+    float t, p, h;
+    bool busy;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_bmp280, PORT, BMP280_I2C_ADDRESS_0));
+    TEST_ESP_OK(bmp280_init_desc(&dev, BMP280_I2C_ADDRESS_0, PORT, 0, 0));
+    TEST_ESP_OK(bmp280_init_default_params(&params));
+    params.mode = BMP280_MODE_FORCED;
+    TEST_ESP_OK(bmp280_init(&dev, &params));
+    TEST_ASSERT(dev.id == BMP280_CHIP_ID);
+
+    TEST_ESP_OK(bmp280_force_measurement(&dev));
+    do
+    {
+        TEST_ESP_OK(bmp280_is_measuring(&dev, &busy));
+    } while (busy);
+    TEST_ESP_OK(bmp280_read_float(&dev, &t, &p, &h));
+    TEST_ASSERT(fabsf(t - 25.08f) < 0.01f);
+    TEST_ASSERT(fabsf(p - 100653.27f) < 1.0f);
+
+    TEST_ESP_OK(bmp280_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_scd4x_periodic(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev;
+    uint16_t serial[3], co2;
+    float t, h;
+    bool ready;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_scd4x, PORT, SCD4X_I2C_ADDR));
+    sim.co2 = 800;
+    sim.temperature = 23.0f;
+    sim.humidity = 45.0f;
+
+    TEST_ESP_OK(scd4x_init_desc(&dev, PORT, 0, 0));
+    TEST_ESP_OK(scd4x_get_serial_number(&dev, &serial[0], &serial[1], &serial[2]));
+    TEST_ASSERT(serial[0] == 0xf896 && serial[1] == 0x9f07 && serial[2] == 0x3bb3);
+
+    TEST_ESP_OK(scd4x_start_periodic_measurement(&dev));
+    TEST_ESP_OK(scd4x_get_data_ready_status(&dev, &ready));
+    TEST_ASSERT(!ready);
+
+    // skip 5 s measurement interval
+    sim.busy_until_us = 0;
+    TEST_ESP_OK(scd4x_get_data_ready_status(&dev, &ready));
+    TEST_ASSERT(ready);
+    TEST_ESP_OK(scd4x_read_measurement(&dev, &co2, &t, &h));
+    TEST_ASSERT(co2 == 800);
+    TEST_ASSERT(fabsf(t - 23.0f) < 0.05f);
+    TEST_ASSERT(fabsf(h - 45.0f) < 0.05f);
+    TEST_ESP_OK(scd4x_stop_periodic_measurement(&dev));
+
+    TEST_ESP_OK(scd4x_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_bme680_forced(void)
+{
+    static i2cdev_sim_dev_t sim;
+    bme680_t dev;
+    bme680_values_float_t values;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_bme680, PORT, BME680_I2C_ADDR_1));
+    TEST_ESP_OK(bme680_init_desc(&dev, BME680_I2C_ADDR_1, PORT, 0, 0));
+    TEST_ESP_OK(bme680_init_sensor(&dev));
+    TEST_ESP_OK(bme680_measure_float(&dev, &values));
+    TEST_ASSERT(values.temperature > -40 && values.temperature < 85);
+    TEST_ASSERT(values.pressure > 300 && values.pressure < 1100);
+    TEST_ASSERT(values.humidity >= 0 && values.humidity <= 100);
+
+    TEST_ESP_OK(bme680_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_latency_accounting(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev;
+    uint8_t val = 0x5a;
+
+    memset(&dev, 0, sizeof(dev));
+    dev.port = PORT;
+    dev.addr = 0x20;
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &i2cdev_sim_regmap, PORT, 0x20));
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev));
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, 20, false));
+
+    // address + register + value at 100 kHz, 9 bit times per byte
+    TEST_ESP_OK(i2c_dev_write_reg(&dev, 0x10, &val, 1));
+    TEST_ASSERT(sim.regs[0x10] == 0x5a);
+    TEST_ASSERT(sim.transactions == 1);
+    TEST_ASSERT(sim.bytes == 2);
+    TEST_ASSERT(sim.bus_time_us == 20 + 3 * 90);
+
+    // unknown address is NACKed
+    dev.addr = 0x21;
+    TEST_ASSERT(i2c_dev_probe(&dev, I2C_DEV_WRITE) != ESP_OK);
+    dev.addr = 0x20;
+
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, 0, false));
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_transfer_mixed(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev = { .port = PORT, .addr = 0x20 };
+    uint8_t r1 = 0x10, r2 = 0x20, cfg[] = { 0x20, 0xc1, 0xc2 };
+    uint8_t a[2], b[3];
+
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &rec_model, PORT, 0x20));
+    for (int i = 0; i < 3; i++)
+    {
+        sim.regs[0x10 + i] = 0xa0 + i;
+        sim.regs[0x20 + i] = 0xb0 + i;
+    }
+    log_reset();
+
+    i2c_dev_segment_t segs[] = {
+        I2C_DEV_SEG_WRITE(&r1, 1), I2C_DEV_SEG_READ(a, 2),
+        I2C_DEV_SEG_WRITE(&r2, 1), I2C_DEV_SEG_READ(b, 3),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&dev, segs, 4));
+    TEST_ASSERT(!strcmp(bus_log, "Sw 10 P Sr r r P Sw 20 P Sr r r r P "));
+    TEST_ASSERT(a[0] == 0xa0 && a[1] == 0xa1);
+    TEST_ASSERT(b[0] == 0xb0 && b[1] == 0xb1 && b[2] == 0xb2);
+    TEST_ASSERT(sim.transactions == 1);
+    TEST_ASSERT(sim.bytes == 7);
+
+    // same direction is merged, stop flag splits it
+    log_reset();
+    i2c_dev_segment_t wr[] = {
+        I2C_DEV_SEG_WRITE(&cfg[0], 1), I2C_DEV_SEG_WRITE(&cfg[1], 1),
+        I2C_DEV_SEG_WRITE(&r1, 1), I2C_DEV_SEG_READ(a, 1),
+    };
+    wr[1].stop = true;
+    TEST_ESP_OK(i2c_dev_transfer(&dev, wr, 4));
+    TEST_ASSERT(!strcmp(bus_log, "Sw 20 c1 P Sw 10 P Sr r P "));
+    TEST_ASSERT(sim.regs[0x20] == 0xc1);
+    TEST_ASSERT(a[0] == 0xa0);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_transfer_nack(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev = { .port = PORT, .addr = 0x20 };
+    uint8_t reg = 0x10, data[] = { 1, 2, 3 }, buf[2] = { 0 };
+
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &rec_model, PORT, 0x20));
+    i2c_dev_segment_t segs[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1), I2C_DEV_SEG_WRITE(data, 3), I2C_DEV_SEG_READ(buf, 2),
+    };
+
+    // data byte NACK ends the transfer, read phase is not started
+    log_reset();
+    nack_byte = 2;
+    TEST_ASSERT(i2c_dev_transfer(&dev, segs, 3) == ESP_FAIL);
+    TEST_ASSERT(!strcmp(bus_log, "Sw 10 01 P "));
+    TEST_ASSERT(sim.regs[0x10] == 1 && sim.regs[0x11] == 0);
+
+    // NACK of repeated START
+    log_reset();
+    nack_read = true;
+    TEST_ASSERT(i2c_dev_transfer(&dev, segs, 3) == ESP_FAIL);
+    TEST_ASSERT(!strcmp(bus_log, "Sw 10 01 02 03 P "));
+
+    // bus is usable again
+    log_reset();
+    TEST_ESP_OK(i2c_dev_transfer(&dev, segs, 3));
+    TEST_ASSERT(!strcmp(bus_log, "Sw 10 01 02 03 P Sr r r P "));
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_transfer_large(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev = { .port = PORT, .addr = 0x20 };
+    uint8_t reg = 0, out[3][40], in[2][50];
+
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &rec_model, PORT, 0x20));
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 40; j++)
+            out[i][j] = i * 40 + j + 1;
+
+    // runs longer than any on-stack merge buffer
+    log_reset();
+    i2c_dev_segment_t wr[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1),
+        I2C_DEV_SEG_WRITE(out[0], 40), I2C_DEV_SEG_WRITE(out[1], 40), I2C_DEV_SEG_WRITE(out[2], 40),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&dev, wr, 4));
+    TEST_ASSERT(max_index == 120);
+    for (int i = 0; i < 120; i++)
+        TEST_ASSERT(sim.regs[i] == i + 1);
+
+    log_reset();
+    i2c_dev_segment_t rd[] = {
+        I2C_DEV_SEG_WRITE(&reg, 1), I2C_DEV_SEG_READ(in[0], 50), I2C_DEV_SEG_READ(in[1], 50),
+    };
+    TEST_ESP_OK(i2c_dev_transfer(&dev, rd, 3));
+    TEST_ASSERT(max_index == 99);
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT(in[i / 50][i % 50] == i + 1);
+    TEST_ASSERT(sim.transactions == 2);
+    TEST_ASSERT(sim.bytes == 121 + 101);
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_read_bulk(void)
+{
+    static i2cdev_sim_dev_t sim;
+    static uint8_t buf[I2CDEV_BULK_MAX_SIZE + 1];
+    i2c_dev_t dev = { .port = PORT, .addr = MPU6050_I2C_ADDRESS_LOW };
+
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &fifo_model, PORT, MPU6050_I2C_ADDRESS_LOW));
+    fifo_head = fifo_len = 0;
+    for (int i = 0; i < I2CDEV_BULK_MAX_SIZE; i++)
+        fifo_push(&(uint8_t){ i * 7 }, 1);
+
+    // limit is checked before touching the bus
+    TEST_ASSERT(i2c_dev_read_bulk(&dev, MPU6050_REGISTER_FIFO_R_W, buf, I2CDEV_BULK_MAX_SIZE + 1) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(i2c_dev_read_bulk(&dev, MPU6050_REGISTER_FIFO_R_W, buf, 0) == ESP_ERR_INVALID_ARG);
+    TEST_ASSERT(sim.transactions == 0);
+
+    // whole burst in one transaction
+    TEST_ESP_OK(i2c_dev_read_bulk(&dev, MPU6050_REGISTER_FIFO_R_W, buf, I2CDEV_BULK_MAX_SIZE));
+    TEST_ASSERT(sim.transactions == 1);
+    TEST_ASSERT(sim.bytes == 1 + I2CDEV_BULK_MAX_SIZE);
+    TEST_ASSERT(fifo_len == 0);
+    for (int i = 0; i < I2CDEV_BULK_MAX_SIZE; i++)
+        TEST_ASSERT(buf[i] == (uint8_t)(i * 7));
+
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_stream(void)
+{
+    static i2cdev_sim_dev_t sim;
+    i2c_dev_t dev = { .port = PORT, .addr = MPU6050_I2C_ADDRESS_LOW };
+    i2c_dev_stream_t stream;
+    uint8_t buf0[16], buf1[16], *data;
+    size_t size;
+
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &fifo_model, PORT, MPU6050_I2C_ADDRESS_LOW));
+    fifo_head = fifo_len = 0;
+    for (int i = 0; i < 64; i++)
+        fifo_push(&(uint8_t){ i }, 1);
+
+    TEST_ASSERT(i2c_dev_stream_init(&stream, &dev, MPU6050_REGISTER_FIFO_R_W, buf0, buf1, I2CDEV_BULK_MAX_SIZE + 1) == ESP_ERR_INVALID_ARG);
+    TEST_ESP_OK(i2c_dev_stream_init(&stream, &dev, MPU6050_REGISTER_FIFO_R_W, buf0, buf1, sizeof(buf0)));
+    TEST_ASSERT(i2c_dev_stream_next(&stream, sizeof(buf0) + 1, &data, &size) == ESP_ERR_INVALID_ARG);
+
+    // nothing was requested yet
+    TEST_ESP_OK(i2c_dev_stream_next(&stream, 8, &data, &size));
+    TEST_ASSERT(data == NULL && size == 0);
+
+    // buffers alternate, each call returns the previous request
+    TEST_ESP_OK(i2c_dev_stream_next(&stream, 16, &data, &size));
+    TEST_ASSERT(data == buf1 && size == 8);
+    for (int i = 0; i < 8; i++)
+        TEST_ASSERT(data[i] == i);
+    TEST_ESP_OK(i2c_dev_stream_next(&stream, 4, &data, &size));
+    TEST_ASSERT(data == buf0 && size == 16);
+    for (int i = 0; i < 16; i++)
+        TEST_ASSERT(data[i] == 8 + i);
+
+    // failed request returns no data, stream goes on
+    sim.nack_count = 1;
+    TEST_ASSERT(i2c_dev_stream_next(&stream, 2, &data, &size) == ESP_FAIL);
+    TEST_ASSERT(data == NULL && size == 0);
+    TEST_ESP_OK(i2c_dev_stream_next(&stream, 0, &data, &size));
+    TEST_ASSERT(data == buf0 && size == 2);
+    TEST_ASSERT(data[0] == 24 && data[1] == 25);
+    TEST_ESP_OK(i2c_dev_stream_next(&stream, 0, &data, &size));
+    TEST_ASSERT(data == NULL && size == 0);
+
+    TEST_ESP_OK(i2c_dev_stream_free(&stream));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_mpu6050_fifo(void)
+{
+    static i2cdev_sim_dev_t sim;
+    mpu6050_dev_t dev;
+    uint8_t data[4];
+    uint16_t count;
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &fifo_model, PORT, MPU6050_I2C_ADDRESS_LOW));
+    TEST_ESP_OK(mpu6050_init_desc(&dev, MPU6050_I2C_ADDRESS_LOW, PORT, 0, 0));
+    fifo_head = fifo_len = 0;
+    fifo_push((uint8_t[]){ 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 }, 6);
+
+    // FIFO bytes come from FIFO_R_W, not from the count registers
+    TEST_ESP_OK(mpu6050_get_fifo_count(&dev, &count));
+    TEST_ASSERT(count == 6);
+    TEST_ESP_OK(mpu6050_get_fifo_bytes(&dev, data, 4));
+    TEST_ASSERT(data[0] == 0x11 && data[1] == 0x22 && data[2] == 0x33 && data[3] == 0x44);
+    TEST_ESP_OK(mpu6050_get_fifo_count(&dev, &count));
+    TEST_ASSERT(count == 2);
+
+    TEST_ESP_OK(mpu6050_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+static int test_mpu6050_calibrate(void)
+{
+    static i2cdev_sim_dev_t sim;
+    mpu6050_dev_t dev;
+    float accel[3], gyro[3];
+
+    memset(&dev, 0, sizeof(dev));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim, &fifo_model, PORT, MPU6050_I2C_ADDRESS_LOW));
+    TEST_ESP_OK(mpu6050_init_desc(&dev, MPU6050_I2C_ADDRESS_LOW, PORT, 0, 0));
+
+    // 10 packets of big-endian accel X/Y/Z and gyro X/Y/Z, 1 g on Z
+    const uint8_t packet[12] = { 0x00, 0xa0, 0x00, 0x50, 0x41, 0x40, 0x01, 0x90, 0x00, 0xc8, 0x00, 0x50 };
+    fifo_head = fifo_len = 0;
+    for (int i = 0; i < 10; i++)
+        fifo_push(packet, sizeof(packet));
+
+    // whole packets are read, FIFO stays in sync
+    TEST_ESP_OK(mpu6050_calibrate(&dev, accel, gyro));
+    TEST_ASSERT(fifo_len == 0);
+    TEST_ASSERT(fabsf(accel[0] - 160 / 16384.0f) < 1e-6f);
+    TEST_ASSERT(fabsf(accel[1] - 80 / 16384.0f) < 1e-6f);
+    TEST_ASSERT(fabsf(accel[2] - 320 / 16384.0f) < 1e-6f);
+    TEST_ASSERT(fabsf(gyro[0] - 400 / 131.0f) < 1e-4f);
+    TEST_ASSERT(fabsf(gyro[1] - 200 / 131.0f) < 1e-4f);
+    TEST_ASSERT(fabsf(gyro[2] - 80 / 131.0f) < 1e-4f);
+
+    TEST_ESP_OK(mpu6050_free_desc(&dev));
+    TEST_ESP_OK(i2cdev_sim_detach(&sim));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+
+    RUN_TEST(test_sht3x_measure);
+    RUN_TEST(test_sht3x_fault_injection);
+    RUN_TEST(test_bmp280_datasheet_example);
+    RUN_TEST(test_scd4x_periodic);
+    RUN_TEST(test_bme680_forced);
+    RUN_TEST(test_latency_accounting);
+    RUN_TEST(test_transfer_mixed);
+    RUN_TEST(test_transfer_nack);
+    RUN_TEST(test_transfer_large);
+    RUN_TEST(test_read_bulk);
+    RUN_TEST(test_stream);
+    RUN_TEST(test_mpu6050_fifo);
+    RUN_TEST(test_mpu6050_calibrate);
+
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Transaction statistics (CONFIG_I2CDEV_STATS)
+ */
+#include <string.h>
+#include <i2cdev.h>
+#include <i2cdev_sim.h>
+#include "harness.h"
+
+#define PORT 0
+#define ADDR_A 0x20
+#define ADDR_B 0x21
+
+static i2cdev_sim_dev_t sim_a, sim_b;
+static i2c_dev_t dev_a, dev_b;
+
+static int test_counters(void)
+{
+    i2c_dev_stats_t stats;
+    uint8_t buf[4] = { 0 };
+
+    // register address is counted with the data
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, buf, 2));
+    TEST_ESP_OK(i2c_dev_write_reg(&dev_a, 0x10, buf, 4));
+    sim_a.nack_count = 2;
+    TEST_ASSERT(i2c_dev_read_reg(&dev_a, 0x00, buf, 1) == ESP_FAIL);
+    TEST_ASSERT(i2c_dev_read_reg(&dev_a, 0x00, buf, 1) == ESP_FAIL);
+    sim_a.timeout_count = 1;
+    TEST_ASSERT(i2c_dev_read_reg(&dev_a, 0x00, buf, 1) == ESP_ERR_TIMEOUT);
+    TEST_ESP_OK(i2c_dev_read(&dev_b, NULL, 0, buf, 3));
+
+    // probes are not transactions
+    TEST_ESP_OK(i2c_dev_probe(&dev_a, I2C_DEV_WRITE));
+
+    TEST_ESP_OK(i2c_dev_get_stats(&dev_a, &stats));
+    TEST_ASSERT(stats.transactions == 5);
+    TEST_ASSERT(stats.nacks == 2);
+    TEST_ASSERT(stats.timeouts == 1);
+    TEST_ASSERT(stats.errors == 0);
+    TEST_ASSERT(stats.bytes == 3 + 5 + 3 * 2);
+
+    TEST_ESP_OK(i2c_dev_get_stats(&dev_b, &stats));
+    TEST_ASSERT(stats.transactions == 1);
+    TEST_ASSERT(stats.bytes == 3);
+
+    // port sums all of its devices
+    TEST_ESP_OK(i2cdev_get_port_stats(PORT, &stats));
+    TEST_ASSERT(stats.transactions == 6);
+    TEST_ASSERT(stats.nacks == 2 && stats.timeouts == 1);
+    TEST_ASSERT(stats.bytes == 3 + 5 + 3 * 2 + 3);
+
+    TEST_ESP_OK(i2c_dev_reset_stats(&dev_a));
+    TEST_ESP_OK(i2c_dev_get_stats(&dev_a, &stats));
+    TEST_ASSERT(stats.transactions == 0 && stats.bytes == 0 && stats.nacks == 0);
+    TEST_ESP_OK(i2cdev_get_port_stats(PORT, &stats));
+    TEST_ASSERT(stats.transactions == 6);
+
+    TEST_ESP_OK(i2cdev_reset_port_stats(PORT));
+    TEST_ESP_OK(i2cdev_get_port_stats(PORT, &stats));
+    TEST_ASSERT(stats.transactions == 0);
+    TEST_ESP_OK(i2c_dev_get_stats(&dev_b, &stats));
+    TEST_ASSERT(stats.transactions == 1);
+    return 0;
+}
+
+static int test_histogram(void)
+{
+    i2c_dev_stats_t stats;
+    uint8_t val;
+
+    TEST_ESP_OK(i2c_dev_reset_stats(&dev_a));
+    for (int i = 0; i < 3; i++)
+        TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+
+    // bus time is slept, so it is the lower bound of the latency
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, 2500, true));
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, 10000, true));
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ESP_OK(i2c_dev_read_reg(&dev_a, 0x00, &val, 1));
+    TEST_ESP_OK(i2cdev_sim_set_latency(PORT, 0, false));
+
+    TEST_ESP_OK(i2c_dev_get_stats(&dev_a, &stats));
+    TEST_ASSERT(stats.transactions == 6);
+    uint32_t fast = 0, total = 0;
+    for (int i = 0; i < I2CDEV_STATS_HIST_SIZE; i++)
+    {
+        total += stats.latency_hist[i];
+        if (i < 5)
+            fast += stats.latency_hist[i];
+    }
+    TEST_ASSERT(total == 6);
+    // 2.5 ms is in [2048, 4096) us bucket or above, >= 8 ms is the last one
+    TEST_ASSERT(fast == 3);
+    TEST_ASSERT(stats.latency_hist[I2CDEV_STATS_HIST_SIZE - 1] >= 2);
+    TEST_ASSERT(stats.max_latency_us >= 10000);
+    TEST_ASSERT(stats.bus_time_us >= 2500 + 2 * 10000);
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    TEST_ESP_OK(i2cdev_init());
+    TEST_ESP_OK(i2cdev_sim_attach(&sim_a, &i2cdev_sim_regmap, PORT, ADDR_A));
+    TEST_ESP_OK(i2cdev_sim_attach(&sim_b, &i2cdev_sim_regmap, PORT, ADDR_B));
+    memset(&dev_a, 0, sizeof(dev_a));
+    dev_a.port = PORT;
+    dev_a.addr = ADDR_A;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev_a));
+    memset(&dev_b, 0, sizeof(dev_b));
+    dev_b.port = PORT;
+    dev_b.addr = ADDR_B;
+    TEST_ESP_OK(i2c_dev_create_mutex(&dev_b));
+
+    RUN_TEST(test_counters);
+    RUN_TEST(test_histogram);
+
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev_b));
+    TEST_ESP_OK(i2c_dev_delete_mutex(&dev_a));
+    TEST_ESP_OK(i2cdev_done());
+    return failures ? 1 : 0;
+}
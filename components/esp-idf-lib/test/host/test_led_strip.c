@@ -0,0 +1,284 @@
+/*
+ * led_strip on the legacy RMT driver of the shim: RMT items produced by
+ * the translator for the pixel buffer
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <led_strip.h>
+#include "led_strip_ref.h"
+#include "harness.h"
+
+#define CHANNEL     0
+#define REF_CHANNEL 1
+#define LENGTH      86 // not a multiple of translator chunk
+
+static int translate_ref(led_strip_type_t type, const uint8_t *buf, size_t size,
+        const rmt_item32_t **items, size_t *count)
+{
+    ref_rmt_set_type(type);
+    TEST_ESP_OK(rmt_write_sample(REF_CHANNEL, buf, size, true));
+    *count = rmt_shim_items(REF_CHANNEL, items);
+    return 0;
+}
+
+static int test_translator_matches_reference(void)
+{
+    TEST_ESP_OK(rmt_driver_install(REF_CHANNEL, 0, 0));
+    TEST_ESP_OK(rmt_translator_init(REF_CHANNEL, ref_rmt_adapter));
+
+    for (led_strip_type_t type = 0; type < LED_STRIP_TYPE_MAX; type++)
+        for (int rgbw = 0; rgbw < 2; rgbw++)
+        {
+            led_strip_t strip = {
+                .type = type,
+                .is_rgbw = rgbw,
+                .length = LENGTH,
+                .brightness = 255,
+                .channel = CHANNEL,
+            };
+            TEST_ESP_OK(led_strip_init(&strip));
+
+            size_t size = LENGTH * (rgbw ? 4 : 3);
+            for (size_t i = 0; i < size; i++)
+                strip.buf[i] = (uint8_t)(i * 37 + 11);
+            strip.buf[0] = 0x00;
+            strip.buf[1] = 0xff;
+            TEST_ESP_OK(led_strip_flush(&strip));
+
+            const rmt_item32_t *items, *ref;
+            size_t count, ref_count;
+            count = rmt_shim_items(CHANNEL, &items);
+            if (translate_ref(type, strip.buf, size, &ref, &ref_count))
+                return 1;
+            TEST_ASSERT(count == size * 8);
+            TEST_ASSERT(ref_count == count);
+            TEST_ASSERT(!memcmp(items, ref, count * sizeof(rmt_item32_t)));
+
+            TEST_ESP_OK(led_strip_free(&strip));
+        }
+
+    TEST_ESP_OK(rmt_driver_uninstall(REF_CHANNEL));
+    return 0;
+}
+
+// Decode bytes back from RMT items, ref_rmt_set_type() must be called before
+static void decode(const rmt_item32_t *items, size_t count, uint8_t *out)
+{
+    for (size_t i = 0; i < count / 8; i++)
+    {
+        out[i] = 0;
+        for (size_t b = 0; b < 8; b++)
+            out[i] = (out[i] << 1) | (items[i * 8 + b].val == ref_bit1.val);
+    }
+}
+
+static int test_color_order(void)
+{
+    static const struct
+    {
+        led_strip_type_t type;
+        uint8_t bytes[3];
+    } cases[] = {
+        { LED_STRIP_WS2812, { 0x20, 0x10, 0x30 } },
+        { LED_STRIP_SK6812, { 0x20, 0x10, 0x30 } },
+        { LED_STRIP_APA106, { 0x10, 0x20, 0x30 } },
+        { LED_STRIP_SM16703, { 0x10, 0x20, 0x30 } },
+    };
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        led_strip_t strip = {
+            .type = cases[c].type,
+            .length = 2,
+            .brightness = 255,
+            .channel = CHANNEL,
+        };
+        TEST_ESP_OK(led_strip_init(&strip));
+        TEST_ESP_OK(led_strip_set_pixel(&strip, 1, (rgb_t){ .r = 0x10, .g = 0x20, .b = 0x30 }));
+        TEST_ESP_OK(led_strip_flush(&strip));
+
+        const rmt_item32_t *items;
+        uint8_t out[6];
+        TEST_ASSERT(rmt_shim_items(CHANNEL, &items) == 48);
+        ref_rmt_set_type(cases[c].type);
+        decode(items, 48, out);
+        TEST_ASSERT(!out[0] && !out[1] && !out[2]);
+        TEST_ASSERT(!memcmp(out + 3, cases[c].bytes, 3));
+
+        TEST_ESP_OK(led_strip_free(&strip));
+    }
+    return 0;
+}
+
+static int test_lut(void)
+{
+    rgb_lut_t lut = { 0 };
+    rgb_t colors[256];
+    uint8_t index[3] = { 0, 1, 255 };
+
+    rgb_lut_set(&lut, 2.2f, 100, (rgb_t){ .r = 255, .g = 176, .b = 240 });
+    for (int i = 0; i < 256; i++)
+        colors[i] = rgb_from_values(i, 255 - i, i ^ 0x55);
+
+    for (int rgbw = 0; rgbw < 2; rgbw++)
+    {
+        led_strip_t strip = {
+            .type = LED_STRIP_WS2812,
+            .is_rgbw = rgbw,
+            .length = 3,
+            .brightness = 255,
+            .channel = CHANNEL,
+            .lut = &lut,
+        };
+        led_strip_t ref = strip;
+        ref.lut = NULL;
+        ref.channel = REF_CHANNEL;
+        TEST_ESP_OK(led_strip_init(&strip));
+        TEST_ESP_OK(led_strip_init(&ref));
+
+        // tables are applied when pixels are set, by all setters
+        TEST_ESP_OK(led_strip_set_pixels_indexed(&strip, 0, 3, index, colors));
+        for (size_t i = 0; i < 3; i++)
+            TEST_ESP_OK(led_strip_set_pixel(&ref, i, rgb_lut_apply(&lut, colors[index[i]])));
+        TEST_ASSERT(!memcmp(strip.buf, ref.buf, 3 * (rgbw ? 4 : 3)));
+
+        TEST_ESP_OK(led_strip_fill(&strip, 0, 3, colors[7]));
+        TEST_ESP_OK(led_strip_fill(&ref, 0, 3, rgb_lut_apply(&lut, colors[7])));
+        TEST_ASSERT(!memcmp(strip.buf, ref.buf, 3 * (rgbw ? 4 : 3)));
+
+        TEST_ESP_OK(led_strip_free(&strip));
+        TEST_ESP_OK(led_strip_free(&ref));
+    }
+    return 0;
+}
+
+// Average of dithered outputs is the exact scaled value, every output
+// is the scaled value rounded down or up
+static int test_dither(void)
+{
+    enum { LEN = 86, SIZE = LEN * 3, FRAMES = 256 };
+    static const uint8_t levels[] = { 1, 2, 7, 31, 100, 254 };
+    static uint32_t sums[SIZE];
+    uint8_t out[SIZE], orig[SIZE];
+    const rmt_item32_t *items;
+
+    ref_rmt_set_type(LED_STRIP_WS2812);
+    for (size_t l = 0; l < sizeof(levels); l++)
+    {
+        led_strip_t strip = {
+            .type = LED_STRIP_WS2812,
+            .length = LEN,
+            .brightness = levels[l],
+            .dither = true,
+            .channel = CHANNEL,
+        };
+        uint32_t scale = strip.brightness + 1;
+        TEST_ESP_OK(led_strip_init(&strip));
+        for (size_t i = 0; i < SIZE; i++)
+            strip.buf[i] = i < 256 ? i : 255 - i % 256;
+        memcpy(orig, strip.buf, SIZE);
+        memset(sums, 0, sizeof(sums));
+
+        for (int frame = 0; frame < FRAMES; frame++)
+        {
+            TEST_ESP_OK(led_strip_flush(&strip));
+            TEST_ASSERT(rmt_shim_items(CHANNEL, &items) == SIZE * 8);
+            decode(items, SIZE * 8, out);
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                uint32_t exact = orig[i] * scale;
+                TEST_ASSERT(out[i] == exact >> 8 || out[i] == (exact + 255) >> 8);
+                sums[i] += out[i];
+            }
+        }
+        for (size_t i = 0; i < SIZE; i++)
+            TEST_ASSERT(sums[i] == orig[i] * scale);
+        // back buffer is intact, the same frame can be sent again
+        TEST_ASSERT(!memcmp(strip.buf, orig, SIZE));
+
+        // without dithering every frame is scale8_video()
+        strip.dither = false;
+        TEST_ESP_OK(led_strip_flush(&strip));
+        TEST_ASSERT(rmt_shim_items(CHANNEL, &items) == SIZE * 8);
+        decode(items, SIZE * 8, out);
+        for (size_t i = 0; i < SIZE; i++)
+            TEST_ASSERT(out[i] == scale8_video(orig[i], strip.brightness));
+
+        TEST_ESP_OK(led_strip_free(&strip));
+    }
+    return 0;
+}
+
+// done_cb arguments of the sent frames
+static struct
+{
+    int calls;
+    led_strip_t *strip;
+    void *ctx;
+} done;
+
+static bool on_done(led_strip_t *strip, void *ctx)
+{
+    done.calls++;
+    done.strip = strip;
+    done.ctx = ctx;
+    return false;
+}
+
+static int test_double_buffer(void)
+{
+    enum { LEN = 5, SIZE = LEN * 3 };
+    static int ctx;
+    const rmt_item32_t *items;
+    uint8_t out[SIZE];
+
+    memset(&done, 0, sizeof(done));
+    led_strip_t strip = {
+        .type = LED_STRIP_WS2812,
+        .length = LEN,
+        .brightness = 255,
+        .channel = CHANNEL,
+        .double_buffer = true,
+        .done_cb = on_done,
+        .done_ctx = &ctx,
+    };
+    TEST_ESP_OK(led_strip_init(&strip));
+    TEST_ASSERT(strip.buf && strip.tx_buf && strip.buf != strip.tx_buf);
+
+    ref_rmt_set_type(LED_STRIP_WS2812);
+    for (int frame = 0; frame < 4; frame++)
+    {
+        // next frame is rendered while the previous one is in the front buffer
+        uint8_t *back = strip.buf, *front = strip.tx_buf;
+        for (size_t i = 0; i < SIZE; i++)
+            back[i] = (uint8_t)(frame * 50 + i);
+        TEST_ESP_OK(led_strip_flush(&strip));
+
+        TEST_ASSERT(strip.buf == front && strip.tx_buf == back);
+        TEST_ASSERT(rmt_shim_items(CHANNEL, &items) == SIZE * 8);
+        decode(items, SIZE * 8, out);
+        for (size_t i = 0; i < SIZE; i++)
+            TEST_ASSERT(out[i] == (uint8_t)(frame * 50 + i));
+
+        TEST_ASSERT(done.calls == frame + 1);
+        TEST_ASSERT(done.strip == &strip && done.ctx == &ctx);
+    }
+
+    TEST_ESP_OK(led_strip_free(&strip));
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    led_strip_install();
+
+    RUN_TEST(test_translator_matches_reference);
+    RUN_TEST(test_color_order);
+    RUN_TEST(test_lut);
+    RUN_TEST(test_dither);
+    RUN_TEST(test_double_buffer);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * Noise fields against inoise16_3d()
+ */
+#include <stdlib.h>
+#include <noise.h>
+#include "harness.h"
+
+#define MAX_W 40
+#define MAX_H 40
+
+static uint16_t reference(const noise_field_t *f, size_t i, size_t j, uint32_t z)
+{
+    uint32_t acc = 0;
+    for (uint8_t o = 0; o < f->octaves; o++)
+        acc += inoise16_3d((f->x + i * f->scale_x) << o, (f->y + j * f->scale_y) << o, z) >> o;
+    return acc > 0xffff ? 0xffff : acc;
+}
+
+static int check(const noise_field_t *f, uint32_t z)
+{
+    uint16_t out16[MAX_W * MAX_H];
+    uint8_t out8[MAX_W * MAX_H];
+
+    noise_field_fill16((noise_field_t *)f, z, out16);
+    noise_field_fill8((noise_field_t *)f, z, out8);
+    for (size_t j = 0; j < f->height; j++)
+        for (size_t i = 0; i < f->width; i++)
+        {
+            uint16_t ref = reference(f, i, j, z);
+            TEST_ASSERT(out16[j * f->width + i] == ref);
+            TEST_ASSERT(out8[j * f->width + i] == ref >> 8);
+        }
+    return 0;
+}
+
+static int test_field_matches_inoise16_3d(void)
+{
+    srand(3);
+    for (int round = 0; round < 300; round++)
+    {
+        noise_field_t f;
+        size_t w = 1 + rand() % MAX_W, h = 1 + rand() % MAX_H;
+        TEST_ASSERT(noise_field_init(&f, w, h, 1 + rand() % 3));
+        TEST_ASSERT(noise_field_set(&f, rand() * 7919u, rand() * 31u, rand() % 300000, rand() % 300000));
+
+        // small steps reuse cached cells, large ones and going back reset them
+        uint32_t z = rand() * 13u;
+        for (int frame = 0; frame < 20; frame++)
+        {
+            if (check(&f, z))
+                return 1;
+            z += frame == 10 ? (uint32_t)-300000 : frame % 4 ? (uint32_t)(rand() % 9000) : 0x30000;
+        }
+
+        // scrolling keeps the cache consistent
+        TEST_ASSERT(noise_field_set(&f, f.x + 0x8000, f.y, f.scale_x, f.scale_y));
+        if (check(&f, z))
+            return 1;
+
+        noise_field_free(&f);
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    RUN_TEST(test_field_matches_inoise16_3d);
+
+    return failures ? 1 : 0;
+}
@@ -1,44 +1,754 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include "http_client.h"
+#include "device_config.h"
 #include "esp_log.h"
-#include "esp_http_client.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "esp_crt_bundle.h"
 #include "sdkconfig.h"
 
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+#include "esp_attr.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#endif
+
 static const char *TAG = "HTTP_CLIENT";
 
-void http_client_init(void) {
+#define HTTP_HOST_MAX_LEN   64
+#define HTTP_LINE_MAX_LEN   96
+#define HTTP_RX_BUF_LEN     256
+
+// Tras un cierre con solicitudes en curso se envía de a una durante este tiempo
+#define HTTP_PIPELINE_BACKOFF_US    (10 * 60 * 1000000LL)
+
+// Estados del parser de respuestas HTTP/1.1 (procesa por bloques, sin bufferizar la respuesta)
+typedef enum {
+    RESP_STATUS,
+    RESP_HEADERS,
+    RESP_BODY,
+    RESP_CHUNK_SIZE,
+    RESP_CHUNK_DATA,
+    RESP_CHUNK_END,
+    RESP_TRAILER,
+    RESP_DONE,
+    RESP_ERROR
+} resp_state_t;
+
+typedef struct {
+    resp_state_t state;
+    char line[HTTP_LINE_MAX_LEN];   // Línea actual (se trunca, solo importan los encabezados conocidos)
+    size_t line_len;
+    int status_code;
+    int64_t remaining;              // Bytes de cuerpo o de chunk pendientes (-1: hasta cerrar)
+    bool chunked;
+    bool has_length;
+    bool keep_alive;
+} http_resp_parser_t;
+
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+
+#define TLS_MASTER_LEN      48
+
+// TLS sobre el socket TCP que abre esp-tls. esp-tls no permite crear una sesión
+// a partir de una serializada, así que con reanudación el handshake lo hace
+// mbedtls directamente y la sesión se guarda y restaura con su API pública.
+typedef struct {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_net_context net;
+    uint8_t master[TLS_MASTER_LEN];     // Secreto maestro de esta conexión (TLS 1.2)
+    bool has_master;
+} http_tls_t;
+
+#endif
+
+// Conexión keep-alive sobre esp-tls (TCP plano para http, TLS para https)
+typedef struct {
+    esp_tls_t *tls;
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+    http_tls_t *ssl;                    // NULL para http
+#endif
+    http_resp_parser_t parser;
+    char rx[HTTP_RX_BUF_LEN];
+    size_t rx_len;
+    size_t rx_pos;
+} http_conn_t;
+
+static char http_host[HTTP_HOST_MAX_LEN];
+static const char *http_path;
+static int64_t pipelining_retry_at;     // Antes de este instante no se usa pipelining
+
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+
+#define TLS_SESSION_MAGIC   0x544C5332     // "TLS2"
+
+// Sesión TLS serializada (ticket o session ID), sobrevive al deep sleep.
+// El secreto maestro permite saber si el servidor aceptó la reanudación.
+typedef struct {
+    uint32_t magic;
+    uint32_t len;
+    uint8_t master[TLS_MASTER_LEN];
+    uint8_t data[CONFIG_HTTP_POST_TLS_SESSION_CACHE_SIZE];
+} tls_session_cache_t;
+
+static RTC_DATA_ATTR tls_session_cache_t tls_session_cache;
+
+
+static void tls_session_forget(void) {
+    tls_session_cache.magic = 0;
+    tls_session_cache.len = 0;
+}
+
+// Carga la sesión guardada en memoria RTC (false si no hay una válida)
+static bool tls_session_restore(mbedtls_ssl_session *session) {
+    if (tls_session_cache.magic != TLS_SESSION_MAGIC || tls_session_cache.len == 0 ||
+        tls_session_cache.len > sizeof(tls_session_cache.data)) {
+        return false;
+    }
+
+    int ret = mbedtls_ssl_session_load(session, tls_session_cache.data, tls_session_cache.len);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "Sesión TLS en RTC inválida (-0x%04x), se descarta.", -ret);
+        tls_session_forget();
+        return false;
+    }
+    return true;
+}
+
+// Serializa la sesión negociada en memoria RTC para el próximo despertar
+static void tls_session_store(http_tls_t *t) {
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+
+    size_t olen = 0;
+    int ret = mbedtls_ssl_get_session(&t->ssl, &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, tls_session_cache.data, sizeof(tls_session_cache.data), &olen);
+    }
+    // Sin secreto maestro (TLS 1.3) no se podría comprobar la reanudación: no se guarda
+    if (ret == 0 && t->has_master) {
+        memcpy(tls_session_cache.master, t->master, TLS_MASTER_LEN);
+        tls_session_cache.len = olen;
+        tls_session_cache.magic = TLS_SESSION_MAGIC;
+    } else {
+        if (ret != 0) {
+            ESP_LOGW(TAG, "No se pudo guardar la sesión TLS (-0x%04x). Aumente HTTP_POST_TLS_SESSION_CACHE_SIZE.", -ret);
+        }
+        tls_session_forget();
+    }
+    mbedtls_ssl_session_free(&session);
+}
+
+// mbedtls entrega el secreto maestro al derivar las claves. Una sesión reanudada
+// reutiliza el de la sesión ofrecida; un handshake completo negocia uno nuevo.
+static void tls_export_keys(void *arg, mbedtls_ssl_key_export_type type, const unsigned char *secret,
+                            size_t secret_len, const unsigned char client_random[32],
+                            const unsigned char server_random[32], mbedtls_tls_prf_types tls_prf_type) {
+    http_tls_t *t = arg;
+    if (type == MBEDTLS_SSL_KEY_EXPORT_TLS12_MASTER_SECRET && secret_len == TLS_MASTER_LEN) {
+        memcpy(t->master, secret, TLS_MASTER_LEN);
+        t->has_master = true;
+    }
+}
+
+static void tls_free(http_conn_t *conn) {
+    http_tls_t *t = conn->ssl;
+    if (t == NULL) {
+        return;
+    }
+    // El socket pertenece a esp-tls: no se llama a mbedtls_net_free()
+    mbedtls_ssl_free(&t->ssl);
+    mbedtls_ssl_config_free(&t->conf);
+    mbedtls_ctr_drbg_free(&t->drbg);
+    mbedtls_entropy_free(&t->entropy);
+    free(t);
+    conn->ssl = NULL;
+}
+
+// Handshake TLS sobre la conexión TCP ya abierta. Devuelve 0 o el error de mbedtls.
+// `verify_mode` permite al benchmark aceptar el certificado de un servidor local.
+static int tls_open(http_conn_t *conn, int timeout_ms, int verify_mode, bool *resumed) {
+    *resumed = false;
+
+    int fd;
+    if (esp_tls_get_conn_sockfd(conn->tls, &fd) != ESP_OK) {
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+    }
+
+    http_tls_t *t = calloc(1, sizeof(http_tls_t));
+    if (t == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    conn->ssl = t;
+    mbedtls_ssl_init(&t->ssl);
+    mbedtls_ssl_config_init(&t->conf);
+    mbedtls_ctr_drbg_init(&t->drbg);
+    mbedtls_entropy_init(&t->entropy);
+    mbedtls_net_init(&t->net);
+    t->net.fd = fd;
+
+    int ret;
+    if ((ret = mbedtls_ctr_drbg_seed(&t->drbg, mbedtls_entropy_func, &t->entropy, NULL, 0)) != 0 ||
+        (ret = mbedtls_ssl_config_defaults(&t->conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+        return ret;
+    }
+    mbedtls_ssl_conf_rng(&t->conf, mbedtls_ctr_drbg_random, &t->drbg);
+    mbedtls_ssl_conf_authmode(&t->conf, verify_mode);
+    mbedtls_ssl_conf_read_timeout(&t->conf, timeout_ms);
+    if (esp_crt_bundle_attach(&t->conf) != ESP_OK) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    if ((ret = mbedtls_ssl_setup(&t->ssl, &t->conf)) != 0 ||
+        (ret = mbedtls_ssl_set_hostname(&t->ssl, http_host)) != 0) {
+        return ret;
+    }
+    mbedtls_ssl_set_bio(&t->ssl, &t->net, mbedtls_net_send, NULL, mbedtls_net_recv_timeout);
+    mbedtls_ssl_set_export_keys_cb(&t->ssl, tls_export_keys, t);
+
+    mbedtls_ssl_session saved;
+    mbedtls_ssl_session_init(&saved);
+    bool offered = tls_session_restore(&saved) && mbedtls_ssl_set_session(&t->ssl, &saved) == 0;
+    mbedtls_ssl_session_free(&saved);
+
+    do {
+        ret = mbedtls_ssl_handshake(&t->ssl);
+    } while (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE);
+
+    if (ret == 0) {
+        *resumed = offered && t->has_master &&
+                   memcmp(t->master, tls_session_cache.master, TLS_MASTER_LEN) == 0;
+    }
+    return ret;
+}
+
+#endif  // CONFIG_HTTP_POST_TLS_RESUMPTION
+
+// Separa "http[s]://host[:puerto]/ruta" en host y ruta
+static bool parse_url(const char *url, char *host, size_t host_len, const char **path) {
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+
+    size_t len = strcspn(start, ":/");
+    if (len == 0 || len >= host_len) {
+        return false;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+
+    *path = strchr(start, '/');
+    if (*path == NULL) {
+        *path = "/";
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Parser de respuestas
+// ---------------------------------------------------------------------------
+
+static void resp_parser_reset(http_resp_parser_t *p) {
+    memset(p, 0, sizeof(*p));
+    p->state = RESP_STATUS;
+    p->status_code = -1;
+    p->keep_alive = true;
+}
+
+static bool header_is(const char *line, const char *name, const char **value) {
+    size_t len = strlen(name);
+    if (strncasecmp(line, name, len) != 0 || line[len] != ':') {
+        return false;
+    }
+    *value = line + len + 1;
+    while (**value == ' ' || **value == '\t') (*value)++;
+    return true;
+}
+
+static bool value_contains(const char *value, const char *token) {
+    size_t len = strlen(token);
+    for (; *value; value++) {
+        if (strncasecmp(value, token, len) == 0) return true;
+    }
+    return false;
+}
+
+// Fin de encabezados: decide cómo se delimita el cuerpo
+static void resp_headers_done(http_resp_parser_t *p) {
+    if (p->status_code >= 100 && p->status_code < 200) {
+        // 100 Continue y similares: viene otra línea de estado
+        p->state = RESP_STATUS;
+    } else if (p->status_code == 204 || p->status_code == 304) {
+        p->state = RESP_DONE;
+    } else if (p->chunked) {
+        p->state = RESP_CHUNK_SIZE;
+    } else if (p->has_length) {
+        p->state = p->remaining > 0 ? RESP_BODY : RESP_DONE;
+    } else {
+        // Sin longitud: el cuerpo termina al cerrar la conexión
+        p->remaining = -1;
+        p->keep_alive = false;
+        p->state = RESP_BODY;
+    }
+}
+
+static void resp_handle_line(http_resp_parser_t *p) {
+    const char *value;
+
+    switch (p->state) {
+        case RESP_STATUS:
+            if (p->line_len == 0) break;   // CRLF sobrante entre respuestas
+            if (strncmp(p->line, "HTTP/1.", 7) != 0 || sscanf(p->line + 8, " %d", &p->status_code) != 1) {
+                p->state = RESP_ERROR;
+                break;
+            }
+            if (p->line[7] == '0') {
+                p->keep_alive = false;   // HTTP/1.0 cierra por defecto
+            }
+            p->chunked = false;
+            p->has_length = false;
+            p->state = RESP_HEADERS;
+            break;
+
+        case RESP_HEADERS:
+            if (p->line_len == 0) {
+                resp_headers_done(p);
+            } else if (header_is(p->line, "Content-Length", &value)) {
+                p->remaining = strtoll(value, NULL, 10);
+                p->has_length = true;
+            } else if (header_is(p->line, "Transfer-Encoding", &value)) {
+                p->chunked = value_contains(value, "chunked");
+            } else if (header_is(p->line, "Connection", &value)) {
+                if (value_contains(value, "close")) p->keep_alive = false;
+                else if (value_contains(value, "keep-alive")) p->keep_alive = true;
+            }
+            break;
+
+        case RESP_CHUNK_SIZE:
+            p->remaining = strtoll(p->line, NULL, 16);
+            p->state = p->remaining > 0 ? RESP_CHUNK_DATA : RESP_TRAILER;
+            break;
+
+        case RESP_CHUNK_END:
+            p->state = RESP_CHUNK_SIZE;
+            break;
+
+        case RESP_TRAILER:
+            if (p->line_len == 0) p->state = RESP_DONE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Procesa hasta `len` bytes y devuelve cuántos consumió. Se detiene al completar
+// una respuesta, de modo que los bytes restantes pertenecen a la siguiente.
+static size_t resp_parser_feed(http_resp_parser_t *p, const char *data, size_t len) {
+    size_t pos = 0;
+
+    while (pos < len && p->state != RESP_DONE && p->state != RESP_ERROR) {
+        if (p->state == RESP_BODY || p->state == RESP_CHUNK_DATA) {
+            size_t avail = len - pos;
+            if (p->remaining < 0) {
+                pos = len;   // Cuerpo hasta cerrar: se descarta todo
+                continue;
+            }
+            size_t skip = (int64_t)avail < p->remaining ? avail : (size_t)p->remaining;
+            pos += skip;
+            p->remaining -= skip;
+            if (p->remaining == 0) {
+                p->state = p->state == RESP_BODY ? RESP_DONE : RESP_CHUNK_END;
+            }
+            continue;
+        }
+
+        char c = data[pos++];
+        if (c == '\n') {
+            if (p->line_len > 0 && p->line[p->line_len - 1] == '\r') p->line_len--;
+            p->line[p->line_len] = '\0';
+            resp_handle_line(p);
+            p->line_len = 0;
+        } else if (p->line_len < sizeof(p->line) - 1) {
+            p->line[p->line_len++] = c;
+        }
+    }
+    return pos;
+}
+
+// ---------------------------------------------------------------------------
+// Conexión
+// ---------------------------------------------------------------------------
+
+static void conn_close(http_conn_t *conn) {
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+    if (conn->ssl) {
+        mbedtls_ssl_close_notify(&conn->ssl->ssl);
+        tls_free(conn);
+    }
+#endif
+    if (conn->tls) {
+        esp_tls_conn_destroy(conn->tls);
+        conn->tls = NULL;
+    }
+}
+
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+
+static bool conn_open_verify(http_conn_t *conn, int verify_mode, bool *resumed, int64_t *handshake_us) {
+    memset(conn, 0, sizeof(*conn));
+    bool https = strncmp(CONFIG_HTTP_POST_URL, "https://", 8) == 0;
+    int timeout_ms = device_config_get()->http_timeout_ms;
+
+    // esp-tls solo abre el TCP; el TLS lo negocia tls_open()
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+        .is_plain_tcp = true,
+    };
+
+    conn->tls = esp_tls_init();
+    if (conn->tls == NULL) {
+        ESP_LOGE(TAG, "Error creando conexión");
+        return false;
+    }
+
+    if (esp_tls_conn_http_new_sync(CONFIG_HTTP_POST_URL, &cfg, conn->tls) != 1) {
+        // Fallo de red: la sesión guardada sigue siendo válida
+        ESP_LOGE(TAG, "Error conectando con %s", http_host);
+        esp_tls_conn_destroy(conn->tls);
+        conn->tls = NULL;
+        return false;
+    }
+    *resumed = false;
+    *handshake_us = 0;
+    if (!https) {
+        return true;
+    }
+
+    int64_t t_start = esp_timer_get_time();
+    int ret = tls_open(conn, timeout_ms, verify_mode, resumed);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Error en handshake TLS con %s: -0x%04x", http_host, (unsigned int)-ret);
+        // Solo un fallo del propio TLS invalida la sesión (rechazada, caducada, corrupta)
+        if (ret != MBEDTLS_ERR_SSL_TIMEOUT && ret != MBEDTLS_ERR_NET_RECV_FAILED &&
+            ret != MBEDTLS_ERR_NET_SEND_FAILED && ret != MBEDTLS_ERR_NET_CONN_RESET &&
+            ret != MBEDTLS_ERR_SSL_ALLOC_FAILED && ret != MBEDTLS_ERR_NET_INVALID_CONTEXT) {
+            tls_session_forget();
+        }
+        conn_close(conn);
+        return false;
+    }
+
+    *handshake_us = esp_timer_get_time() - t_start;
+    ESP_LOGI(TAG, "Handshake TLS en %lld ms (%s)", *handshake_us / 1000,
+             *resumed ? "sesión reanudada" : "completo");
+    tls_session_store(conn->ssl);
+    return true;
+}
+
+static bool conn_open(http_conn_t *conn) {
+    bool resumed;
+    int64_t handshake_us;
+    return conn_open_verify(conn, MBEDTLS_SSL_VERIFY_REQUIRED, &resumed, &handshake_us);
+}
+
+#else
+
+static bool conn_open(http_conn_t *conn) {
+    memset(conn, 0, sizeof(*conn));
+    bool https = strncmp(CONFIG_HTTP_POST_URL, "https://", 8) == 0;
+
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = device_config_get()->http_timeout_ms,
+        .is_plain_tcp = !https,
+    };
+    if (https) {
+        cfg.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+
+    conn->tls = esp_tls_init();
+    if (conn->tls == NULL) {
+        ESP_LOGE(TAG, "Error creando conexión");
+        return false;
+    }
+
+    int64_t t_start = esp_timer_get_time();
+    bool connected = esp_tls_conn_http_new_sync(CONFIG_HTTP_POST_URL, &cfg, conn->tls) == 1;
+    if (https && connected) {
+        ESP_LOGI(TAG, "Handshake TLS en %lld ms", (esp_timer_get_time() - t_start) / 1000);
+    }
+
+    if (!connected) {
+        ESP_LOGE(TAG, "Error conectando con %s", http_host);
+        esp_tls_conn_destroy(conn->tls);
+        conn->tls = NULL;
+    }
+    return connected;
+}
+
+#endif  // CONFIG_HTTP_POST_TLS_RESUMPTION
+
+static ssize_t conn_write(http_conn_t *conn, const char *buf, size_t len) {
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+    if (conn->ssl) {
+        return mbedtls_ssl_write(&conn->ssl->ssl, (const unsigned char *)buf, len);
+    }
+#endif
+    return esp_tls_conn_write(conn->tls, buf, len);
+}
+
+static ssize_t conn_read(http_conn_t *conn, char *buf, size_t len) {
+#if CONFIG_HTTP_POST_TLS_RESUMPTION
+    if (conn->ssl) {
+        return mbedtls_ssl_read(&conn->ssl->ssl, (unsigned char *)buf, len);
+    }
+#endif
+    return esp_tls_conn_read(conn->tls, buf, len);
+}
+
+static bool conn_write_all(http_conn_t *conn, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = conn_write(conn, buf, len);
+        if (written >= 0) {
+            buf += written;
+            len -= written;
+        } else if (written != ESP_TLS_ERR_SSL_WANT_READ && written != ESP_TLS_ERR_SSL_WANT_WRITE) {
+            ESP_LOGE(TAG, "Error escribiendo en la conexión: -0x%04x", (unsigned int)-written);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool conn_send_post(http_conn_t *conn, const char *json_data, bool last) {
+    char header[192 + HTTP_HOST_MAX_LEN];
+    size_t body_len = strlen(json_data);
+    int header_len = snprintf(header, sizeof(header),
+                              "POST %s HTTP/1.1\r\n"
+                              "Host: %s\r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: %u\r\n"
+                              "Connection: %s\r\n\r\n",
+                              http_path, http_host, (unsigned int)body_len,
+                              last ? "close" : "keep-alive");
+
+    if (header_len <= 0 || header_len >= sizeof(header)) {
+        return false;
+    }
+    return conn_write_all(conn, header, header_len) && conn_write_all(conn, json_data, body_len);
+}
+
+// Lee la siguiente respuesta del pipeline. `keep_alive` indica si la conexión sigue utilizable.
+static bool conn_read_response(http_conn_t *conn, int *status_code, bool *keep_alive) {
+    http_resp_parser_t *p = &conn->parser;
+    resp_parser_reset(p);
+
+    while (p->state != RESP_DONE) {
+        if (conn->rx_pos == conn->rx_len) {
+            ssize_t ret = conn_read(conn, conn->rx, sizeof(conn->rx));
+            if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+                continue;
+            }
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+            // TLS 1.3: el servidor puede enviar tickets tras el handshake; no son datos ni error
+            if (ret == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET) {
+                continue;
+            }
+#endif
+            if (ret <= 0) {
+                // EOF solo es válido si el cuerpo se delimitaba por cierre
+                if (p->state == RESP_BODY && p->remaining < 0) {
+                    p->state = RESP_DONE;
+                    break;
+                }
+                return false;
+            }
+            conn->rx_len = ret;
+            conn->rx_pos = 0;
+        }
+
+        conn->rx_pos += resp_parser_feed(p, conn->rx + conn->rx_pos, conn->rx_len - conn->rx_pos);
+        if (p->state == RESP_ERROR) {
+            ESP_LOGE(TAG, "Respuesta HTTP inválida");
+            return false;
+        }
+    }
+
+    *status_code = p->status_code;
+    *keep_alive = p->keep_alive;
+    return true;
+}
+
+bool http_client_init(void) {
+    if (!parse_url(CONFIG_HTTP_POST_URL, http_host, sizeof(http_host), &http_path)) {
+        ESP_LOGE(TAG, "URL inválida: %s", CONFIG_HTTP_POST_URL);
+        http_path = NULL;
+        return false;
+    }
     ESP_LOGI(TAG, "Cliente HTTP inicializado");
+    return true;
+}
+
+static size_t pipeline_window(void) {
+    if (pipelining_retry_at != 0 && esp_timer_get_time() < pipelining_retry_at) {
+        return 1;
+    }
+    pipelining_retry_at = 0;
+    return CONFIG_HTTP_POST_PIPELINE_DEPTH;
+}
+
+size_t http_client_post_batch(const char *const json_data[], size_t count, bool results[]) {
+    for (size_t i = 0; i < count; i++) {
+        results[i] = false;
+    }
+
+    if (http_path == NULL && !http_client_init()) {
+        return 0;
+    }
+
+    size_t done = 0;
+    size_t sent_ok = 0;
+    http_conn_t conn;
+
+    while (done < count) {
+        if (!conn_open(&conn)) {
+            break;
+        }
+
+        bool alive = true;
+        bool fresh = true;
+        while (alive && done < count) {
+            size_t window = pipeline_window();
+            if (window > count - done) {
+                window = count - done;
+            }
+
+            // Enviar la ventana completa sin esperar respuestas
+            size_t sent = 0;
+            while (sent < window && conn_send_post(&conn, json_data[done + sent], done + sent == count - 1)) {
+                sent++;
+            }
+            // Una escritura fallida puede haber llegado al servidor en parte o completa
+            size_t attempted = sent < window ? sent + 1 : sent;
+            if (sent < window) {
+                alive = false;
+            }
+
+            // Las respuestas llegan en el mismo orden que las solicitudes
+            size_t answered = 0;
+            while (answered < sent) {
+                int status_code;
+                bool keep_alive;
+                if (!conn_read_response(&conn, &status_code, &keep_alive)) {
+                    alive = false;
+                    break;
+                }
+
+                ESP_LOGI(TAG, "Datos enviados. Código HTTP: %d", status_code);
+
+                // Validar si el código HTTP es éxito (200-299)
+                bool ok = status_code >= 200 && status_code < 300;
+                if (ok) {
+                    sent_ok++;
+                } else {
+                    ESP_LOGE(TAG, "Error en respuesta HTTP. Código: %d", status_code);
+                }
+                results[done + answered] = ok;
+                answered++;
+
+                if (!keep_alive) {
+                    alive = false;
+                    break;
+                }
+            }
+
+            if (answered < sent && sent > 1 && answered > 0) {
+                ESP_LOGW(TAG, "El servidor cerró la conexión con %u solicitudes en curso. "
+                         "Se desactiva el pipelining temporalmente.", (unsigned int)(sent - answered));
+                pipelining_retry_at = esp_timer_get_time() + HTTP_PIPELINE_BACKOFF_US;
+            }
+
+            if (answered == 0 && fresh) {
+                // Ni siquiera una respuesta en una conexión nueva: el servidor no responde
+                ESP_LOGE(TAG, "Sin respuesta del servidor. Se cancelan %u envíos.", (unsigned int)(count - done));
+                conn_close(&conn);
+                return sent_ok;
+            }
+
+            // Los POST sin respuesta pudieron procesarse: no se reenvían (RFC 7230 §6.3.2),
+            // quedan como fallidos y el llamador decide si reintentarlos.
+            if (answered < attempted) {
+                ESP_LOGW(TAG, "%u solicitudes sin respuesta no se reenvían en esta conexión.",
+                         (unsigned int)(attempted - answered));
+            }
+            done += attempted;
+            fresh = false;
+        }
+
+        conn_close(&conn);
+    }
+
+    ESP_LOGI(TAG, "Enviados %u/%u registros.", (unsigned int)sent_ok, (unsigned int)count);
+    return sent_ok;
 }
 
 bool http_client_post(const char* json_data) {
-    esp_http_client_config_t config = {
-        .url = CONFIG_HTTP_POST_URL,
-        .timeout_ms = CONFIG_HTTP_POST_TIMEOUT,
-        .method = HTTP_METHOD_POST
-    };
+    bool result = false;
+    http_client_post_batch(&json_data, 1, &result);
+    return result;
+}
 
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+#if CONFIG_HTTP_POST_TLS_BENCHMARK > 0
 
-    esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_post_field(client, json_data, strlen(json_data));
+void http_client_tls_benchmark(void) {
+    if (http_path == NULL && !http_client_init()) {
+        return;
+    }
+    if (strncmp(CONFIG_HTTP_POST_URL, "https://", 8) != 0) {
+        ESP_LOGW(TAG, "El benchmark TLS requiere una URL https.");
+        return;
+    }
+
+    // [0]: handshake completo (sin sesión guardada), [1]: ofreciendo la sesión anterior
+    int64_t total_us[2] = { 0 };
+    int ok[2] = { 0 };
+    int reanudadas = 0;
 
-    esp_err_t err = esp_http_client_perform(client);
-    int status_code = esp_http_client_get_status_code(client);
+    for (int i = 0; i < CONFIG_HTTP_POST_TLS_BENCHMARK; i++) {
+        for (int reanudar = 0; reanudar < 2; reanudar++) {
+            if (!reanudar) {
+                tls_session_forget();
+            }
 
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Datos enviados. Código HTTP: %d", status_code);
+            // VERIFY_OPTIONAL: el certificado se verifica igual (su costo se mide),
+            // pero un servidor local con certificado autofirmado no aborta la prueba
+            http_conn_t conn;
+            bool resumed;
+            int64_t handshake_us;
+            if (!conn_open_verify(&conn, MBEDTLS_SSL_VERIFY_OPTIONAL, &resumed, &handshake_us)) {
+                continue;
+            }
+            conn_close(&conn);
 
-        // Validar si el código HTTP es éxito (200-299)
-        if (status_code >= 200 && status_code < 300) {
-            esp_http_client_cleanup(client);
-            return true;
-        } else {
-            ESP_LOGE(TAG, "Error en respuesta HTTP. Código: %d", status_code);
+            total_us[reanudar] += handshake_us;
+            ok[reanudar]++;
+            if (reanudar && resumed) {
+                reanudadas++;
+            }
         }
-    } else {
-        ESP_LOGE(TAG, "Error al enviar datos: %s", esp_err_to_name(err));
     }
 
-    // Si falló, limpiar y retornar falso
-    esp_http_client_cleanup(client);
-    return false;
+    ESP_LOGI(TAG, "Benchmark TLS: completo %lld ms promedio (%d/%d)",
+             ok[0] ? total_us[0] / ok[0] / 1000 : -1LL, ok[0], CONFIG_HTTP_POST_TLS_BENCHMARK);
+    ESP_LOGI(TAG, "Benchmark TLS: reanudado %lld ms promedio (%d/%d, %d aceptadas por el servidor)",
+             ok[1] ? total_us[1] / ok[1] / 1000 : -1LL, ok[1], CONFIG_HTTP_POST_TLS_BENCHMARK, reanudadas);
 }
+
+#endif  // CONFIG_HTTP_POST_TLS_BENCHMARK
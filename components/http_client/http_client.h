@@ -2,10 +2,22 @@
 #define HTTP_CLIENT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
-void http_client_init(void);
+// Devuelve false si CONFIG_HTTP_POST_URL no es una URL válida
+bool http_client_init(void);
 
 bool http_client_post(const char* json_data);
 
+// Envía `count` registros por una conexión keep-alive con hasta
+// CONFIG_HTTP_POST_PIPELINE_DEPTH solicitudes en curso. `results[i]` indica
+// si el registro i fue aceptado (2xx). Devuelve la cantidad de aceptados.
+// Las solicitudes que quedaron sin respuesta al cerrarse la conexión no se
+// reenvían (pudieron llegar al servidor): se informan como no aceptadas.
+size_t http_client_post_batch(const char *const json_data[], size_t count, bool results[]);
+
+// Mide el handshake TLS contra CONFIG_HTTP_POST_URL (https) con y sin reanudación
+// de sesión, CONFIG_HTTP_POST_TLS_BENCHMARK rondas. Solo existe si esa opción es > 0.
+void http_client_tls_benchmark(void);
 
 #endif	//	HTTP_CLIENT_H
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "nvs_storage.h"
+#include "device_config.h"
 
 #include "sensor_manager.h"
 #include "wifi_manager.h"
@@ -35,7 +36,7 @@ QueueHandle_t sensor_manager_get_post_queue(void) {
 // Manejar fallos críticos
 static void manejar_fallo(const char *motivo) {
     ESP_LOGE(TAG, "Fallo crítico: %s. Entrando en deep sleep...", motivo);
-    esp_sleep_enable_timer_wakeup(MEDICION_INTERVALO_MS * 1000);
+    esp_sleep_enable_timer_wakeup((uint64_t)device_config_get()->medicion_intervalo_ms * 1000);
     esp_deep_sleep_start();
 }
 
@@ -53,6 +54,19 @@ static void inicializar_recursos() {
 
     http_post_done_semaphore = xSemaphoreCreateBinary();
     nvs_storage_init();
+
+    // Configuración cacheada en NVS: disponible antes de Wi-Fi
+    device_config_load();
+}
+
+// Margen para crear la tarea, tomar los datos de la cola y publicar el resultado
+#define HTTP_POST_MARGEN_MS     5000
+
+// Peor caso de task_http_post: en cada intento la conexión y la respuesta pueden
+// agotar el timeout, y entre intentos se espera retry_delay
+static uint32_t espera_http_post_ms(void) {
+    const device_config_t *cfg = device_config_get();
+    return cfg->http_retries * (2 * cfg->http_timeout_ms + cfg->http_retry_delay_ms) + HTTP_POST_MARGEN_MS;
 }
 
 // Enviar datos vía HTTP
@@ -67,7 +81,7 @@ static bool enviar_datos_http(sensor_data_t *data) {
     xTaskCreate(task_http_post, "task_http_post", 4096, NULL, 5, NULL);
 
     bool envio_exitoso = false;
-    if (!xQueueReceive(http_post_result_queue, &envio_exitoso, pdMS_TO_TICKS(10000))) {
+    if (!xQueueReceive(http_post_result_queue, &envio_exitoso, pdMS_TO_TICKS(espera_http_post_ms()))) {
         ESP_LOGW(TAG, "Timeout en HTTP POST. Se guardarán datos en NVS.");
         envio_exitoso = false;
     }
@@ -81,10 +95,14 @@ static bool enviar_datos_http(sensor_data_t *data) {
     return envio_exitoso;
 }
 
-// Reenviar datos pendientes desde NVS
+// Reenviar datos pendientes desde NVS (en una sola conexión con pipelining)
 void reenviar_datos_pendientes_nvs() {
-    sensor_data_t datos_pendientes[MAX_NVS_RECORDS];
-    char claves_existentes[MAX_NVS_RECORDS][MAX_KEY_LEN];  
+    static sensor_data_t datos_pendientes[MAX_NVS_RECORDS];
+    static char claves_existentes[MAX_NVS_RECORDS][MAX_KEY_LEN];
+    static char json_pendientes[MAX_NVS_RECORDS][256];
+    const char *json_ptrs[MAX_NVS_RECORDS];
+    bool resultados[MAX_NVS_RECORDS];
+
     size_t count = nvs_retrieve_failed_data(datos_pendientes, claves_existentes);
 
     if (count == 0) {
@@ -92,18 +110,20 @@ void reenviar_datos_pendientes_nvs() {
         return;
     }
 
-    size_t enviados_con_exito = 0;
     for (size_t i = 0; i < count; i++) {
-        if (enviar_datos_http(&datos_pendientes[i])) {
-            ESP_LOGI(TAG, "Dato reenviado desde NVS: %s", claves_existentes[i]);
-            enviados_con_exito++;
-        } else {
-            ESP_LOGW(TAG, "Error reenviando dato desde NVS. Se intentará en el próximo ciclo.");
-        }
+        task_http_post_build_json(&datos_pendientes[i], json_pendientes[i], sizeof(json_pendientes[i]));
+        json_ptrs[i] = json_pendientes[i];
     }
 
+    size_t enviados_con_exito = http_client_post_batch(json_ptrs, count, resultados);
+    ESP_LOGI(TAG, "Reenviados %u de %u datos pendientes.", (unsigned int)enviados_con_exito, (unsigned int)count);
+
     // Solo eliminamos los datos que se reenviaron con éxito
-    for (size_t j = 0; j < enviados_con_exito; j++) {
+    for (size_t j = 0; j < count; j++) {
+        if (!resultados[j]) {
+            ESP_LOGW(TAG, "Error reenviando %s. Se intentará en el próximo ciclo.", claves_existentes[j]);
+            continue;
+        }
         esp_err_t err = nvs_delete_key(claves_existentes[j]);
         if (err == ESP_OK) {
             ESP_LOGI(TAG, "Eliminado registro de NVS: %s", claves_existentes[j]);
@@ -118,13 +138,14 @@ static bool conectar_wifi() {
     ESP_LOGI(TAG, "Conectando a Wi-Fi...");
     wifi_init();
 
-    for (int i = 0; i < WIFI_MAX_RETRIES; i++) {
+    const device_config_t *cfg = device_config_get();
+    for (int i = 0; i < cfg->wifi_max_retries; i++) {
         if (is_wifi_connected()) {
             ESP_LOGI(TAG, "Wi-Fi conectado.");
             return true;
         }
-        ESP_LOGW(TAG, "Esperando conexión Wi-Fi... (%d/%d)", i + 1, WIFI_MAX_RETRIES);
-        vTaskDelay(pdMS_TO_TICKS(RETRY_DELAY_MS));
+        ESP_LOGW(TAG, "Esperando conexión Wi-Fi... (%d/%d)", i + 1, cfg->wifi_max_retries);
+        vTaskDelay(pdMS_TO_TICKS(cfg->retry_delay_ms));
     }
 
     ESP_LOGE(TAG, "No se pudo conectar a Wi-Fi.");
@@ -151,7 +172,7 @@ static bool sincronizar_ntp(uint64_t *epoch_time, uint64_t timestamp_start) {
         }
 
         ESP_LOGW(TAG, "Esperando sincronización NTP... (%d/%d)", i + 1, NTP_MAX_RETRIES);
-        vTaskDelay(pdMS_TO_TICKS(RETRY_DELAY_MS));
+        vTaskDelay(pdMS_TO_TICKS(device_config_get()->retry_delay_ms));
     }
 
     ESP_LOGE(TAG, "No se pudo sincronizar NTP.");
@@ -163,7 +184,7 @@ static uint64_t calcular_tiempo_restante(uint64_t time_start) {
     uint64_t timestamp_end = esp_timer_get_time();
     uint64_t tiempo_transcurrido = (timestamp_end - time_start) / 1000;
 
-    int64_t tiempo_dormir = MEDICION_INTERVALO_MS - tiempo_transcurrido;
+    int64_t tiempo_dormir = device_config_get()->medicion_intervalo_ms - tiempo_transcurrido;
     if (tiempo_dormir < 0) tiempo_dormir = 0;
 
     ESP_LOGI(TAG, "Tiempo de ejecución: %llu ms, durmiendo por %llu ms.", 
@@ -179,22 +200,33 @@ void sensor_manager_init() {
 
     xTaskCreate(task_sensor_read, "task_sensor_read", 4096, NULL, 5, NULL);
     sensor_data_t data;
-    if (xQueueReceive(sensor_data_queue, &data, pdMS_TO_TICKS(5000)) != pdTRUE) {
+    // Una ráfaga de lecturas suma el intervalo mínimo del DHT22 por cada muestra extra
+    TickType_t espera_sensor = pdMS_TO_TICKS(5000 + (CONFIG_DHT22_BURST_SAMPLES - 1) * DHT22_MIN_INTERVAL_MS);
+    if (xQueueReceive(sensor_data_queue, &data, espera_sensor) != pdTRUE) {
         manejar_fallo("Timeout esperando datos del sensor");
     }
 
     if (!conectar_wifi()) manejar_fallo("No se pudo conectar a Wi-Fi");
 
+#if CONFIG_HTTP_POST_TLS_BENCHMARK > 0
+    http_client_tls_benchmark();
+#endif
+
+    // Normalmente 304: solo se descarga cuando el servidor publica una nueva versión
+    device_config_sync();
+
+    // Sin NTP se envía el timestamp relativo; el status de la lectura se conserva
     uint64_t time_start = data.timestamp;
-    if (!sincronizar_ntp(&data.timestamp, time_start)) {
-        data.status_code = 200;
-    }
+    sincronizar_ntp(&data.timestamp, time_start);
 
-    // Asignar status 300 si el dato debe ser almacenado
+    // Asignar status 300 si un dato válido debe ser almacenado; 100 y 400 se
+    // guardan tal cual para que el reenvío no los haga pasar por válidos
     bool envio_exitoso = enviar_datos_http(&data);
     if (!envio_exitoso) {
-        data.status_code = 300;
-        ESP_LOGW(TAG, "Guardando dato actual en NVS con status 300.");
+        if (data.status_code == 200) {
+            data.status_code = 300;
+        }
+        ESP_LOGW(TAG, "Guardando dato actual en NVS con status %d.", data.status_code);
         esp_err_t err = nvs_store_failed_data(&data);
         if (err != ESP_OK) {
             ESP_LOGW(TAG, "Error al guardar dato en NVS: %s", esp_err_to_name(err));
@@ -5,11 +5,8 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 
-#define DEVICE_ID "ESP32-001"
-static const int RETRY_DELAY_MS = 1000;
-static const int WIFI_MAX_RETRIES = 10;
+// DEVICE_ID, intervalos y reintentos se obtienen de device_config_get()
 static const int NTP_MAX_RETRIES = 5;
-static const uint64_t MEDICION_INTERVALO_MS = 60000; // 1 minuto (ajustable)
 
 typedef struct {
     uint64_t timestamp;  
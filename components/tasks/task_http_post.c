@@ -9,11 +9,30 @@
 #include "task_http_post.h"
 #include "http_client.h"
 #include "sensor_manager.h"
+#include "device_config.h"
 
 
 static const char *TAG = "TASK_HTTP_POST";
 
 
+int task_http_post_build_json(const sensor_data_t *data, char *buffer, size_t len) {
+    return snprintf(buffer, len, 
+         "{"
+         "\"device_id\": \"%s\", "
+         "\"timestamp\": %llu, "
+         "\"temperature\": %.2f, "
+         "\"humidity\": %.2f, "
+         "\"status_code\": %d"
+         "}", 
+         device_config_get()->device_id, 
+         data->timestamp, 
+         data->temperature, 
+         data->humidity, 
+         data->status_code
+    );
+}
+
+
 void task_http_post(void *pvParameters) {
 
     sensor_data_t data;
@@ -31,27 +50,15 @@ void task_http_post(void *pvParameters) {
 
     
     char json_data[256];
-    snprintf(json_data, sizeof(json_data), 
-         "{"
-         "\"device_id\": \"%s\", "
-         "\"timestamp\": %llu, "
-         "\"temperature\": %.2f, "
-         "\"humidity\": %.2f, "
-         "\"status_code\": %d"
-         "}", 
-         DEVICE_ID, 
-         data.timestamp, 
-         data.temperature, 
-         data.humidity, 
-         data.status_code
-    );
+    task_http_post_build_json(&data, json_data, sizeof(json_data));
 
 
     // **Reintentos de envío**
+    const device_config_t *cfg = device_config_get();
     bool success = false;
-    for (int i = 0; i < CONFIG_HTTP_POST_RETRIES; i++) {
+    for (int i = 0; i < cfg->http_retries; i++) {
         bool resultado_http = http_client_post(json_data);
-        ESP_LOGI(TAG, "Intento %d/%d - Resultado de http_client_post(): %d", i + 1, CONFIG_HTTP_POST_RETRIES, resultado_http);
+        ESP_LOGI(TAG, "Intento %d/%d - Resultado de http_client_post(): %d", i + 1, cfg->http_retries, resultado_http);
 
         if (resultado_http) {
             ESP_LOGI(TAG, "Datos enviados correctamente en intento %d.", i + 1);
@@ -61,8 +68,8 @@ void task_http_post(void *pvParameters) {
             success = false; 
         }
 
-        ESP_LOGW(TAG, "Error al enviar datos HTTP. Reintentando... (%d/%d)", i + 1, CONFIG_HTTP_POST_RETRIES);
-        vTaskDelay(pdMS_TO_TICKS(CONFIG_HTTP_POST_RETRY_DELAY));
+        ESP_LOGW(TAG, "Error al enviar datos HTTP. Reintentando... (%d/%d)", i + 1, cfg->http_retries);
+        vTaskDelay(pdMS_TO_TICKS(cfg->http_retry_delay_ms));
     }
 
     if (!success) {
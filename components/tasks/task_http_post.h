@@ -1,6 +1,12 @@
 #ifndef TASK_HTTP_POST_H
 #define TASK_HTTP_POST_H
 
+#include <stddef.h>
+#include "sensor_manager.h"
+
 void task_http_post(void *pvParameters);
 
+// Serializa un registro al JSON que espera el servidor
+int task_http_post_build_json(const sensor_data_t *data, char *buffer, size_t len);
+
 #endif // TASK_HTTP_POST_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "esp_system.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "sdkconfig.h"
 
 #include "dht22.h"
 #include "task_sensor.h"
@@ -11,7 +12,7 @@
 
 static const char *TAG = "TASK_SENSOR";
 static const int SENSOR_RETRY_COUNT = 3;
-static const int SENSOR_RETRY_DELAY_MS = 2000;
+static const int SENSOR_RETRY_DELAY_MS = DHT22_MIN_INTERVAL_MS;
 
 // **Tarea de lectura del sensor**
 void task_sensor_read(void *pvParameters) {
@@ -21,14 +22,23 @@ void task_sensor_read(void *pvParameters) {
 
     ESP_LOGI(TAG, "Iniciando lectura del sensor DHT22...");
     dht22_init();
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    if (dht22_settle_required()) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
 
     // Intentar leer el sensor con reintentos
     bool success = false;
     for (int i = 0; i < SENSOR_RETRY_COUNT; i++) {
-        if (dht22_read(&data.temperature, &data.humidity)) {
+        uint8_t confidence;
+        if (dht22_read_burst(CONFIG_DHT22_BURST_SAMPLES, &data.temperature, &data.humidity, &confidence)) {
             success = true;
             data.status_code = 200;
+#if CONFIG_DHT22_BURST_SAMPLES > 1
+            if (confidence < CONFIG_DHT22_MIN_CONFIDENCE) {
+                ESP_LOGW(TAG, "Ráfaga con baja confianza (%u%%), medición marcada como inválida.", confidence);
+                data.status_code = 400;
+            }
+#endif
             break;
         }
         ESP_LOGW(TAG, "Error al leer sensor DHT22. Reintentando... (%d/%d)", i + 1, SENSOR_RETRY_COUNT);